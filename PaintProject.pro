@@ -1,18 +1,58 @@
-QT       += core gui widgets printsupport
+QT       += core gui widgets printsupport concurrent svg
 CONFIG += c++17 utf8
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
 SOURCES += \
+    batchrenderer.cpp \
+    blend.cpp \
+    commandhistory.cpp \
+    compositor.cpp \
+    floodfill.cpp \
+    historycommand.cpp \
+    imageloader.cpp \
+    imagesaver.cpp \
+    inputreplayer.cpp \
+    inputtrace.cpp \
+    layerstack.cpp \
     main.cpp \
     mainwindow.cpp \
+    mipmap.cpp \
     paintarea.cpp \
-    shapes.cpp
+    profiler.cpp \
+    projectfile.cpp \
+    rtree.cpp \
+    scene.cpp \
+    shapefactory.cpp \
+    shapes.cpp \
+    tiledcanvas.cpp \
+    tilehistory.cpp \
+    vectorexporter.cpp
 
 HEADERS += \
+    batchrenderer.h \
+    blend.h \
+    commandhistory.h \
+    compositor.h \
+    floodfill.h \
+    historycommand.h \
+    imageloader.h \
+    imagesaver.h \
+    inputreplayer.h \
+    inputtrace.h \
+    layerstack.h \
     mainwindow.h \
+    mipmap.h \
     paintarea.h \
+    profiler.h \
+    projectfile.h \
+    rtree.h \
+    scene.h \
     shape.h \
-    shapes.h
+    shapefactory.h \
+    shapes.h \
+    tiledcanvas.h \
+    tilehistory.h \
+    vectorexporter.h
 
 
 # Default rules for deployment.
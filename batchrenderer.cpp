@@ -0,0 +1,279 @@
+#include "batchrenderer.h"
+#include "compositor.h"
+#include "imagesaver.h"
+#include "paintarea.h"
+#include "shapes.h"
+#include "shapefactory.h"
+#include "tiledcanvas.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+namespace {
+
+/**
+ * @brief 形状名称与DrawShape的对应关系
+ */
+struct ShapeName {
+    const char *name;
+    PaintArea::DrawShape type;
+};
+
+const ShapeName shapeNames[] = {
+    {"freehand", PaintArea::Freehand},
+    {"line", PaintArea::Line},
+    {"rectangle", PaintArea::Rectangle},
+    {"ellipse", PaintArea::Ellipse},
+    {"arrow", PaintArea::Arrow},
+    {"star", PaintArea::Star},
+    {"diamond", PaintArea::Diamond},
+    {"heart", PaintArea::Heart},
+    {"eraser", PaintArea::Eraser},
+};
+
+const QSize DefaultCanvasSize(800, 600);  // 没有底图且脚本未指定尺寸时的画布尺寸
+const int DefaultPenWidth = 3;  // 脚本未指定时的画笔宽度
+
+} // namespace
+
+// 构造函数
+BatchRenderer::BatchRenderer(const Options &options)
+    : options(options) {}
+
+// 并行渲染所有脚本并报告吞吐量
+int BatchRenderer::run(const QStringList &scripts) const
+{
+    if (options.threads > 0) {
+        QThreadPool::globalInstance()->setMaxThreadCount(options.threads);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // 每个脚本一个任务；脚本内的合成同样使用线程池，调用线程参与执行，不会死锁
+    const QString outputDir = options.outputDir;
+    QStringList errors = QtConcurrent::blockingMapped(scripts, [outputDir](const QString &script) {
+        return renderScript(script, outputDir);
+    });
+
+    double seconds = timer.nsecsElapsed() / 1e9;
+    int failed = 0;
+    QTextStream err(stderr);
+    for (int i = 0; i < errors.size(); ++i) {
+        if (errors[i].isEmpty()) continue;
+        err << scripts[i] << ": " << errors[i] << Qt::endl;
+        ++failed;
+    }
+
+    int rendered = scripts.size() - failed;
+    QTextStream out(stdout);
+    out << QString("已渲染 %1/%2 张图像，用时 %3 秒，%4 张/秒")
+               .arg(rendered)
+               .arg(scripts.size())
+               .arg(seconds, 0, 'f', 3)
+               .arg(seconds > 0 ? rendered / seconds : 0.0, 0, 'f', 1)
+        << Qt::endl;
+    return failed == 0 ? 0 : 1;
+}
+
+// 渲染单个脚本：解析、绘制到分块画布、与底图合成并写出
+QString BatchRenderer::renderScript(const QString &scriptFile, const QString &outputDir)
+{
+    QFile file(scriptFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QString("无法读取脚本: %1").arg(file.errorString());
+    }
+
+    QFileInfo info(scriptFile);
+    Script script;
+    script.size = DefaultCanvasSize;
+    QString error;
+    bool parsed = info.suffix().compare("json", Qt::CaseInsensitive) == 0 ?
+                      parseJson(file.readAll(), script, error) :
+                      parseText(file.readAll(), script, error);
+    if (!parsed) return error;
+
+    // 底图和输出文件的相对路径都相对于脚本所在目录
+    QDir scriptDir = info.absoluteDir();
+    QImage background;
+    if (!script.base.isEmpty()) {
+        QImageReader reader(scriptDir.filePath(script.base));
+        reader.setAutoTransform(true);
+        background = reader.read();
+        if (background.isNull()) {
+            return QString("无法加载底图 %1: %2").arg(script.base, reader.errorString());
+        }
+        background = background.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    }
+
+    TiledCanvas canvas(background.isNull() ? script.size : background.size());
+    for (const ShapeSpec &spec : script.shapes) {
+        ShapeHandle shape = PaintArea::createShape(static_cast<PaintArea::DrawShape>(spec.type),
+                                                   spec.points.first(), spec.color, spec.width);
+        if (!shape) continue;
+
+        // 与鼠标拖动相同：每个点依次作为形状的更新点
+        for (const QPoint &point : spec.points) {
+            shape->update(point);
+        }
+        const Shape *drawn = shape.get();
+        canvas.paint(shape->paintRect(), [drawn](QPainter &painter, const QRect &) {
+            drawn->draw(painter);
+        });
+    }
+
+    QString output = script.output;
+    if (output.isEmpty()) {
+        QDir dir = outputDir.isEmpty() ? scriptDir : QDir(outputDir);
+        output = dir.filePath(info.completeBaseName() + ".png");
+    } else {
+        output = scriptDir.filePath(output);
+    }
+
+    // 只有带透明通道的背景保存为PNG时保留透明，其余合成到白色上，与界面保存的结果一致
+    QByteArray format = ImageSaver::formatForFile(output);
+    bool hasAlpha = format == "png" && !background.isNull() && background.hasAlphaChannel();
+    QImage result = Compositor::composite(background, canvas, hasAlpha ? Qt::transparent : Qt::white);
+    if (!hasAlpha) {
+        result = result.convertToFormat(QImage::Format_RGB32);
+    }
+
+    QImageWriter writer(output, format);
+    if (!writer.write(result)) {
+        return QString("无法写入 %1: %2").arg(output, writer.errorString());
+    }
+    return QString();
+}
+
+// 解析JSON脚本
+bool BatchRenderer::parseJson(const QByteArray &data, Script &script, QString &error)
+{
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(data, &parseError);
+    if (!document.isObject()) {
+        error = QString("JSON格式错误: %1").arg(parseError.errorString());
+        return false;
+    }
+
+    QJsonObject root = document.object();
+    script.size = QSize(root.value("width").toInt(script.size.width()),
+                        root.value("height").toInt(script.size.height()));
+    script.base = root.value("base").toString();
+    script.output = root.value("output").toString();
+
+    const QJsonArray shapes = root.value("shapes").toArray();
+    for (int i = 0; i < shapes.size(); ++i) {
+        QJsonObject object = shapes[i].toObject();
+        ShapeSpec spec;
+
+        QJsonValue typeValue = object.value("type");
+        spec.type = typeValue.isDouble() ? shapeType(QString::number(typeValue.toInt())) :
+                                           shapeType(typeValue.toString());
+        if (spec.type < 0) {
+            error = QString("第%1个形状的类型无效").arg(i + 1);
+            return false;
+        }
+
+        spec.color = QColor(object.value("color").toString("#000000"));
+        if (!spec.color.isValid()) {
+            error = QString("第%1个形状的颜色无效").arg(i + 1);
+            return false;
+        }
+        spec.width = object.value("width").toInt(DefaultPenWidth);
+
+        const QJsonArray points = object.value("points").toArray();
+        for (const QJsonValue &value : points) {
+            QJsonArray point = value.toArray();
+            if (point.size() != 2) {
+                error = QString("第%1个形状的点格式无效").arg(i + 1);
+                return false;
+            }
+            spec.points.append(QPoint(point[0].toInt(), point[1].toInt()));
+        }
+        if (spec.points.isEmpty()) {
+            error = QString("第%1个形状没有点").arg(i + 1);
+            return false;
+        }
+        script.shapes.append(spec);
+    }
+    return true;
+}
+
+// 解析文本脚本
+bool BatchRenderer::parseText(const QByteArray &data, Script &script, QString &error)
+{
+    static const QRegularExpression whitespace("\\s+");
+    const QStringList lines = QString::fromUtf8(data).split('\n');
+    for (int i = 0; i < lines.size(); ++i) {
+        QString line = lines[i].trimmed();
+        if (line.isEmpty() || line.startsWith('#')) continue;
+
+        QStringList tokens = line.split(whitespace, Qt::SkipEmptyParts);
+        QString keyword = tokens.first().toLower();
+        if (keyword == "size" && tokens.size() == 3) {
+            script.size = QSize(tokens[1].toInt(), tokens[2].toInt());
+            continue;
+        }
+        if (keyword == "base" || keyword == "output") {
+            // 路径可能包含空格，取关键字之后的整行
+            QString path = line.mid(keyword.size()).trimmed();
+            (keyword == "base" ? script.base : script.output) = path;
+            continue;
+        }
+
+        // 形状：类型 颜色 宽度 x,y x,y ...
+        ShapeSpec spec;
+        spec.type = shapeType(tokens.first());
+        if (spec.type < 0 || tokens.size() < 4) {
+            error = QString("第%1行: 无法识别的指令").arg(i + 1);
+            return false;
+        }
+        spec.color = QColor(tokens[1]);
+        bool widthOk = false;
+        spec.width = tokens[2].toInt(&widthOk);
+        if (!spec.color.isValid() || !widthOk) {
+            error = QString("第%1行: 颜色或宽度无效").arg(i + 1);
+            return false;
+        }
+        for (int t = 3; t < tokens.size(); ++t) {
+            QStringList xy = tokens[t].split(',');
+            bool xOk = false;
+            bool yOk = false;
+            if (xy.size() == 2) {
+                spec.points.append(QPoint(xy[0].toInt(&xOk), xy[1].toInt(&yOk)));
+            }
+            if (!xOk || !yOk) {
+                error = QString("第%1行: 点格式无效 %2").arg(i + 1).arg(tokens[t]);
+                return false;
+            }
+        }
+        script.shapes.append(spec);
+    }
+    return true;
+}
+
+// 形状名称或数值转为DrawShape，编组选择等无效值返回-1
+int BatchRenderer::shapeType(const QString &name)
+{
+    bool isNumber = false;
+    int value = name.toInt(&isNumber);
+    if (isNumber) {
+        return value >= PaintArea::Freehand && value <= PaintArea::Eraser ? value : -1;
+    }
+
+    QString lower = name.toLower();
+    for (const ShapeName &entry : shapeNames) {
+        if (lower == QLatin1String(entry.name)) return entry.type;
+    }
+    return -1;
+}
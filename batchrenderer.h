@@ -0,0 +1,93 @@
+#ifndef BATCHRENDERER_H
+#define BATCHRENDERER_H
+
+#include <QColor>
+#include <QPoint>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @brief 无界面批量渲染
+ *
+ * 读取形状脚本，用现有的形状类绘制到可选的底图上并写出结果，不创建任何窗口，
+ * 可以在offscreen平台下运行。多个脚本在线程池中并行渲染，结束后报告吞吐量。
+ *
+ * 脚本支持两种格式，扩展名为.json时按JSON解析：
+ * @code
+ * {
+ *   "width": 800, "height": 600,        // 没有底图时的画布尺寸
+ *   "base": "photo.jpg",                // 可选的底图(相对于脚本所在目录)
+ *   "output": "result.png",             // 可选的输出文件
+ *   "shapes": [
+ *     {"type": "Rectangle", "points": [[10, 10], [200, 120]], "color": "#ff0000", "width": 3}
+ *   ]
+ * }
+ * @endcode
+ * 其他扩展名按文本解析，每行一条指令，#开头为注释：
+ * @code
+ * size 800 600
+ * base photo.jpg
+ * output result.png
+ * Rectangle #ff0000 3 10,10 200,120
+ * @endcode
+ * 形状类型使用PaintArea::DrawShape的名称(不区分大小写)或数值，
+ * 第一个点为起点，之后依次作为形状的更新点。
+ */
+class BatchRenderer {
+public:
+    /**
+     * @brief 批量渲染选项
+     */
+    struct Options {
+        QString outputDir;  // 脚本未指定输出文件时的输出目录(为空时与脚本同目录)
+        int threads = 0;    // 并行线程数(0为CPU核心数)
+    };
+
+    explicit BatchRenderer(const Options &options);
+
+    /**
+     * @brief 并行渲染所有脚本，并在标准输出报告每秒图像数
+     * @param scripts 脚本文件列表
+     * @return 进程退出码，全部成功时为0
+     */
+    int run(const QStringList &scripts) const;
+
+    /**
+     * @brief 渲染单个脚本
+     * @param scriptFile 脚本文件
+     * @param outputDir 默认输出目录
+     * @return 错误信息，成功时为空
+     */
+    static QString renderScript(const QString &scriptFile, const QString &outputDir);
+
+private:
+    /**
+     * @brief 脚本中的一个形状
+     */
+    struct ShapeSpec {
+        int type;  // PaintArea::DrawShape
+        QVector<QPoint> points;  // 起点和之后的更新点
+        QColor color;  // 画笔颜色
+        int width;  // 画笔宽度
+    };
+
+    /**
+     * @brief 解析后的脚本
+     */
+    struct Script {
+        QSize size;  // 画布尺寸
+        QString base;  // 底图文件
+        QString output;  // 输出文件
+        QVector<ShapeSpec> shapes;  // 形状列表
+    };
+
+    static bool parseJson(const QByteArray &data, Script &script, QString &error);  // 解析JSON脚本
+    static bool parseText(const QByteArray &data, Script &script, QString &error);  // 解析文本脚本
+    static int shapeType(const QString &name);  // 形状名称或数值转为DrawShape，无效时返回-1
+
+    Options options;  // 渲染选项
+};
+
+#endif // BATCHRENDERER_H
@@ -0,0 +1,68 @@
+QT       += core gui widgets concurrent svg testlib
+CONFIG += c++17 utf8 console
+CONFIG -= app_bundle
+
+TEMPLATE = app
+TARGET = benchmark
+
+# 被测代码直接使用主工程的源文件
+INCLUDEPATH += ..
+
+SOURCES += \
+    ../blend.cpp \
+    ../commandhistory.cpp \
+    ../compositor.cpp \
+    ../floodfill.cpp \
+    ../historycommand.cpp \
+    ../imageloader.cpp \
+    ../imagesaver.cpp \
+    ../inputtrace.cpp \
+    ../layerstack.cpp \
+    ../mipmap.cpp \
+    ../paintarea.cpp \
+    ../profiler.cpp \
+    ../projectfile.cpp \
+    ../rtree.cpp \
+    ../scene.cpp \
+    ../shapefactory.cpp \
+    ../shapes.cpp \
+    ../tiledcanvas.cpp \
+    ../tilehistory.cpp \
+    ../vectorexporter.cpp \
+    benchmarkutil.cpp \
+    blendbenchmark.cpp \
+    canvasbenchmark.cpp \
+    fillbenchmark.cpp \
+    historybenchmark.cpp \
+    layerbenchmark.cpp \
+    main.cpp \
+    shapebenchmark.cpp
+
+HEADERS += \
+    ../blend.h \
+    ../commandhistory.h \
+    ../compositor.h \
+    ../floodfill.h \
+    ../historycommand.h \
+    ../imageloader.h \
+    ../imagesaver.h \
+    ../inputtrace.h \
+    ../layerstack.h \
+    ../mipmap.h \
+    ../paintarea.h \
+    ../profiler.h \
+    ../projectfile.h \
+    ../rtree.h \
+    ../scene.h \
+    ../shapefactory.h \
+    ../shapes.h \
+    ../tiledcanvas.h \
+    ../tilehistory.h \
+    ../vectorexporter.h \
+    benchmarkutil.h \
+    blendbenchmark.h \
+    canvasbenchmark.h \
+    fillbenchmark.h \
+    historybenchmark.h \
+    layerbenchmark.h \
+    shapebenchmark.h
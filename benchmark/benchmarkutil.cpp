@@ -0,0 +1,13 @@
+#include "benchmarkutil.h"
+#include "paintarea.h"
+#include <QCoreApplication>
+#include <QResizeEvent>
+
+// 调整控件大小并直接发送一次大小改变事件
+void resizeArea(PaintArea &area, const QSize &size)
+{
+    QSize oldSize = area.size();
+    area.resize(size);
+    QResizeEvent event(size, oldSize);
+    QCoreApplication::sendEvent(&area, &event);
+}
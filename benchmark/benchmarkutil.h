@@ -0,0 +1,17 @@
+#ifndef BENCHMARKUTIL_H
+#define BENCHMARKUTIL_H
+
+#include <QSize>
+
+class PaintArea;
+
+/**
+ * @brief 调整未显示的绘图区域的大小，并立即发送大小改变事件
+ * @param area 绘图区域
+ * @param size 新的控件尺寸
+ *
+ * 未显示的控件要到显示或渲染时才收到大小改变事件，这里直接发送一次使画布与控件等大。
+ */
+void resizeArea(PaintArea &area, const QSize &size);
+
+#endif // BENCHMARKUTIL_H
@@ -0,0 +1,103 @@
+#include "blendbenchmark.h"
+#include <QtTest>
+#include <QPainter>
+#include <QRandomGenerator>
+
+// 4K和8K帧，每种帧分别测试QPainter和所有内核(-1表示QPainter)
+void BlendBenchmark::sourceOver_data()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<int>("kernel");
+
+    const QList<QPair<QString, QSize>> sizes = {
+        {"4K", QSize(3840, 2160)},
+        {"8K", QSize(7680, 4320)},
+    };
+    for (const auto &size : sizes) {
+        QTest::newRow(qPrintable(size.first + "/QPainter")) << size.second << -1;
+        for (int kernel = Blend::Scalar; kernel < Blend::KernelCount; ++kernel) {
+            QString name = size.first + "/" + Blend::name(static_cast<Blend::Kernel>(kernel));
+            QTest::newRow(qPrintable(name)) << size.second << kernel;
+        }
+    }
+}
+
+// 把绘制层混合到背景上
+void BlendBenchmark::sourceOver()
+{
+    QFETCH(QSize, size);
+    QFETCH(int, kernel);
+
+    QImage background;
+    QImage layer;
+    frames(size, background, layer);
+
+    if (kernel < 0) {
+        QImage target = background.copy();
+        QBENCHMARK {
+            QPainter painter(&target);
+            painter.drawImage(0, 0, layer);
+        }
+        return;
+    }
+
+    Blend::SourceOverFunc func = Blend::function(static_cast<Blend::Kernel>(kernel));
+    if (!func) {
+        QSKIP("当前CPU不支持该内核");
+    }
+
+    // 先确认结果与QPainter逐字节一致
+    QImage expected = background.copy();
+    {
+        QPainter painter(&expected);
+        painter.drawImage(0, 0, layer);
+    }
+    QImage result = background.copy();
+    blendWith(func, result, layer);
+    QCOMPARE(result, expected);
+
+    QImage target = background.copy();
+    QBENCHMARK {
+        blendWith(func, target, layer);
+    }
+}
+
+// 生成测试帧：不透明的渐变背景，以及约含两百条半透明抗锯齿笔画的透明绘制层
+void BlendBenchmark::frames(const QSize &size, QImage &background, QImage &layer)
+{
+    if (!cache.contains(size.width())) {
+        QImage bg(size, QImage::Format_ARGB32_Premultiplied);
+        QLinearGradient gradient(0, 0, size.width(), size.height());
+        gradient.setColorAt(0, QColor(40, 90, 160));
+        gradient.setColorAt(1, QColor(230, 200, 120));
+        QPainter(&bg).fillRect(bg.rect(), gradient);
+
+        QImage fg(size, QImage::Format_ARGB32_Premultiplied);
+        fg.fill(Qt::transparent);
+        QPainter painter(&fg);
+        painter.setRenderHint(QPainter::Antialiasing);
+        QRandomGenerator random(42);
+        for (int i = 0; i < 200; ++i) {
+            QColor color(random.bounded(256), random.bounded(256), random.bounded(256),
+                         random.bounded(2) ? 255 : random.bounded(40, 255));
+            painter.setPen(QPen(color, random.bounded(2, 24), Qt::SolidLine, Qt::RoundCap));
+            painter.drawLine(random.bounded(size.width()), random.bounded(size.height()),
+                             random.bounded(size.width()), random.bounded(size.height()));
+        }
+        painter.end();
+
+        cache.insert(size.width(), qMakePair(bg, fg));
+    }
+
+    background = cache.value(size.width()).first;
+    layer = cache.value(size.width()).second;
+}
+
+// 逐行调用内核
+void BlendBenchmark::blendWith(Blend::SourceOverFunc func, QImage &target, const QImage &layer)
+{
+    for (int y = 0; y < target.height(); ++y) {
+        func(reinterpret_cast<quint32 *>(target.scanLine(y)),
+             reinterpret_cast<const quint32 *>(layer.constScanLine(y)), target.width());
+    }
+}
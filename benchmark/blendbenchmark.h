@@ -0,0 +1,31 @@
+#ifndef BLENDBENCHMARK_H
+#define BLENDBENCHMARK_H
+
+#include <QObject>
+#include <QImage>
+#include <QMap>
+#include <QPair>
+#include "blend.h"
+
+/**
+ * @brief 源覆盖混合基准：比较QPainter::drawImage与各SIMD内核
+ *
+ * 绘制层大部分透明，只有随机的抗锯齿笔画，与实际使用时的分布接近。
+ * 每个内核在计时前先与QPainter的结果逐字节比较。
+ */
+class BlendBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void sourceOver_data();  // 帧尺寸 × 实现
+    void sourceOver();  // 把绘制层混合到背景上
+
+private:
+    void frames(const QSize &size, QImage &background, QImage &layer);  // 生成(并缓存)测试帧
+    static void blendWith(Blend::SourceOverFunc func, QImage &target, const QImage &layer);  // 逐行调用内核
+
+    QMap<int, QPair<QImage, QImage>> cache;  // 按宽度缓存的背景和绘制层
+};
+
+#endif // BLENDBENCHMARK_H
@@ -0,0 +1,266 @@
+#include "canvasbenchmark.h"
+#include "benchmarkutil.h"
+#include "paintarea.h"
+#include "projectfile.h"
+#include <QtTest>
+#include <QMouseEvent>
+#include <QSignalSpy>
+#include <QSvgRenderer>
+
+namespace {
+
+const int WaitTimeout = 120000;  // 等待后台保存/加载完成的最长时间(毫秒)
+const int RectangleCount = 20;  // drawShapes()绘制的矩形数，之后还有一条自由绘制的笔画
+const QColor StrokeColor(255, 0, 0);  // 自由绘制笔画的颜色(矩形为黑色)，用于在导出结果中找到笔画
+
+// 画布尺寸
+void addSizeRows()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::newRow("800x600") << QSize(800, 600);
+    QTest::newRow("1920x1080") << QSize(1920, 1080);
+    QTest::newRow("3840x2160") << QSize(3840, 2160);
+}
+
+// 直接向控件发送鼠标事件，与用户拖动时PaintArea收到的事件相同
+void sendMouse(QWidget *widget, QEvent::Type type, const QPoint &pos)
+{
+    Qt::MouseButton button = type == QEvent::MouseMove ? Qt::NoButton : Qt::LeftButton;
+    Qt::MouseButtons buttons = type == QEvent::MouseButtonRelease ? Qt::NoButton : Qt::LeftButton;
+    QMouseEvent event(type, pos, widget->mapToGlobal(pos), button, buttons, Qt::NoModifier);
+    QCoreApplication::sendEvent(widget, &event);
+}
+
+// 图像中是否有接近笔画颜色的像素
+bool containsStroke(const QImage &image)
+{
+    for (int y = 0; y < image.height(); ++y) {
+        const QRgb *line = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            if (qRed(line[x]) > 200 && qGreen(line[x]) < 60 && qBlue(line[x]) < 60) return true;
+        }
+    }
+    return false;
+}
+
+// 带渐变的图像，避免PNG压缩率过高而失去代表性
+QImage gradientImage(const QSize &size)
+{
+    QImage image(size, QImage::Format_RGB32);
+    QLinearGradient gradient(0, 0, size.width(), size.height());
+    gradient.setColorAt(0, QColor(30, 60, 120));
+    gradient.setColorAt(1, QColor(240, 210, 150));
+    QPainter(&image).fillRect(image.rect(), gradient);
+    return image;
+}
+
+} // namespace
+
+// 画布尺寸
+void CanvasBenchmark::paintEvent_data()
+{
+    addSizeRows();
+}
+
+// 完整重绘一次：render()按整个控件区域调用paintEvent
+void CanvasBenchmark::paintEvent()
+{
+    QFETCH(QSize, size);
+
+    PaintArea area;
+    resizeArea(area, size);
+    drawShapes(area);
+
+    QImage target(size, QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        area.render(&target);
+    }
+}
+
+// 画布尺寸 × 缩放比例：窗口固定为1280x800，帧耗时应只与窗口大小有关
+void CanvasBenchmark::zoomedPaint_data()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<double>("zoom");
+
+    const QList<QPair<QString, QSize>> sizes = {
+        {"3840x2160", QSize(3840, 2160)},
+        {"8192x8192", QSize(8192, 8192)},
+    };
+    for (const auto &size : sizes) {
+        for (double zoom : {0.05, 0.25, 1.0, 8.0}) {
+            QTest::newRow(qPrintable(QString("%1/%2%").arg(size.first).arg(zoom * 100)))
+                << size.second << zoom;
+        }
+    }
+}
+
+// 以背景打开画布并绘制形状，缩放后每次迭代平移一步再完整重绘
+void CanvasBenchmark::zoomedPaint()
+{
+    QFETCH(QSize, size);
+    QFETCH(double, zoom);
+
+    QString fileName = tempDir.filePath(QString("zoom_%1x%2.ppd").arg(size.width()).arg(size.height()));
+    if (!QFile::exists(fileName)) {
+        QCOMPARE(ProjectFile::write(fileName, gradientImage(size), TiledCanvas(size),
+                                    ProjectFile::encodeShapes({})),
+                 QString());
+    }
+
+    const QSize viewport(1280, 800);
+    PaintArea area;
+    resizeArea(area, viewport);
+    QSignalSpy finished(&area, &PaintArea::loadFinished);
+    QVERIFY(area.loadImage(fileName));
+    QVERIFY(finished.wait(WaitTimeout));
+    drawShapes(area);
+    area.setZoom(zoom, QRect(QPoint(0, 0), viewport).center());
+
+    QImage target(viewport, QImage::Format_ARGB32_Premultiplied);
+    area.render(&target);  // 预热：生成缩小层级
+    int step = 0;
+    QBENCHMARK {
+        area.panBy(QPoint((step++ % 2) ? 16 : -16, 0));
+        area.render(&target);
+    }
+}
+
+// 画布尺寸 × 格式
+void CanvasBenchmark::saveImage_data()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<QString>("suffix");
+
+    const QList<QPair<QString, QSize>> sizes = {
+        {"800x600", QSize(800, 600)},
+        {"1920x1080", QSize(1920, 1080)},
+        {"3840x2160", QSize(3840, 2160)},
+    };
+    for (const auto &size : sizes) {
+        for (const QString suffix : {"png", "jpg", "ppd", "svg", "pdf"}) {
+            QTest::newRow(qPrintable(size.first + "/" + suffix)) << size.second << suffix;
+        }
+    }
+}
+
+// 保存并等待后台任务完成
+void CanvasBenchmark::saveImage()
+{
+    QFETCH(QSize, size);
+    QFETCH(QString, suffix);
+
+    PaintArea area;
+    resizeArea(area, size);
+    drawShapes(area);
+
+    QString fileName = tempDir.filePath("save." + suffix);
+    QSignalSpy finished(&area, &PaintArea::saveFinished);
+    QBENCHMARK {
+        QVERIFY(area.saveImage(fileName));
+        QVERIFY(finished.wait(WaitTimeout));
+        QVERIFY(finished.takeFirst().at(0).toBool());
+    }
+
+    // 工程文件应包含所有形状，自由绘制的笔画重新打开后也要能读出
+    if (suffix == ProjectFile::Suffix) {
+        ProjectFile project;
+        QVERIFY(project.open(fileName));
+        QVector<Scene::Item> items;
+        QVERIFY(ProjectFile::decodeShapes(project.shapes(), items));
+        QCOMPARE(items.size(), RectangleCount + 1);
+        for (int i = 0; i < RectangleCount; ++i) {
+            QCOMPARE(items[i].second->type(), int(PaintArea::Rectangle));
+        }
+        QCOMPARE(items.last().second->type(), int(PaintArea::Freehand));
+    }
+
+    // 矢量导出应包含自由绘制的笔画：SVG渲染后能找到笔画颜色；PDF的内容流是压缩的，
+    // 改为撤销笔画后再导出一次，去掉笔画的路径后文件应变小
+    if (suffix == "svg") {
+        QSvgRenderer renderer(fileName);
+        QVERIFY(renderer.isValid());
+        QImage rendered(size, QImage::Format_RGB32);
+        rendered.fill(Qt::white);
+        QPainter painter(&rendered);
+        renderer.render(&painter);
+        painter.end();
+        QVERIFY(containsStroke(rendered));
+    } else if (suffix == "pdf") {
+        area.undo();
+        QString undoneName = tempDir.filePath("save_undone.pdf");
+        QVERIFY(area.saveImage(undoneName));
+        QVERIFY(finished.wait(WaitTimeout));
+        QVERIFY(finished.takeFirst().at(0).toBool());
+        QVERIFY(QFileInfo(undoneName).size() < QFileInfo(fileName).size());
+    }
+}
+
+// 图像尺寸 × 格式
+void CanvasBenchmark::loadImage_data()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<QString>("suffix");
+
+    const QList<QPair<QString, QSize>> sizes = {
+        {"800x600", QSize(800, 600)},
+        {"1920x1080", QSize(1920, 1080)},
+        {"3840x2160", QSize(3840, 2160)},
+    };
+    for (const auto &size : sizes) {
+        for (const QString suffix : {"png", "ppd"}) {
+            QTest::newRow(qPrintable(size.first + "/" + suffix)) << size.second << suffix;
+        }
+    }
+}
+
+// 加载并等待后台解码完成
+void CanvasBenchmark::loadImage()
+{
+    QFETCH(QSize, size);
+    QFETCH(QString, suffix);
+
+    // 准备一张带渐变的图像；工程文件以它为背景
+    QString fileName = tempDir.filePath(QString("load_%1x%2.%3").arg(size.width()).arg(size.height()).arg(suffix));
+    if (!QFile::exists(fileName)) {
+        QImage image = gradientImage(size);
+        if (ProjectFile::isProjectFile(fileName)) {
+            QCOMPARE(ProjectFile::write(fileName, image, TiledCanvas(size), ProjectFile::encodeShapes({})),
+                     QString());
+        } else {
+            QVERIFY(image.save(fileName));
+        }
+    }
+
+    PaintArea area;
+    resizeArea(area, QSize(800, 600));
+    QSignalSpy finished(&area, &PaintArea::loadFinished);
+    QBENCHMARK {
+        QVERIFY(area.loadImage(fileName));
+        QVERIFY(finished.wait(WaitTimeout));
+        QVERIFY(finished.takeFirst().at(0).toBool());
+    }
+}
+
+// 用鼠标事件在画布上绘制若干矩形和自由曲线，经过与交互相同的提交路径
+void CanvasBenchmark::drawShapes(PaintArea &area)
+{
+    const QSize size = area.size();
+    area.setDrawShape(PaintArea::Rectangle);
+    for (int i = 0; i < RectangleCount; ++i) {
+        QPoint start((i * 97) % qMax(1, size.width() - 150), (i * 61) % qMax(1, size.height() - 150));
+        sendMouse(&area, QEvent::MouseButtonPress, start);
+        sendMouse(&area, QEvent::MouseMove, start + QPoint(140, 100));
+        sendMouse(&area, QEvent::MouseButtonRelease, start + QPoint(140, 100));
+    }
+
+    area.setDrawShape(PaintArea::Freehand);
+    area.setPenColor(StrokeColor);
+    QPoint point(size.width() / 4, size.height() / 2);
+    sendMouse(&area, QEvent::MouseButtonPress, point);
+    for (int i = 0; i < 200; ++i) {
+        point += QPoint(2, (i % 20 < 10) ? 3 : -3);
+        sendMouse(&area, QEvent::MouseMove, point);
+    }
+    sendMouse(&area, QEvent::MouseButtonRelease, point);
+}
@@ -0,0 +1,32 @@
+#ifndef CANVASBENCHMARK_H
+#define CANVASBENCHMARK_H
+
+#include <QObject>
+#include <QTemporaryDir>
+
+class PaintArea;
+
+/**
+ * @brief 画布基准：offscreen下的完整重绘(含不同缩放比例下的平移)，以及后台保存和加载的端到端耗时
+ */
+class CanvasBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void paintEvent_data();  // 画布尺寸
+    void paintEvent();  // 完整重绘一次
+    void zoomedPaint_data();  // 画布尺寸 × 缩放比例
+    void zoomedPaint();  // 平移一步并完整重绘
+    void saveImage_data();  // 画布尺寸 × 格式(含工程文件和SVG/PDF)
+    void saveImage();  // 保存并等待完成
+    void loadImage_data();  // 图像尺寸 × 格式(PNG或工程文件)
+    void loadImage();  // 加载并等待完成
+
+private:
+    static void drawShapes(PaintArea &area);  // 用鼠标事件在画布上绘制若干形状
+
+    QTemporaryDir tempDir;  // 保存和加载使用的临时目录
+};
+
+#endif // CANVASBENCHMARK_H
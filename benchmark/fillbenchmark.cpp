@@ -0,0 +1,157 @@
+#include "fillbenchmark.h"
+#include "benchmarkutil.h"
+#include "floodfill.h"
+#include "paintarea.h"
+#include <QtTest>
+#include <QMouseEvent>
+#include <QPainter>
+
+namespace {
+
+const int RectangleCount = 5;  // boxSelect()中填充之前绘制的矩形数
+
+// 画布尺寸
+const QList<QPair<QString, QSize>> Sizes = {
+    {"1920x1080", QSize(1920, 1080)},
+    {"3840x2160", QSize(3840, 2160)},
+    {"7680x4320", QSize(7680, 4320)},
+};
+
+// 背景图案：空白，或每隔32像素一道竖墙、缺口交替在顶部和底部的蛇形通道
+QImage patternImage(const QSize &size, bool serpentine)
+{
+    QImage image(size, QImage::Format_RGB32);
+    image.fill(Qt::white);
+    if (serpentine) {
+        QPainter painter(&image);
+        for (int x = 32, i = 0; x < size.width(); x += 32, ++i) {
+            int gap = 16;
+            painter.fillRect(QRect(x, (i % 2) ? 0 : gap, 2, size.height() - gap), Qt::black);
+        }
+    }
+    return image;
+}
+
+// 在指定位置单击左键
+void click(QWidget *widget, const QPoint &pos)
+{
+    QMouseEvent press(QEvent::MouseButtonPress, pos, widget->mapToGlobal(pos),
+                      Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+    QCoreApplication::sendEvent(widget, &press);
+    QMouseEvent release(QEvent::MouseButtonRelease, pos, widget->mapToGlobal(pos),
+                        Qt::LeftButton, Qt::NoButton, Qt::NoModifier);
+    QCoreApplication::sendEvent(widget, &release);
+}
+
+// 按下左键从from拖动到to再释放
+void drag(QWidget *widget, const QPoint &from, const QPoint &to)
+{
+    QMouseEvent press(QEvent::MouseButtonPress, from, widget->mapToGlobal(from),
+                      Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+    QCoreApplication::sendEvent(widget, &press);
+    QMouseEvent move(QEvent::MouseMove, to, widget->mapToGlobal(to),
+                     Qt::NoButton, Qt::LeftButton, Qt::NoModifier);
+    QCoreApplication::sendEvent(widget, &move);
+    QMouseEvent release(QEvent::MouseButtonRelease, to, widget->mapToGlobal(to),
+                        Qt::LeftButton, Qt::NoButton, Qt::NoModifier);
+    QCoreApplication::sendEvent(widget, &release);
+}
+
+} // namespace
+
+// 画布尺寸 × 图案
+void FillBenchmark::floodFill_data()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<bool>("serpentine");
+
+    for (const auto &size : Sizes) {
+        QTest::newRow(qPrintable(size.first + "/blank")) << size.second << false;
+        QTest::newRow(qPrintable(size.first + "/serpentine")) << size.second << true;
+    }
+}
+
+// 从画布中心计算一次填充区域
+void FillBenchmark::floodFill()
+{
+    QFETCH(QSize, size);
+    QFETCH(bool, serpentine);
+
+    QImage background = patternImage(size, serpentine);
+    TiledCanvas drawing(size);
+    QPoint seed(size.width() / 2 + 8, size.height() / 2);  // 避开竖墙
+
+    QVector<QRect> region;
+    QBENCHMARK {
+        region = FloodFill::fill(background, drawing, seed, 32);
+    }
+
+    // 区域应覆盖所有白色像素
+    qint64 area = 0;
+    for (const QRect &rect : std::as_const(region)) {
+        area += qint64(rect.width()) * rect.height();
+    }
+    qint64 white = qint64(size.width()) * size.height();
+    if (serpentine) {
+        for (int x = 32; x < size.width(); x += 32) {
+            white -= qint64(2) * (size.height() - 16);
+        }
+    }
+    QCOMPARE(area, white);
+}
+
+// 画布尺寸
+void FillBenchmark::bucketTool_data()
+{
+    QTest::addColumn<QSize>("size");
+    for (const auto &size : Sizes) {
+        QTest::newRow(qPrintable(size.first)) << size.second;
+    }
+}
+
+// 在空白画布上用油漆桶点击：每次换一种颜色填充同一区域，含写入图块和提交历史
+void FillBenchmark::bucketTool()
+{
+    QFETCH(QSize, size);
+
+    PaintArea area;
+    resizeArea(area, size);
+    area.setDrawShape(PaintArea::Fill);
+    area.setHistoryBudget(256LL * 1024 * 1024);
+
+    const QColor colors[2] = {QColor(200, 40, 40), QColor(40, 40, 200)};
+    int step = 0;
+    QBENCHMARK {
+        area.setPenColor(colors[step++ % 2]);
+        click(&area, QPoint(size.width() / 2, size.height() / 2));
+    }
+}
+
+// 先画几个矩形，再在空白处用油漆桶填充(区域铺满矩形以外的整个画布并位于最上层)，然后框选：
+// 按在填充上拖动应框选出所有矩形；单击填充只选中填充，单击矩形选中矩形而不是填充
+void FillBenchmark::boxSelect()
+{
+    PaintArea area;
+    resizeArea(area, QSize(800, 600));
+    area.setDrawShape(PaintArea::Rectangle);
+    for (int i = 0; i < RectangleCount; ++i) {
+        drag(&area, QPoint(100 + i * 120, 250), QPoint(180 + i * 120, 330));
+    }
+    area.setDrawShape(PaintArea::Fill);
+    area.setPenColor(QColor(240, 200, 40));
+    click(&area, QPoint(10, 10));
+    area.setDrawShape(PaintArea::GroupSelect);
+
+    QBENCHMARK {
+        drag(&area, QPoint(50, 200), QPoint(750, 400));
+    }
+    QCOMPARE(area.selectedShapes().size(), RectangleCount);
+
+    click(&area, QPoint(10, 10));
+    QCOMPARE(area.selectedShapes().size(), 1);
+    int fill = area.selectedShapes().first();
+
+    click(&area, QPoint(140, 290));  // 第一个矩形的中心
+    QCOMPARE(area.selectedShapes().size(), 1);
+    QVERIFY(area.selectedShapes().first() != fill);
+}
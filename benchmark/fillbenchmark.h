@@ -0,0 +1,25 @@
+#ifndef FILLBENCHMARK_H
+#define FILLBENCHMARK_H
+
+#include <QObject>
+
+/**
+ * @brief 油漆桶基准：扫描线填充算法本身，以及从点击到写入绘制层和历史的完整耗时
+ *
+ * 空白画布上区域覆盖整个画布；蛇形图案中竖墙交替在顶部和底部留出缺口，区域在各带之间
+ * 反复穿越，考察候选转交和工作队列满时的补扫。铺满画布的填充之后还检查框选和单击选中
+ * 仍然能选到填充下面的形状。
+ */
+class FillBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void floodFill_data();  // 画布尺寸 × 图案
+    void floodFill();  // 计算一次填充区域
+    void bucketTool_data();  // 画布尺寸
+    void bucketTool();  // 用油漆桶点击一次
+    void boxSelect();  // 铺满画布的填充之后框选
+};
+
+#endif // FILLBENCHMARK_H
@@ -0,0 +1,128 @@
+#include "historybenchmark.h"
+#include "commandhistory.h"
+#include "historycommand.h"
+#include "scene.h"
+#include "shapefactory.h"
+#include "shapes.h"
+#include "tiledcanvas.h"
+#include "tilehistory.h"
+#include <QtTest>
+
+namespace {
+
+/**
+ * @brief 同时持有两种历史，按模式分派，接口与PaintArea中的用法相同
+ */
+class Document {
+public:
+    Document(const QSize &size, bool commandMode)
+        : commandMode(commandMode), drawing(size), shapeCount(0)
+    {
+        background = QImage(size, QImage::Format_ARGB32_Premultiplied);
+        background.fill(QColor(200, 200, 200));
+        if (commandMode) {
+            commands.reset(background, drawing);
+        } else {
+            tiles.reset(background, drawing);
+        }
+    }
+
+    // 绘制一个矩形并记录，位置随序号在画布上移动
+    void drawShape()
+    {
+        int step = shapeCount++;
+        QPoint start((step * 37) % qMax(1, drawing.width() - 200), (step * 23) % qMax(1, drawing.height() - 200));
+        ShapeHandle shape = ShapeFactory::acquire<RectangleShape>(start, Qt::red, 4);
+        shape->update(start + QPoint(160, 120));
+
+        HistoryCommand *command = new ShapeCommand(scene.allocateId(), ShapeFactory::share(std::move(shape)));
+        command->apply(background, drawing);
+        command->applyScene(scene);
+        if (commandMode) {
+            commands.record(command, background, drawing);
+        } else {
+            tiles.commit(background, drawing, command);
+        }
+    }
+
+    bool undo()
+    {
+        return commandMode ? commands.undo(background, drawing, scene) :
+                             tiles.undo(background, drawing, scene);
+    }
+
+    bool redo()
+    {
+        return commandMode ? commands.redo(background, drawing, scene) :
+                             tiles.redo(background, drawing, scene);
+    }
+
+private:
+    bool commandMode;
+    QImage background;
+    TiledCanvas drawing;
+    Scene scene;
+    TileHistory tiles;
+    CommandHistory commands;
+    int shapeCount;
+};
+
+// 历史模式 × 画布尺寸
+void addHistoryRows()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<bool>("commandMode");
+
+    const QList<QPair<QString, QSize>> sizes = {
+        {"800x600", QSize(800, 600)},
+        {"1920x1080", QSize(1920, 1080)},
+        {"3840x2160", QSize(3840, 2160)},
+    };
+    for (const auto &size : sizes) {
+        QTest::newRow(qPrintable("tile/" + size.first)) << size.second << false;
+        QTest::newRow(qPrintable("command/" + size.first)) << size.second << true;
+    }
+}
+
+} // namespace
+
+// 历史模式 × 画布尺寸
+void HistoryBenchmark::commit_data()
+{
+    addHistoryRows();
+}
+
+// 绘制一个形状并记录
+void HistoryBenchmark::commit()
+{
+    QFETCH(QSize, size);
+    QFETCH(bool, commandMode);
+
+    Document document(size, commandMode);
+    QBENCHMARK {
+        document.drawShape();
+    }
+}
+
+// 历史模式 × 画布尺寸
+void HistoryBenchmark::undoRedo_data()
+{
+    addHistoryRows();
+}
+
+// 撤销并重做一步；命令模式下撤销需要从检查点重放，预先记录若干步使重放距离接近典型值
+void HistoryBenchmark::undoRedo()
+{
+    QFETCH(QSize, size);
+    QFETCH(bool, commandMode);
+
+    Document document(size, commandMode);
+    for (int i = 0; i < 48; ++i) {
+        document.drawShape();
+    }
+
+    QBENCHMARK {
+        QVERIFY(document.undo());
+        QVERIFY(document.redo());
+    }
+}
@@ -0,0 +1,22 @@
+#ifndef HISTORYBENCHMARK_H
+#define HISTORYBENCHMARK_H
+
+#include <QObject>
+
+/**
+ * @brief 历史记录基准：两种历史模式在不同画布尺寸下的提交、撤销和重做
+ *
+ * 每一步操作都与PaintArea中的流程相同：形状命令先应用到画布和文档，再记录到历史。
+ */
+class HistoryBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void commit_data();  // 历史模式 × 画布尺寸
+    void commit();  // 绘制一个形状并记录
+    void undoRedo_data();  // 历史模式 × 画布尺寸
+    void undoRedo();  // 撤销并重做一步
+};
+
+#endif // HISTORYBENCHMARK_H
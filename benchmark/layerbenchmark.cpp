@@ -0,0 +1,89 @@
+#include "layerbenchmark.h"
+#include "layerstack.h"
+#include <QtTest>
+#include <QPainter>
+#include <QRandomGenerator>
+
+namespace {
+
+const QSize CanvasSize(2048, 2048);  // 画布尺寸
+const QRect DirtyRect(896, 896, 256, 256);  // 笔画所在的脏区域
+
+// 生成一个铺满半透明笔画的图层
+QImage strokeLayer(int seed)
+{
+    QImage image(CanvasSize, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    QRandomGenerator random(seed);
+    for (int i = 0; i < 100; ++i) {
+        QColor color = QColor::fromHsv(random.bounded(360), 200, 220, 96 + random.bounded(128));
+        painter.setPen(QPen(color, 8 + random.bounded(48), Qt::SolidLine, Qt::RoundCap));
+        painter.drawLine(random.bounded(CanvasSize.width()), random.bounded(CanvasSize.height()),
+                         random.bounded(CanvasSize.width()), random.bounded(CanvasSize.height()));
+    }
+    return image;
+}
+
+} // namespace
+
+// 2、10、50个图层(含绘制层)，分别逐层混合和使用缓存
+void LayerBenchmark::strokeRepaint_data()
+{
+    QTest::addColumn<int>("layerCount");
+    QTest::addColumn<bool>("cached");
+
+    for (int count : {2, 10, 50}) {
+        QTest::newRow(qPrintable(QString("%1 layers/uncached").arg(count))) << count << false;
+        QTest::newRow(qPrintable(QString("%1 layers/cached").arg(count))) << count << true;
+    }
+}
+
+// 在绘制层的脏区域中画一段线并重新合成该区域
+void LayerBenchmark::strokeRepaint()
+{
+    QFETCH(int, layerCount);
+    QFETCH(bool, cached);
+
+    QImage background(CanvasSize, QImage::Format_ARGB32_Premultiplied);
+    background.fill(QColor(235, 235, 235));
+
+    // 栅格图层一半在绘制层之下，一半在之上
+    LayerStack layers;
+    layers.resize(CanvasSize);
+    layers.setBackground(background);
+    for (int i = 1; i < layerCount; ++i) {
+        layers.addLayer(QString("图层%1").arg(i), strokeLayer(i));
+    }
+    layers.moveLayer(0, (layerCount - 1) / 2);
+    QCOMPARE(layers.documentIndex(), (layerCount - 1) / 2);
+
+    TiledCanvas document(CanvasSize);
+    QImage frame(CanvasSize, QImage::Format_ARGB32_Premultiplied);
+    if (cached) {
+        QPainter painter(&frame);
+        layers.renderCached(painter, DirtyRect, document);  // 预热：笔画开始前缓存已经建好
+    }
+
+    int step = 0;
+    QBENCHMARK {
+        QPoint from = DirtyRect.topLeft() + QPoint(step % 256, 0);
+        QPoint to = DirtyRect.bottomLeft() + QPoint(255 - step % 256, 0);
+        ++step;
+        document.paint(DirtyRect, [&](QPainter &painter, const QRect &) {
+            painter.setRenderHint(QPainter::Antialiasing);
+            painter.setPen(QPen(Qt::black, 6, Qt::SolidLine, Qt::RoundCap));
+            painter.drawLine(from, to);
+        });
+
+        QPainter painter(&frame);
+        painter.setClipRect(DirtyRect);
+        painter.fillRect(DirtyRect, Qt::white);
+        if (cached) {
+            layers.renderCached(painter, DirtyRect, document);
+        } else {
+            layers.render(painter, DirtyRect, background, document);
+        }
+    }
+}
@@ -0,0 +1,21 @@
+#ifndef LAYERBENCHMARK_H
+#define LAYERBENCHMARK_H
+
+#include <QObject>
+
+/**
+ * @brief 图层合成基准：笔画进行中重绘脏区域时，逐层混合与使用上下方缓存的耗时
+ *
+ * 绘制层位于图层栈中间，其余图层各铺满半透明的笔画。每次迭代先在绘制层的脏区域中画一段线，
+ * 再把该区域重新合成：逐层混合的耗时随图层数增长，使用缓存时只混合三个缓冲。
+ */
+class LayerBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void strokeRepaint_data();  // 图层数 × 是否使用缓存
+    void strokeRepaint();  // 画一段线并重新合成脏区域
+};
+
+#endif // LAYERBENCHMARK_H
@@ -0,0 +1,53 @@
+#include "blendbenchmark.h"
+#include "canvasbenchmark.h"
+#include "fillbenchmark.h"
+#include "historybenchmark.h"
+#include "layerbenchmark.h"
+#include "shapebenchmark.h"
+#include <QApplication>
+#include <QDir>
+#include <QtTest>
+
+/**
+ * @brief 依次运行所有基准
+ *
+ * 除Qt Test自身的参数外还支持 --results <目录>：每个基准类的结果另外以XML格式
+ * 写入该目录下的<类名>.xml，便于长期跟踪；控制台仍输出文本结果。
+ */
+int main(int argc, char *argv[])
+{
+    // 未指定平台插件时使用offscreen，无需显示服务器
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    QStringList args = app.arguments();
+    QString resultDir;
+    int resultIndex = args.indexOf("--results");
+    if (resultIndex > 0 && resultIndex + 1 < args.size()) {
+        resultDir = args.takeAt(resultIndex + 1);
+        args.removeAt(resultIndex);
+        QDir().mkpath(resultDir);
+    }
+
+    BlendBenchmark blend;
+    ShapeBenchmark shapes;
+    HistoryBenchmark history;
+    CanvasBenchmark canvas;
+    LayerBenchmark layers;
+    FillBenchmark fill;
+    QList<QObject *> benchmarks = {&blend, &shapes, &history, &canvas, &layers, &fill};
+
+    int failures = 0;
+    for (QObject *benchmark : benchmarks) {
+        QStringList benchmarkArgs = args;
+        if (!resultDir.isEmpty()) {
+            QString name = benchmark->metaObject()->className();
+            benchmarkArgs << "-o" << QDir(resultDir).filePath(name + ".xml") + ",xml"
+                          << "-o" << "-,txt";
+        }
+        failures += QTest::qExec(benchmark, benchmarkArgs);
+    }
+    return failures;
+}
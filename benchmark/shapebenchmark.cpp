@@ -0,0 +1,205 @@
+#include "shapebenchmark.h"
+#include "paintarea.h"
+#include "shapes.h"
+#include <QtTest>
+#include <QPainter>
+#include <QRandomGenerator>
+#include <QtMath>
+#include <vector>
+
+namespace {
+
+const int TargetSize = 2200;  // 绘制目标边长，容纳最大的形状和画笔宽度
+const QPoint Origin(64, 64);  // 形状起点
+
+/**
+ * @brief 参与基准的形状类型
+ */
+struct ShapeType {
+    const char *name;
+    PaintArea::DrawShape type;
+};
+
+const ShapeType shapeTypes[] = {
+    {"Line", PaintArea::Line},
+    {"Rectangle", PaintArea::Rectangle},
+    {"Ellipse", PaintArea::Ellipse},
+    {"Arrow", PaintArea::Arrow},
+    {"Star", PaintArea::Star},
+    {"Diamond", PaintArea::Diamond},
+    {"Heart", PaintArea::Heart},
+};
+
+} // namespace
+
+// 分配绘制目标
+void ShapeBenchmark::initTestCase()
+{
+    target = QImage(TargetSize, TargetSize, QImage::Format_ARGB32_Premultiplied);
+    target.fill(Qt::transparent);
+}
+
+// 形状类型 × 尺寸 × 画笔宽度
+void ShapeBenchmark::draw_data()
+{
+    QTest::addColumn<int>("type");
+    QTest::addColumn<int>("size");
+    QTest::addColumn<int>("penWidth");
+
+    for (const ShapeType &shape : shapeTypes) {
+        for (int size : {64, 512, 2048}) {
+            for (int penWidth : {1, 8, 32}) {
+                QTest::addRow("%s/%d/w%d", shape.name, size, penWidth)
+                    << static_cast<int>(shape.type) << size << penWidth;
+            }
+        }
+    }
+}
+
+// 绘制一个形状
+void ShapeBenchmark::draw()
+{
+    QFETCH(int, type);
+    QFETCH(int, size);
+    QFETCH(int, penWidth);
+
+    ShapeHandle shape = PaintArea::createShape(static_cast<PaintArea::DrawShape>(type),
+                                               Origin, Qt::black, penWidth);
+    shape->update(Origin + QPoint(size, size));
+
+    QPainter painter(&target);
+    QBENCHMARK {
+        shape->draw(painter);
+    }
+}
+
+// 形状类型 × 是否使用几何缓存
+void ShapeBenchmark::redraw_data()
+{
+    QTest::addColumn<int>("type");
+    QTest::addColumn<bool>("cached");
+
+    for (const ShapeType &shape : shapeTypes) {
+        QTest::addRow("%s/cached", shape.name) << static_cast<int>(shape.type) << true;
+        QTest::addRow("%s/rebuilt", shape.name) << static_cast<int>(shape.type) << false;
+    }
+}
+
+// 重绘一组已提交的形状，相当于撤销重放或跨图块重绘；
+// rebuilt行每次绘制前使缓存失效，对应缓存之前每次draw()都重新计算几何和画笔
+void ShapeBenchmark::redraw()
+{
+    QFETCH(int, type);
+    QFETCH(bool, cached);
+
+    const QPoint extent(96, 96);
+    QVector<QPoint> starts;
+    std::vector<ShapeHandle> shapes;
+    for (int i = 0; i < 256; ++i) {
+        QPoint start = Origin + QPoint((i % 16) * 120, (i / 16) * 120);
+        ShapeHandle shape = PaintArea::createShape(static_cast<PaintArea::DrawShape>(type),
+                                                   start, Qt::black, 4);
+        shape->update(start + extent);
+        starts.append(start);
+        shapes.push_back(std::move(shape));
+    }
+
+    QPainter painter(&target);
+    QBENCHMARK {
+        for (size_t i = 0; i < shapes.size(); ++i) {
+            if (!cached) {
+                // 重置为相同的起点和样式，只是让画笔和几何缓存失效
+                shapes[i]->reset(starts[i], Qt::black, 4);
+                shapes[i]->update(starts[i] + extent);
+            }
+            shapes[i]->draw(painter);
+        }
+    }
+}
+
+// 路径点数 × 简化容差
+void ShapeBenchmark::pathUpdate_data()
+{
+    QTest::addColumn<int>("points");
+    QTest::addColumn<double>("tolerance");
+    for (int points : {1000, 10000, 100000, 1000000}) {
+        for (double tolerance : {0.0, 0.5, 1.0, 2.0}) {
+            QTest::addRow("%d/tol%.1f", points, tolerance) << points << tolerance;
+        }
+    }
+}
+
+// 逐点追加路径，与鼠标拖动时的调用方式相同，并报告简化后保留的点数
+void ShapeBenchmark::pathUpdate()
+{
+    QFETCH(int, points);
+    QFETCH(double, tolerance);
+    const QVector<QPoint> stroke = strokePoints(points);
+
+    int kept = 0;
+    QBENCHMARK {
+        PathShape path(stroke.first(), Qt::black, 3);
+        path.setTolerance(tolerance);
+        for (const QPoint &point : stroke) {
+            path.update(point);
+        }
+        kept = path.pointCount();
+    }
+    qInfo("保留 %d/%d 个点 (%.1f%%)", kept, points, 100.0 * kept / points);
+}
+
+// 路径点数 × 绘制方式
+void ShapeBenchmark::pathDraw_data()
+{
+    QTest::addColumn<int>("points");
+    QTest::addColumn<double>("tolerance");
+    QTest::addColumn<bool>("smooth");
+    for (int points : {1000, 10000, 100000, 1000000}) {
+        QTest::addRow("%d/raw", points) << points << 0.0 << false;
+        QTest::addRow("%d/simplified", points) << points << 1.0 << false;
+        QTest::addRow("%d/smooth", points) << points << 1.0 << true;
+    }
+}
+
+// 绘制整条路径
+void ShapeBenchmark::pathDraw()
+{
+    QFETCH(int, points);
+    QFETCH(double, tolerance);
+    QFETCH(bool, smooth);
+    PathShape path(Origin, Qt::black, 3);
+    path.setTolerance(tolerance);
+    path.setSmoothing(smooth);
+    for (const QPoint &point : strokePoints(points)) {
+        path.update(point);
+    }
+
+    QPainter painter(&target);
+    QBENCHMARK {
+        path.draw(painter);
+    }
+    qInfo("绘制 %d 个点", path.pointCount());
+}
+
+// 模拟高回报率鼠标的笔画：方向缓慢变化、每次移动一两个像素，
+// 坐标取整后有大量共线和重复的采样点；限制在绘制目标范围内
+QVector<QPoint> ShapeBenchmark::strokePoints(int count)
+{
+    QVector<QPoint> points;
+    points.reserve(count);
+    QRandomGenerator random(7);
+    QPointF point(TargetSize / 2, TargetSize / 2);
+    double angle = 0;
+    for (int i = 0; i < count; ++i) {
+        angle += (random.generateDouble() - 0.5) * 0.3;
+        point += QPointF(std::cos(angle), std::sin(angle)) * 1.5;
+        // 碰到边界时掉头
+        if (point.x() < 0 || point.x() >= TargetSize || point.y() < 0 || point.y() >= TargetSize) {
+            angle += M_PI;
+            point.setX(qBound(0.0, point.x(), TargetSize - 1.0));
+            point.setY(qBound(0.0, point.y(), TargetSize - 1.0));
+        }
+        points.append(point.toPoint());
+    }
+    return points;
+}
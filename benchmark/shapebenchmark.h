@@ -0,0 +1,34 @@
+#ifndef SHAPEBENCHMARK_H
+#define SHAPEBENCHMARK_H
+
+#include <QObject>
+#include <QImage>
+#include <QPoint>
+#include <QVector>
+
+/**
+ * @brief 形状绘制基准：各形状在不同尺寸和画笔宽度下的draw()，已提交形状重绘时几何缓存的收益，
+ *        以及1千到1百万个点的路径追加(含在线简化)与绘制(含平滑)
+ */
+class ShapeBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();  // 分配绘制目标
+    void draw_data();  // 形状类型 × 尺寸 × 画笔宽度
+    void draw();  // 绘制一个形状
+    void redraw_data();  // 形状类型 × 是否使用几何缓存
+    void redraw();  // 重绘一组已提交的形状
+    void pathUpdate_data();  // 路径点数 × 简化容差
+    void pathUpdate();  // 逐点追加路径(报告简化后的点数)
+    void pathDraw_data();  // 路径点数 × 绘制方式(原始/简化/平滑)
+    void pathDraw();  // 绘制整条路径
+
+private:
+    static QVector<QPoint> strokePoints(int count);  // 生成落在目标范围内的笔画点
+
+    QImage target;  // 绘制目标(透明预乘ARGB32，与绘制层图块格式相同)
+};
+
+#endif // SHAPEBENCHMARK_H
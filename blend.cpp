@@ -0,0 +1,225 @@
+#include "blend.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define BLEND_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define BLEND_TARGET_SSE2
+#define BLEND_TARGET_AVX2
+#else
+#define BLEND_TARGET_SSE2 __attribute__((target("sse2")))
+#define BLEND_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+
+// 把x的四个通道分别乘以a/255，与Qt的BYTE_MUL完全相同
+inline quint32 byteMul(quint32 x, quint32 a)
+{
+    quint32 t = (x & 0xff00ff) * a;
+    t = (t + ((t >> 8) & 0xff00ff) + 0x800080) >> 8;
+    t &= 0xff00ff;
+    x = ((x >> 8) & 0xff00ff) * a;
+    x = (x + ((x >> 8) & 0xff00ff) + 0x800080);
+    x &= 0xff00ff00;
+    return x | t;
+}
+
+// 标量实现
+void sourceOverScalar(quint32 *dst, const quint32 *src, int length)
+{
+    for (int i = 0; i < length; ++i) {
+        quint32 s = src[i];
+        if (s >= 0xff000000) {
+            dst[i] = s;  // 不透明，直接覆盖
+        } else if (s != 0) {
+            dst[i] = s + byteMul(dst[i], 255 - (s >> 24));
+        }
+    }
+}
+
+#ifdef BLEND_X86
+
+// SSE2实现：每次4个像素，16位通道内完成乘法和近似除法
+BLEND_TARGET_SSE2 void sourceOverSse2(quint32 *dst, const quint32 *src, int length)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(0xff000000));
+    const __m128i colorMask = _mm_set1_epi32(0x00ff00ff);
+    const __m128i half = _mm_set1_epi16(0x80);
+    const __m128i full = _mm_set1_epi16(0xff);
+
+    int i = 0;
+    for (; i + 4 <= length; i += 4) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        // 4个像素全透明时跳过，绘制层大部分区域都是这种情况
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(s, zero)) == 0xffff) continue;
+        // 全不透明时直接覆盖
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, alphaMask), alphaMask)) == 0xffff) {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), s);
+            continue;
+        }
+
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+        __m128i alpha = _mm_srli_epi32(s, 24);
+        alpha = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 16));
+        alpha = _mm_sub_epi16(full, alpha);  // 每个16位通道都是255 - srcAlpha
+
+        __m128i ag = _mm_srli_epi16(d, 8);
+        __m128i rb = _mm_and_si128(d, colorMask);
+        ag = _mm_mullo_epi16(ag, alpha);
+        rb = _mm_mullo_epi16(rb, alpha);
+        rb = _mm_add_epi16(rb, _mm_srli_epi16(rb, 8));
+        ag = _mm_add_epi16(ag, _mm_srli_epi16(ag, 8));
+        rb = _mm_add_epi16(rb, half);
+        ag = _mm_add_epi16(ag, half);
+        rb = _mm_srli_epi16(rb, 8);
+        ag = _mm_andnot_si128(colorMask, ag);
+
+        __m128i result = _mm_add_epi8(s, _mm_or_si128(ag, rb));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), result);
+    }
+    sourceOverScalar(dst + i, src + i, length - i);
+}
+
+// AVX2实现：每次8个像素，运算与SSE2版本相同
+BLEND_TARGET_AVX2 void sourceOverAvx2(quint32 *dst, const quint32 *src, int length)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i alphaMask = _mm256_set1_epi32(static_cast<int>(0xff000000));
+    const __m256i colorMask = _mm256_set1_epi32(0x00ff00ff);
+    const __m256i half = _mm256_set1_epi16(0x80);
+    const __m256i full = _mm256_set1_epi16(0xff);
+
+    int i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(s, zero)) == -1) continue;
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_and_si256(s, alphaMask), alphaMask)) == -1) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), s);
+            continue;
+        }
+
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+        __m256i alpha = _mm256_srli_epi32(s, 24);
+        alpha = _mm256_or_si256(alpha, _mm256_slli_epi32(alpha, 16));
+        alpha = _mm256_sub_epi16(full, alpha);
+
+        __m256i ag = _mm256_srli_epi16(d, 8);
+        __m256i rb = _mm256_and_si256(d, colorMask);
+        ag = _mm256_mullo_epi16(ag, alpha);
+        rb = _mm256_mullo_epi16(rb, alpha);
+        rb = _mm256_add_epi16(rb, _mm256_srli_epi16(rb, 8));
+        ag = _mm256_add_epi16(ag, _mm256_srli_epi16(ag, 8));
+        rb = _mm256_add_epi16(rb, half);
+        ag = _mm256_add_epi16(ag, half);
+        rb = _mm256_srli_epi16(rb, 8);
+        ag = _mm256_andnot_si256(colorMask, ag);
+
+        __m256i result = _mm256_add_epi8(s, _mm256_or_si256(ag, rb));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), result);
+    }
+    sourceOverSse2(dst + i, src + i, length - i);
+}
+
+// 检测CPU和操作系统是否支持AVX2
+bool cpuHasAvx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+// 检测CPU是否支持SSE2(x86-64上总是支持)
+bool cpuHasSse2()
+{
+#if defined(__x86_64__) || defined(_M_X64)
+    return true;
+#elif defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#else
+    return __builtin_cpu_supports("sse2");
+#endif
+}
+
+#endif // BLEND_X86
+
+} // namespace
+
+// 使用最快的内核混合一行像素
+void Blend::sourceOver(quint32 *dst, const quint32 *src, int length)
+{
+    // 只在第一次调用时检测CPU
+    static const SourceOverFunc best = function(bestKernel());
+    best(dst, src, length);
+}
+
+// 当前CPU上最快的内核
+Blend::Kernel Blend::bestKernel()
+{
+    for (int kernel = KernelCount - 1; kernel > Scalar; --kernel) {
+        if (isSupported(static_cast<Kernel>(kernel))) return static_cast<Kernel>(kernel);
+    }
+    return Scalar;
+}
+
+// 当前CPU是否支持该内核
+bool Blend::isSupported(Kernel kernel)
+{
+    switch (kernel) {
+    case Scalar:
+        return true;
+#ifdef BLEND_X86
+    case SSE2:
+        return cpuHasSse2();
+    case AVX2:
+        return cpuHasSse2() && cpuHasAvx2();
+#endif
+    default:
+        return false;
+    }
+}
+
+// 获取指定内核的混合函数
+Blend::SourceOverFunc Blend::function(Kernel kernel)
+{
+    if (!isSupported(kernel)) return nullptr;
+
+    switch (kernel) {
+#ifdef BLEND_X86
+    case SSE2:
+        return sourceOverSse2;
+    case AVX2:
+        return sourceOverAvx2;
+#endif
+    default:
+        return sourceOverScalar;
+    }
+}
+
+// 内核名称
+const char *Blend::name(Kernel kernel)
+{
+    switch (kernel) {
+    case SSE2:
+        return "SSE2";
+    case AVX2:
+        return "AVX2";
+    default:
+        return "Scalar";
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef BLEND_H
+#define BLEND_H
+
+#include <QtGlobal>
+
+/**
+ * @brief 预乘ARGB32源覆盖混合内核
+ *
+ * 提供标量、SSE2和AVX2三种实现，运行时按CPU支持情况选择最快的一种。
+ * 运算与QPainter的源覆盖合成逐像素相同(dst = src + dst * (255 - srcAlpha) / 255，
+ * 使用Qt相同的近似除法)，因此结果逐字节一致。全透明的源像素直接跳过，
+ * 全不透明的源像素直接拷贝。
+ */
+class Blend {
+public:
+    /**
+     * @brief 内核实现
+     */
+    enum Kernel {
+        Scalar,  // 0:标量实现(所有平台)
+        SSE2,    // 1:每次处理4个像素
+        AVX2,    // 2:每次处理8个像素
+        KernelCount
+    };
+
+    /**
+     * @brief 混合函数：把src源覆盖到dst上
+     * @param dst 目标像素(预乘ARGB32)
+     * @param src 源像素(预乘ARGB32)
+     * @param length 像素数
+     */
+    typedef void (*SourceOverFunc)(quint32 *dst, const quint32 *src, int length);
+
+    /**
+     * @brief 使用当前CPU上最快的内核混合一行像素
+     */
+    static void sourceOver(quint32 *dst, const quint32 *src, int length);
+
+    static Kernel bestKernel();  // 当前CPU上最快的内核
+    static bool isSupported(Kernel kernel);  // 当前CPU是否支持该内核
+    static SourceOverFunc function(Kernel kernel);  // 获取指定内核的混合函数(不支持时为空)
+    static const char *name(Kernel kernel);  // 内核名称
+};
+
+#endif // BLEND_H
@@ -0,0 +1,132 @@
+#include "commandhistory.h"
+
+/* ========== CommandHistory 命令历史 ========== */
+
+// 构造函数
+CommandHistory::CommandHistory(int checkpointInterval)
+    : current(0), interval(qMax(1, checkpointInterval)) {}
+
+// 以当前图像作为初始检查点
+void CommandHistory::reset(const QImage &background, const TiledCanvas &drawing)
+{
+    steps.clear();
+    current = 0;
+    recordCheckpoint(background, drawing);
+}
+
+// 记录一条已经应用到图像上的命令
+void CommandHistory::record(HistoryCommand *command, const QImage &background,
+                            const TiledCanvas &drawing)
+{
+    truncateRedo();
+
+    Step step;
+    step.command = QSharedPointer<HistoryCommand>(command);
+    step.drawingSize = drawing.size();
+    // 每隔interval条命令保存一次检查点；画布尺寸变化时也必须保存，
+    // 保证同一检查点之后重放的命令都作用在相同尺寸的图像上
+    step.hasCheckpoint = stepsSinceCheckpoint() + 1 >= interval ||
+                         steps.last().drawingSize != step.drawingSize;
+    if (step.hasCheckpoint) {
+        // 隐式共享，之后绘制时才真正复制
+        step.background = background;
+        step.drawing = drawing;
+    }
+
+    steps.append(step);
+    current = steps.size() - 1;
+}
+
+// 记录一次直接保存图像的检查点
+void CommandHistory::recordCheckpoint(const QImage &background, const TiledCanvas &drawing,
+                                      HistoryCommand *command)
+{
+    if (!steps.isEmpty()) {
+        truncateRedo();
+    }
+
+    Step step;
+    step.command = QSharedPointer<HistoryCommand>(command);
+    step.hasCheckpoint = true;
+    step.background = background;
+    step.drawing = drawing;
+    step.drawingSize = drawing.size();
+
+    steps.append(step);
+    current = steps.size() - 1;
+}
+
+// 撤销一步：从最近的检查点恢复并重放命令
+bool CommandHistory::undo(QImage &background, TiledCanvas &drawing, Scene &scene)
+{
+    if (!canUndo()) return false;
+
+    // 先让文档回到目标状态，重放的形状命令才会使用当时的形状位置
+    const QSharedPointer<HistoryCommand> &command = steps[current].command;
+    if (command) {
+        command->revertScene(scene);
+    }
+
+    --current;
+    restore(current, background, drawing);
+    return true;
+}
+
+// 重做一步：直接在当前图像上应用下一条命令
+bool CommandHistory::redo(QImage &background, TiledCanvas &drawing, Scene &scene)
+{
+    if (!canRedo()) return false;
+
+    ++current;
+    const Step &step = steps[current];
+    if (step.hasCheckpoint) {
+        background = step.background;
+        drawing = step.drawing;
+    } else {
+        step.command->apply(background, drawing);
+    }
+    if (step.command) {
+        step.command->applyScene(scene);
+    }
+    return true;
+}
+
+// 设置检查点间隔(只影响之后记录的命令)
+void CommandHistory::setCheckpointInterval(int checkpointInterval)
+{
+    interval = qMax(1, checkpointInterval);
+}
+
+// 丢弃当前步骤之后的重做部分
+void CommandHistory::truncateRedo()
+{
+    steps.resize(current + 1);
+}
+
+// 最后一步距上一个检查点的步数
+int CommandHistory::stepsSinceCheckpoint() const
+{
+    int distance = 0;
+    for (int i = steps.size() - 1; i > 0 && !steps[i].hasCheckpoint; --i) {
+        ++distance;
+    }
+    return distance;
+}
+
+// 恢复到第target步之后的状态
+void CommandHistory::restore(int target, QImage &background, TiledCanvas &drawing) const
+{
+    // 向前找到最近的检查点(第0步一定是检查点)
+    int checkpoint = target;
+    while (!steps[checkpoint].hasCheckpoint) {
+        --checkpoint;
+    }
+
+    background = steps[checkpoint].background;
+    drawing = steps[checkpoint].drawing;
+
+    // 依次重放检查点之后的命令
+    for (int i = checkpoint + 1; i <= target; ++i) {
+        steps[i].command->apply(background, drawing);
+    }
+}
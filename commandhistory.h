@@ -0,0 +1,85 @@
+#ifndef COMMANDHISTORY_H
+#define COMMANDHISTORY_H
+
+#include <QImage>
+#include <QSize>
+#include <QVector>
+#include <QSharedPointer>
+#include "historycommand.h"
+#include "tiledcanvas.h"
+
+/**
+ * @brief 基于命令的矢量历史
+ *
+ * 每一步只记录完成的命令(通常只有几百字节)，每隔若干步保存一次栅格检查点。
+ * 撤销时从最近的检查点恢复图像，再重放之后的命令。
+ */
+class CommandHistory {
+public:
+    /**
+     * @brief 构造函数
+     * @param checkpointInterval 每隔多少条命令保存一次栅格检查点
+     */
+    explicit CommandHistory(int checkpointInterval = 32);
+
+    /**
+     * @brief 以当前图像作为初始检查点，清空所有历史
+     */
+    void reset(const QImage &background, const TiledCanvas &drawing);
+
+    /**
+     * @brief 记录一条已经应用到图像上的命令
+     * @param command 命令对象，历史接管其所有权
+     * @param background 应用命令后的背景平面
+     * @param drawing 应用命令后的绘制平面
+     */
+    void record(HistoryCommand *command, const QImage &background, const TiledCanvas &drawing);
+
+    /**
+     * @brief 记录一次无法用命令重放像素的状态变化(如加载图像)，直接保存检查点
+     * @param command 可选的命令，只用于撤销/重做时同步文档，历史接管其所有权
+     */
+    void recordCheckpoint(const QImage &background, const TiledCanvas &drawing,
+                          HistoryCommand *command = nullptr);
+
+    /**
+     * @brief 撤销一步：先撤销文档中的形状变化，再从最近的检查点重放
+     * @param scene 需要同步的文档
+     * @return 成功撤销时返回true
+     */
+    bool undo(QImage &background, TiledCanvas &drawing, Scene &scene);
+
+    /**
+     * @brief 重做一步：应用下一条命令的像素和形状变化
+     * @param scene 需要同步的文档
+     * @return 成功重做时返回true
+     */
+    bool redo(QImage &background, TiledCanvas &drawing, Scene &scene);
+    bool canUndo() const { return current > 0; }  // 是否可以撤销
+    bool canRedo() const { return current + 1 < steps.size(); }  // 是否可以重做
+
+    void setCheckpointInterval(int interval);  // 设置检查点间隔
+    int checkpointInterval() const { return interval; }  // 获取检查点间隔
+
+private:
+    /**
+     * @brief 一步历史
+     */
+    struct Step {
+        QSharedPointer<HistoryCommand> command;  // 该步的命令(检查点步骤可以为空)
+        bool hasCheckpoint;  // 是否保存了该步之后的图像
+        QImage background;   // 检查点：背景平面
+        TiledCanvas drawing; // 检查点：绘制平面(与画布共享图块)
+        QSize drawingSize;   // 该步之后绘制平面的尺寸
+    };
+
+    void truncateRedo();  // 丢弃当前步骤之后的重做部分
+    int stepsSinceCheckpoint() const;  // 最后一步距上一个检查点的步数
+    void restore(int target, QImage &background, TiledCanvas &drawing) const;  // 恢复到指定步骤之后的状态
+
+    QVector<Step> steps;  // 所有步骤，第0步为初始检查点
+    int current;  // 当前状态对应的步骤下标
+    int interval;  // 检查点间隔
+};
+
+#endif // COMMANDHISTORY_H
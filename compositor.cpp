@@ -0,0 +1,64 @@
+#include "compositor.h"
+#include "blend.h"
+#include <QVector>
+#include <QtConcurrent>
+#include <atomic>
+
+// 把绘制层合成到背景上：每个图块行为一带，各带并行合成
+QImage Compositor::composite(const QImage &background, const TiledCanvas &drawing,
+                             const QColor &base, const Progress &progress)
+{
+    QImage result;
+    if (!background.isNull()) {
+        result = background.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    } else {
+        result = QImage(drawing.size(), QImage::Format_ARGB32_Premultiplied);
+        result.fill(base);
+    }
+    if (result.isNull()) return result;
+
+    // 在调用线程中完成分离，工作线程只写各自带内的像素
+    uchar *bits = result.bits();
+    const qsizetype bytesPerLine = result.bytesPerLine();
+    const int width = result.width();
+    const int height = result.height();
+    const int tileSize = TiledCanvas::TileSize;
+
+    QVector<int> rows;
+    for (int row = 0; row < drawing.rows() && row * tileSize < height; ++row) {
+        rows.append(row);
+    }
+
+    std::atomic<int> done(0);
+    std::atomic<bool> canceled(false);
+    const int total = rows.size();
+
+    // 调用线程也参与合成，在线程池的工作线程中调用时不会因等待而死锁
+    QtConcurrent::blockingMap(rows, [&](int row) {
+        if (canceled.load()) return;
+
+        int top = row * tileSize;
+        int bandHeight = qMin(tileSize, height - top);
+
+        // 逐个图块混合到结果中这一带的像素上，未分配的图块是透明的，直接跳过
+        for (int col = 0; col < drawing.columns() && col * tileSize < width; ++col) {
+            int index = row * drawing.columns() + col;
+            if (!drawing.hasTile(index)) continue;
+
+            const QImage tile = drawing.tile(index);
+            int span = qMin(tileSize, width - col * tileSize);
+            for (int y = 0; y < bandHeight; ++y) {
+                quint32 *target = reinterpret_cast<quint32 *>(bits + (top + y) * bytesPerLine) +
+                                  col * tileSize;
+                Blend::sourceOver(target, reinterpret_cast<const quint32 *>(tile.constScanLine(y)), span);
+            }
+        }
+
+        int finished = ++done;
+        if (progress && !progress(finished, total)) {
+            canceled = true;
+        }
+    });
+
+    return canceled ? QImage() : result;
+}
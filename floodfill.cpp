@@ -0,0 +1,431 @@
+#include "floodfill.h"
+#include <QBitArray>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
+#include <climits>
+
+namespace {
+
+const int StripeHeight = TiledCanvas::TileSize;  // 每一带的行数(与图块行对齐)
+const int TileBytesPerLine = TiledCanvas::TileSize * 4;  // 图块每行的字节数
+const int TileShift = 7;  // 坐标右移这么多位得到图块的行列号
+const int TileMask = TiledCanvas::TileSize - 1;  // 坐标按位与得到图块内的位置
+static_assert((1 << TileShift) == TiledCanvas::TileSize, "图块边长必须是2的TileShift次方");
+const int FlushInterval = 64;  // 每处理这么多个候选就把越过边界的候选交给相邻的带
+
+// 行段：第y行中[left, right]的像素
+struct Span {
+    int y;
+    int left;
+    int right;
+};
+
+// 预乘像素的每个通道乘以alpha/255(与Qt的BYTE_MUL相同的近似)
+inline quint32 byteMul(quint32 pixel, quint32 alpha)
+{
+    quint32 t = (pixel & 0xff00ff) * alpha;
+    t = ((t + ((t >> 8) & 0xff00ff) + 0x800080) >> 8) & 0xff00ff;
+    pixel = ((pixel >> 8) & 0xff00ff) * alpha;
+    pixel = (pixel + ((pixel >> 8) & 0xff00ff) + 0x800080) & 0xff00ff00;
+    return pixel | t;
+}
+
+// 颜色是否在容差内：预乘ARGB的每个通道之差都不超过tolerance
+inline bool matches(quint32 pixel, quint32 target, int tolerance)
+{
+    if (pixel == target) return true;
+    for (int shift = 0; shift < 32; shift += 8) {
+        int diff = int((pixel >> shift) & 0xff) - int((target >> shift) & 0xff);
+        if (diff > tolerance || diff < -tolerance) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 合成后的像素来源：背景(或底色)上源覆盖绘制层的图块，不生成整张合成图像
+ */
+class Source {
+public:
+    Source(const QImage &background, const TiledCanvas &drawing, const QColor &base)
+        : width(drawing.width()), height(drawing.height()), backgroundBits(nullptr), backgroundStride(0),
+          basePixel(qPremultiply(base.rgba())), columns(drawing.columns())
+    {
+        if (!background.isNull()) {
+            QImage image = background;
+            if (image.format() != QImage::Format_RGB32 && image.format() != QImage::Format_ARGB32_Premultiplied) {
+                image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+            }
+            if (image.size() != drawing.size()) {
+                // 背景与画布尺寸不同时，背景以外的部分按底色处理
+                QImage padded(drawing.size(), QImage::Format_ARGB32_Premultiplied);
+                padded.fill(base);
+                QPainter painter(&padded);
+                painter.setCompositionMode(QPainter::CompositionMode_Source);
+                painter.drawImage(0, 0, image);
+                painter.end();
+                image = padded;
+            }
+            backgroundImage = image;
+            backgroundBits = backgroundImage.constBits();
+            backgroundStride = backgroundImage.bytesPerLine();
+        }
+
+        // 持有图块的引用，填充期间直接按指针读取
+        tiles.resize(drawing.tileCount());
+        tileBits.resize(drawing.tileCount());
+        for (int i = 0; i < drawing.tileCount(); ++i) {
+            tiles[i] = drawing.tile(i);
+            tileBits[i] = tiles[i].isNull() ? nullptr : tiles[i].constBits();
+        }
+    }
+
+    /**
+     * @brief 一行合成像素的读取器：背景行指针只取一次，图块行指针只在跨入新的图块列时重新取得，
+     *        逐像素只做移位和按位与
+     */
+    class Row {
+    public:
+        Row(const Source &source, int y)
+            : background(source.backgroundBits ?
+                             reinterpret_cast<const quint32 *>(source.backgroundBits + y * source.backgroundStride) :
+                             nullptr),
+              basePixel(source.basePixel), tiles(source.tileBits.constData() + (y >> TileShift) * source.columns),
+              offset((y & TileMask) * TileBytesPerLine), column(-1), over(nullptr) {}
+
+        // 合成后的像素(预乘ARGB32)
+        quint32 pixel(int x)
+        {
+            if ((x >> TileShift) != column) {
+                column = x >> TileShift;
+                const uchar *tile = tiles[column];
+                over = tile ? reinterpret_cast<const quint32 *>(tile + offset) : nullptr;
+            }
+
+            quint32 under = background ? background[x] : basePixel;
+            if (!over) return under;
+            quint32 top = over[x & TileMask];
+            quint32 alpha = top >> 24;
+            if (alpha == 255) return top;
+            if (alpha == 0) return under;
+            return top + byteMul(under, 255 - alpha);
+        }
+
+    private:
+        const quint32 *background;  // 背景的这一行(没有背景时为空)
+        quint32 basePixel;  // 没有背景时的底色
+        const uchar *const *tiles;  // 这一行所在图块行的各图块像素(未分配为空)
+        int offset;  // 这一行在图块内的字节偏移
+        int column;  // 当前图块列
+        const quint32 *over;  // 当前图块的这一行(未分配为空)
+    };
+
+    // 合成后的像素(预乘ARGB32)，只用于单个像素，成段读取用Row
+    quint32 pixel(int x, int y) const
+    {
+        return Row(*this, y).pixel(x);
+    }
+
+    const int width;  // 画布宽度
+    const int height;  // 画布高度
+
+private:
+    QImage backgroundImage;  // 32位格式的背景
+    const uchar *backgroundBits;  // 背景像素(没有背景时为空)
+    qsizetype backgroundStride;  // 背景每行的字节数
+    quint32 basePixel;  // 没有背景时的底色
+    int columns;  // 图块列数
+    QVector<QImage> tiles;  // 绘制层的图块
+    QVector<const uchar *> tileBits;  // 图块像素(未分配为空)
+};
+
+/**
+ * @brief 一条水平带：同一时刻只由一个线程处理，越过边界的候选交给相邻的带
+ */
+struct Stripe {
+    int top = 0;  // 第一行
+    int bottom = 0;  // 最后一行的下一行
+    QBitArray filled;  // 带内已填充的像素(第一次处理时分配)
+    QVector<Span> inbox;  // 相邻的带转交来的候选(由互斥量保护)
+    bool queued = false;  // 是否在就绪列表中
+    bool busy = false;  // 是否正由某个线程处理
+    QVector<QRect> spans;  // 已填充的行段
+};
+
+/**
+ * @brief 一次填充的共享状态，多个工作线程各自调用work()
+ */
+class Filler {
+public:
+    Filler(const Source &source, quint32 target, int tolerance)
+        : source(source), target(target), tolerance(tolerance), active(0)
+    {
+        for (int top = 0; top < source.height; top += StripeHeight) {
+            Stripe stripe;
+            stripe.top = top;
+            stripe.bottom = qMin(top + StripeHeight, source.height);
+            stripes.append(stripe);
+        }
+    }
+
+    // 把种子放入所在的带
+    void start(const QPoint &seed)
+    {
+        int index = seed.y() / StripeHeight;
+        stripes[index].inbox.append(Span{seed.y(), seed.x(), seed.x()});
+        schedule(index);
+    }
+
+    // 工作线程：反复取出一条就绪的带处理，直到没有就绪的带且其他线程也都空闲
+    void work()
+    {
+        QMutexLocker locker(&mutex);
+        forever {
+            while (ready.isEmpty() && active > 0) {
+                wake.wait(&mutex);
+            }
+            if (ready.isEmpty()) {
+                wake.wakeAll();  // 填充结束，唤醒其余等待的线程
+                return;
+            }
+
+            int index = ready.takeLast();
+            Stripe &stripe = stripes[index];
+            stripe.queued = false;
+            stripe.busy = true;
+            ++active;
+            QVector<Span> seeds;
+            seeds.swap(stripe.inbox);
+            locker.unlock();
+
+            process(index, seeds);
+
+            locker.relock();
+            stripe.busy = false;
+            if (!stripe.inbox.isEmpty()) schedule(index);  // 处理期间又收到了候选
+            --active;
+            wake.wakeAll();
+        }
+    }
+
+    // 所有带的行段，按行、左端排序
+    QVector<QRect> spans()
+    {
+        QtConcurrent::blockingMap(stripes, [](Stripe &stripe) {
+            std::sort(stripe.spans.begin(), stripe.spans.end(), [](const QRect &a, const QRect &b) {
+                return a.y() != b.y() ? a.y() < b.y() : a.x() < b.x();
+            });
+        });
+
+        QVector<QRect> result;
+        for (const Stripe &stripe : std::as_const(stripes)) {
+            result.append(stripe.spans);
+        }
+        return result;
+    }
+
+private:
+    /**
+     * @brief 处理一条带时的局部状态
+     */
+    struct Pass {
+        int index;  // 带的下标
+        QVector<Span> queue;  // 工作队列(容量为QueueCapacity)
+        QVector<Span> up;  // 越过上边界的候选
+        QVector<Span> down;  // 越过下边界的候选
+        int rescanTop = INT_MAX;  // 队列满时被丢弃的候选来自的行范围(rescanTop > rescanBottom表示没有)
+        int rescanBottom = INT_MIN;
+        int sinceFlush = 0;  // 上次转交以来处理的候选数
+    };
+
+    // 在互斥量保护下调用：带没有在处理也没有排队时放入就绪列表
+    void schedule(int index)
+    {
+        Stripe &stripe = stripes[index];
+        if (stripe.busy || stripe.queued) return;
+        stripe.queued = true;
+        ready.append(index);
+    }
+
+    // 处理一条带：转交来的候选逐个在空队列中展开，最后补扫队列满时丢弃过候选的行
+    void process(int index, const QVector<Span> &seeds)
+    {
+        Stripe &stripe = stripes[index];
+        if (stripe.filled.isEmpty()) {
+            stripe.filled = QBitArray((stripe.bottom - stripe.top) * source.width);
+        }
+
+        Pass pass;
+        pass.index = index;
+        pass.queue.reserve(FloodFill::QueueCapacity);
+        for (const Span &seed : seeds) {
+            pass.queue.append(seed);  // 此时队列为空，转交来的候选不会被丢弃
+            drain(pass);
+        }
+
+        // 重新扫描丢弃过候选的行中已填充的行段，补回上下两行的候选；补扫时队列满了先排空
+        while (pass.rescanTop <= pass.rescanBottom) {
+            int first = pass.rescanTop;
+            int last = pass.rescanBottom;
+            pass.rescanTop = INT_MAX;
+            pass.rescanBottom = INT_MIN;
+
+            for (int i = 0, count = stripe.spans.size(); i < count; ++i) {
+                QRect span = stripe.spans[i];
+                if (span.y() < first || span.y() > last) continue;
+
+                for (int y : {span.y() - 1, span.y() + 1}) {
+                    if (pass.queue.size() >= FloodFill::QueueCapacity) drain(pass);
+                    addCandidate(pass, y, span.left(), span.right(), span.y());
+                }
+            }
+            drain(pass);
+        }
+        flush(pass);
+    }
+
+    // 排空工作队列，并定期把越过边界的候选交给相邻的带，使它们尽早开始并行填充
+    void drain(Pass &pass)
+    {
+        while (!pass.queue.isEmpty()) {
+            Span span = pass.queue.takeLast();
+            scan(pass, span);
+            if (++pass.sinceFlush >= FlushInterval) flush(pass);
+        }
+    }
+
+    // 在候选区间中找出可填充的像素，向左右扩展为完整的行段并填充，上下两行对应的区间作为新的候选
+    // 整个行段只取一次行指针，已填充标记直接按字节读取
+    void scan(Pass &pass, const Span &span)
+    {
+        Stripe &stripe = stripes[pass.index];
+        const int y = span.y;
+        const qsizetype row = qsizetype(y - stripe.top) * source.width;
+        const uchar *filled = reinterpret_cast<const uchar *>(stripe.filled.bits());
+        Source::Row pixels(source, y);
+        auto fillable = [&](int x) {
+            qsizetype bit = row + x;
+            return !(filled[bit >> 3] & (1 << (bit & 7))) && matches(pixels.pixel(x), target, tolerance);
+        };
+
+        int x = span.left;
+        while (x <= span.right) {
+            if (!fillable(x)) {
+                ++x;
+                continue;
+            }
+
+            int left = x;
+            while (left > 0 && fillable(left - 1)) --left;
+            int right = x;
+            while (right + 1 < source.width && fillable(right + 1)) ++right;
+
+            stripe.filled.fill(true, row + left, row + right + 1);
+            stripe.spans.append(QRect(left, y, right - left + 1, 1));
+            addCandidate(pass, y - 1, left, right, y);
+            addCandidate(pass, y + 1, left, right, y);
+            x = right + 2;  // right + 1不可填充
+        }
+    }
+
+    // 加入一个候选：越过带边界的暂存起来转交，队列满时丢弃并记下来源行以便补扫
+    void addCandidate(Pass &pass, int y, int left, int right, int fromRow)
+    {
+        if (y < 0 || y >= source.height) return;
+
+        const Stripe &stripe = stripes[pass.index];
+        if (y < stripe.top) {
+            pass.up.append(Span{y, left, right});
+        } else if (y >= stripe.bottom) {
+            pass.down.append(Span{y, left, right});
+        } else if (pass.queue.size() < FloodFill::QueueCapacity) {
+            pass.queue.append(Span{y, left, right});
+        } else {
+            pass.rescanTop = qMin(pass.rescanTop, fromRow);
+            pass.rescanBottom = qMax(pass.rescanBottom, fromRow);
+        }
+    }
+
+    // 把暂存的越界候选交给相邻的带并唤醒空闲的线程
+    void flush(Pass &pass)
+    {
+        pass.sinceFlush = 0;
+        if (pass.up.isEmpty() && pass.down.isEmpty()) return;
+
+        QMutexLocker locker(&mutex);
+        if (!pass.up.isEmpty()) {
+            stripes[pass.index - 1].inbox.append(pass.up);
+            schedule(pass.index - 1);
+            pass.up.clear();
+        }
+        if (!pass.down.isEmpty()) {
+            stripes[pass.index + 1].inbox.append(pass.down);
+            schedule(pass.index + 1);
+            pass.down.clear();
+        }
+        wake.wakeAll();
+    }
+
+    const Source &source;  // 像素来源
+    const quint32 target;  // 种子颜色
+    const int tolerance;  // 颜色容差
+    QVector<Stripe> stripes;  // 所有的带
+    QMutex mutex;  // 保护就绪列表、各带的inbox和状态
+    QWaitCondition wake;  // 有新的就绪带或有线程结束处理
+    QVector<int> ready;  // 就绪的带
+    int active;  // 正在处理带的线程数
+};
+
+} // namespace
+
+// 从种子出发填充：线程池中的每个线程(包括调用线程)都作为工作线程，
+// 起初只有种子所在的带就绪，其余的带在收到转交的候选后陆续加入
+QVector<QRect> FloodFill::fill(const QImage &background, const TiledCanvas &drawing,
+                               const QPoint &seed, int tolerance, const QColor &base)
+{
+    if (!drawing.rect().contains(seed)) return QVector<QRect>();
+
+    Source source(background, drawing, base);
+    Filler filler(source, source.pixel(seed.x(), seed.y()), qBound(0, tolerance, 255));
+    filler.start(seed);
+
+    QVector<int> workers(qMax(1, QThreadPool::globalInstance()->maxThreadCount()));
+    QtConcurrent::blockingMap(workers, [&filler](int) {
+        filler.work();
+    });
+    return mergeRows(filler.spans());
+}
+
+// 合并上下相邻且左右端点相同的行段：逐行与上一行仍在延伸的矩形按左端对齐比较
+QVector<QRect> FloodFill::mergeRows(const QVector<QRect> &spans)
+{
+    QVector<QRect> rects;
+    QVector<int> open;  // 延伸到上一行的矩形下标(按左端排序)
+    QVector<int> next;  // 延伸到当前行的矩形下标
+
+    int i = 0;
+    while (i < spans.size()) {
+        const int y = spans[i].y();
+        next.clear();
+        int candidate = 0;
+        for (; i < spans.size() && spans[i].y() == y; ++i) {
+            const QRect &span = spans[i];
+            while (candidate < open.size() && rects[open[candidate]].left() < span.left()) ++candidate;
+
+            if (candidate < open.size()) {
+                QRect &rect = rects[open[candidate]];
+                if (rect.bottom() == y - 1 && rect.left() == span.left() && rect.right() == span.right()) {
+                    rect.setBottom(y);
+                    next.append(open[candidate++]);
+                    continue;
+                }
+            }
+            next.append(rects.size());
+            rects.append(span);
+        }
+        open.swap(next);
+    }
+    return rects;
+}
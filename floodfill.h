@@ -0,0 +1,48 @@
+#ifndef FLOODFILL_H
+#define FLOODFILL_H
+
+#include <QColor>
+#include <QImage>
+#include <QPoint>
+#include <QRect>
+#include <QVector>
+#include "tiledcanvas.h"
+
+/**
+ * @brief 多线程扫描线填充(油漆桶)
+ *
+ * 以行段为单位填充：从种子所在的一行向左右扩展出完整的行段，再把上下相邻的两行中对应的区间
+ * 作为候选放入工作队列，每个像素只比较常数次颜色。画布按图块行切成水平带，每一带同一时刻只由
+ * 一个工作线程处理，越过带边界的候选转交给相邻的带，因此大区域会同时在多个带中并行填充。
+ *
+ * 每一带的工作队列容量固定，队列满时不再加入候选，只记录产生候选的行范围，队列排空后重新扫描
+ * 这些行中已填充的行段补回候选，内存不随区域的复杂程度增长。
+ *
+ * 颜色取自背景和绘制层合成后的像素，与窗口中看到的画布一致。
+ */
+class FloodFill {
+public:
+    static const int QueueCapacity = 4096;  // 每一带工作队列的容量(行段数)
+
+    /**
+     * @brief 计算从种子出发、颜色在容差内的连通区域(四邻接)
+     * @param background 背景平面，为空时底色为base
+     * @param drawing 绘制平面，决定画布尺寸
+     * @param seed 种子像素(画布坐标)
+     * @param tolerance 颜色容差：预乘ARGB每个通道与种子颜色之差都不超过它的像素属于区域(0-255)
+     * @param base 没有背景时的底色
+     * @return 区域按行扫描得到的矩形(按上边、左边排序，互不重叠，上下相邻且左右相同的行段已合并)，
+     *         种子在画布外时为空
+     */
+    static QVector<QRect> fill(const QImage &background, const TiledCanvas &drawing,
+                               const QPoint &seed, int tolerance, const QColor &base = Qt::white);
+
+    /**
+     * @brief 把按行排序的单行行段合并为矩形：相邻两行中左右端点相同的行段合成一个更高的矩形
+     * @param spans 高度为1的行段，按行、左端排序
+     * @return 合并后的矩形，按上边、左边排序
+     */
+    static QVector<QRect> mergeRows(const QVector<QRect> &spans);
+};
+
+#endif // FLOODFILL_H
@@ -0,0 +1,88 @@
+#include "historycommand.h"
+#include <QPainter>
+
+/* ========== ShapeCommand 绘制形状命令 ========== */
+
+// 构造函数
+ShapeCommand::ShapeCommand(int id, const QSharedPointer<Shape> &shape)
+    : id(id), shape(shape) {}
+
+// 把形状绘制到绘制平面
+void ShapeCommand::apply(QImage &background, TiledCanvas &drawing) const
+{
+    Q_UNUSED(background);
+    // 只在形状覆盖的图块上绘制
+    drawing.paint(shape->paintRect(), [this](QPainter &painter, const QRect &) {
+        shape->draw(painter);
+    });
+}
+
+// 把形状加入文档
+void ShapeCommand::applyScene(Scene &scene) const
+{
+    scene.insert(id, shape);
+}
+
+// 把形状移出文档
+void ShapeCommand::revertScene(Scene &scene) const
+{
+    scene.take(id);
+}
+
+/* ========== MoveShapesCommand 移动形状命令 ========== */
+
+// 构造函数
+MoveShapesCommand::MoveShapesCommand(const QVector<int> &ids, const QPoint &delta,
+                                     const QRect &dirtyRect, const QImage &result)
+    : ids(ids), delta(delta), dirtyRect(dirtyRect), result(result) {}
+
+// 把移动后的像素写回受影响的区域
+void MoveShapesCommand::apply(QImage &background, TiledCanvas &drawing) const
+{
+    Q_UNUSED(background);
+    drawing.writeImage(dirtyRect.topLeft(), result);
+}
+
+// 平移形状
+void MoveShapesCommand::applyScene(Scene &scene) const
+{
+    scene.translate(ids, delta);
+}
+
+// 反向平移形状
+void MoveShapesCommand::revertScene(Scene &scene) const
+{
+    scene.translate(ids, -delta);
+}
+
+/* ========== SceneResetCommand 替换文档命令 ========== */
+
+// 构造函数
+SceneResetCommand::SceneResetCommand(const QVector<Scene::Item> &removed,
+                                     const QVector<Scene::Item> &added)
+    : removed(removed), added(added) {}
+
+// 像素变化由历史中的检查点或图块恢复
+void SceneResetCommand::apply(QImage &background, TiledCanvas &drawing) const
+{
+    Q_UNUSED(background);
+    Q_UNUSED(drawing);
+}
+
+// 清空文档并加入新形状
+void SceneResetCommand::applyScene(Scene &scene) const
+{
+    scene.takeAll();
+    for (const Scene::Item &item : added) {
+        scene.insert(item.first, item.second);
+    }
+}
+
+// 移出新形状并恢复被移出的形状
+void SceneResetCommand::revertScene(Scene &scene) const
+{
+    scene.takeAll();
+    for (const Scene::Item &item : removed) {
+        scene.insert(item.first, item.second);
+    }
+}
@@ -0,0 +1,100 @@
+#ifndef HISTORYCOMMAND_H
+#define HISTORYCOMMAND_H
+
+#include <QImage>
+#include <QRect>
+#include <QPoint>
+#include <QVector>
+#include <QSharedPointer>
+#include "scene.h"
+#include "shapes.h"
+#include "tiledcanvas.h"
+
+/**
+ * @brief 历史命令基类，一条命令描述一次可重放的编辑操作
+ *
+ * 命令分为两部分：apply()重放像素变化，applyScene()/revertScene()
+ * 在撤销/重做时同步文档中的形状。
+ */
+class HistoryCommand {
+public:
+    virtual ~HistoryCommand() {}  // 虚析构函数
+
+    /**
+     * @brief 把命令的像素变化应用到图像上
+     * @param background 背景平面
+     * @param drawing 绘制平面
+     */
+    virtual void apply(QImage &background, TiledCanvas &drawing) const = 0;
+
+    virtual void applyScene(Scene &scene) const { Q_UNUSED(scene); }  // 把命令的形状变化应用到文档
+    virtual void revertScene(Scene &scene) const { Q_UNUSED(scene); }  // 撤销命令的形状变化
+};
+
+/**
+ * @brief 绘制一个形状的命令
+ */
+class ShapeCommand : public HistoryCommand {
+public:
+    /**
+     * @brief 构造函数
+     * @param id 形状在文档中的id
+     * @param shape 已完成的形状(与文档共享)
+     */
+    ShapeCommand(int id, const QSharedPointer<Shape> &shape);
+    void apply(QImage &background, TiledCanvas &drawing) const override;  // 把形状绘制到绘制平面
+    void applyScene(Scene &scene) const override;  // 把形状加入文档
+    void revertScene(Scene &scene) const override;  // 把形状移出文档
+
+private:
+    int id;  // 形状id
+    QSharedPointer<Shape> shape;  // 要绘制的形状(与文档共享)
+};
+
+/**
+ * @brief 移动一组形状的命令
+ */
+class MoveShapesCommand : public HistoryCommand {
+public:
+    /**
+     * @brief 构造函数
+     * @param ids 被移动的形状id
+     * @param delta 平移量
+     * @param dirtyRect 移动影响的区域
+     * @param result 移动后该区域的像素，重放时直接写回
+     */
+    MoveShapesCommand(const QVector<int> &ids, const QPoint &delta,
+                      const QRect &dirtyRect, const QImage &result);
+    void apply(QImage &background, TiledCanvas &drawing) const override;  // 写回移动后的像素
+    void applyScene(Scene &scene) const override;  // 平移形状
+    void revertScene(Scene &scene) const override;  // 反向平移形状
+
+private:
+    QVector<int> ids;  // 被移动的形状
+    QPoint delta;  // 平移量
+    QRect dirtyRect;  // 受影响的区域
+    QImage result;  // 移动后受影响区域的像素
+};
+
+/**
+ * @brief 替换整个文档的命令(如加载新图像时绘制层被清空，打开工程文件时换成文件中的形状)
+ */
+class SceneResetCommand : public HistoryCommand {
+public:
+    /**
+     * @brief 构造函数
+     * @param removed 被移出文档的所有形状
+     * @param added 替换后文档中的形状(加载图像时为空)
+     */
+    explicit SceneResetCommand(const QVector<Scene::Item> &removed,
+                               const QVector<Scene::Item> &added = QVector<Scene::Item>());
+    void apply(QImage &background, TiledCanvas &drawing) const override;  // 像素由检查点恢复，无需操作
+    void applyScene(Scene &scene) const override;  // 清空文档并加入新形状
+    void revertScene(Scene &scene) const override;  // 移出新形状并恢复被移出的形状
+
+private:
+    QVector<Scene::Item> removed;  // 被移出的形状
+    QVector<Scene::Item> added;  // 替换后的形状
+};
+
+#endif // HISTORYCOMMAND_H
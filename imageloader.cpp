@@ -0,0 +1,143 @@
+#include "imageloader.h"
+#include "profiler.h"
+#include "projectfile.h"
+#include <QtConcurrent>
+#include <QImageReader>
+
+// 构造函数
+ImageLoader::ImageLoader(QObject *parent)
+    : QObject(parent)
+{
+    connect(&watcher, &QFutureWatcher<Result>::resultReadyAt,
+            this, &ImageLoader::onResultReady);
+}
+
+// 析构时取消并等待后台任务
+ImageLoader::~ImageLoader()
+{
+    watcher.cancel();
+    watcher.waitForFinished();
+}
+
+// 开始后台加载
+bool ImageLoader::start(const QString &fileName, const QSize &previewBound)
+{
+    if (isRunning()) return false;
+
+    watcher.setFuture(QtConcurrent::run(&ImageLoader::loadJob, fileName, previewBound));
+    return true;
+}
+
+// 取消加载
+void ImageLoader::cancel()
+{
+    watcher.cancel();
+}
+
+// 是否有加载任务在进行
+bool ImageLoader::isRunning() const
+{
+    return watcher.isRunning();
+}
+
+// 在工作线程中先解码预览，再解码全分辨率图像
+void ImageLoader::loadJob(QPromise<Result> &promise, QString fileName, QSize previewBound)
+{
+    Profiler::Scope profile(Profiler::SaveLoad);
+    if (ProjectFile::isProjectFile(fileName)) {
+        loadProject(promise, fileName);
+        return;
+    }
+
+    QImageReader reader(fileName);
+    reader.setAllocationLimit(0);  // 解除默认256MB的分配限制，允许打开超大扫描图
+    QSize fullSize = reader.size();
+
+    // 1. 预览：只对能在解码时直接缩小的格式生成，否则解码两次反而更慢
+    if (fullSize.isValid() && !previewBound.isEmpty() &&
+        (fullSize.width() > previewBound.width() || fullSize.height() > previewBound.height()) &&
+        reader.supportsOption(QImageIOHandler::ScaledSize)) {
+        reader.setScaledSize(fullSize.scaled(previewBound, Qt::KeepAspectRatio));
+        QImage preview;
+        if (reader.read(&preview)) {
+            Result result;
+            result.preview = true;
+            result.image = preview;
+            result.fullSize = fullSize;
+            promise.addResult(result);
+        }
+    }
+
+    if (promise.isCanceled()) return;
+
+    // 2. 全分辨率解码并转换为绘制使用的预乘格式(读取器读取一次后需重新创建)
+    QImageReader fullReader(fileName);
+    fullReader.setAllocationLimit(0);
+    Result result;
+    QImage image;
+    if (!fullReader.read(&image)) {
+        result.error = QString("无法加载图像: %1").arg(fullReader.errorString());
+        promise.addResult(result);
+        return;
+    }
+    if (promise.isCanceled()) return;
+
+    result.image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    result.fullSize = result.image.size();
+    promise.addResult(result);
+}
+
+// 读取工程文件：预览图只有几百KB，映射后立即发出；背景和图块按原格式直接复制
+void ImageLoader::loadProject(QPromise<Result> &promise, const QString &fileName)
+{
+    ProjectFile project;
+    Result result;
+    if (!project.open(fileName)) {
+        result.error = project.errorString();
+        promise.addResult(result);
+        return;
+    }
+
+    Result preview;
+    preview.preview = true;
+    preview.image = project.preview();
+    preview.fullSize = project.size();
+    promise.addResult(preview);
+
+    if (promise.isCanceled()) return;
+    result.drawing = project.drawing();
+    if (promise.isCanceled()) return;
+    result.image = project.background();
+    if (promise.isCanceled()) return;
+    if (!ProjectFile::decodeShapes(project.shapes(), result.shapes)) {
+        result.error = "工程文件中的形状已损坏";
+        promise.addResult(result);
+        return;
+    }
+    if (!ProjectFile::decodeLayers(project.layers(), project.size(), result.layers)) {
+        result.error = "工程文件中的图层已损坏";
+        promise.addResult(result);
+        return;
+    }
+
+    result.project = true;
+    result.fullSize = project.size();
+    promise.addResult(result);
+}
+
+// 收到一个结果：预览图或最终结果
+void ImageLoader::onResultReady(int index)
+{
+    if (watcher.isCanceled()) return;
+
+    Result result = watcher.resultAt(index);
+    if (result.preview) {
+        emit previewReady(result.image, result.fullSize);
+    } else if (!result.error.isEmpty()) {
+        emit failed(result.error);
+    } else if (result.project) {
+        emit projectLoaded(result.image, result.drawing, result.shapes, result.layers);
+    } else {
+        emit loaded(result.image);
+    }
+}
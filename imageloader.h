@@ -0,0 +1,72 @@
+#ifndef IMAGELOADER_H
+#define IMAGELOADER_H
+
+#include <QObject>
+#include <QImage>
+#include <QSize>
+#include <QString>
+#include <QFutureWatcher>
+#include <QPromise>
+#include "layerstack.h"
+#include "scene.h"
+#include "tiledcanvas.h"
+
+/**
+ * @brief 后台渐进式图像加载任务
+ *
+ * 在线程池中用QImageReader解码：支持按比例解码的格式(如JPEG)先解码一张
+ * 缩小的预览图立即显示，随后解码全分辨率图像并转换为预乘格式，整个过程不阻塞GUI线程。
+ * 工程文件(.ppd)不需要解码：映射文件后先发出其中保存的预览图，再复制背景、图块和图层并重建形状。
+ */
+class ImageLoader : public QObject
+{
+    Q_OBJECT  // Qt元对象系统宏
+
+public:
+    explicit ImageLoader(QObject *parent = nullptr);
+    ~ImageLoader() override;
+
+    /**
+     * @brief 开始后台加载
+     * @param fileName 图像文件名
+     * @param previewBound 预览图的最大尺寸(通常为绘图区域大小)
+     * @return 已有加载任务在进行时返回false
+     */
+    bool start(const QString &fileName, const QSize &previewBound);
+
+    void cancel();  // 取消加载(已开始的解码完成后结果会被丢弃)
+    bool isRunning() const;  // 是否有加载任务在进行
+
+signals:
+    void previewReady(const QImage &preview, const QSize &fullSize);  // 预览图解码完成
+    void loaded(const QImage &image);  // 全分辨率图像解码完成(预乘ARGB32格式)
+    void projectLoaded(const QImage &background, const TiledCanvas &drawing,
+                       const QVector<Scene::Item> &shapes,
+                       const QVector<LayerStack::Layer> &layers);  // 工程文件读取完成
+    void failed(const QString &message);  // 加载失败
+
+private:
+    /**
+     * @brief 后台任务的一个结果
+     */
+    struct Result {
+        bool preview = false;  // 是否为预览图
+        QImage image;          // 解码得到的图像
+        QSize fullSize;        // 全分辨率尺寸
+        QString error;         // 错误信息(成功时为空)
+        bool project = false;  // 是否为工程文件
+        TiledCanvas drawing;   // 工程文件的绘制层
+        QVector<Scene::Item> shapes;  // 工程文件中的形状
+        QVector<LayerStack::Layer> layers;  // 工程文件中的图层(旧版本为空)
+    };
+
+    // 在工作线程中先解码预览，再解码全分辨率图像
+    static void loadJob(QPromise<Result> &promise, QString fileName, QSize previewBound);
+    // 在工作线程中读取工程文件
+    static void loadProject(QPromise<Result> &promise, const QString &fileName);
+    void onResultReady(int index);  // 收到一个结果
+
+    QFutureWatcher<Result> watcher;  // 监视后台任务
+};
+
+#endif // IMAGELOADER_H
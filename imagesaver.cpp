@@ -0,0 +1,224 @@
+#include "imagesaver.h"
+#include "compositor.h"
+#include "profiler.h"
+#include "projectfile.h"
+#include "vectorexporter.h"
+#include <QtConcurrent>
+#include <QFileInfo>
+#include <QImageWriter>
+#include <QSaveFile>
+
+namespace {
+
+const int CompositeShare = 40;  // 合成阶段占总进度的百分比
+
+/**
+ * @brief 写入时检查取消状态的设备，取消后写入失败使编码器尽早退出
+ */
+class CancellableDevice : public QIODevice
+{
+public:
+    CancellableDevice(QIODevice *target, QPromise<QString> &promise)
+        : target(target), promise(promise) {}
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        Q_UNUSED(data);
+        Q_UNUSED(maxSize);
+        return -1;  // 只写设备
+    }
+
+    qint64 writeData(const char *data, qint64 size) override
+    {
+        if (promise.isCanceled()) return -1;
+        return target->write(data, size);
+    }
+
+private:
+    QIODevice *target;  // 实际写入的文件
+    QPromise<QString> &promise;  // 用于检查取消
+};
+
+} // namespace
+
+// 构造函数
+ImageSaver::ImageSaver(QObject *parent)
+    : QObject(parent)
+{
+    connect(&watcher, &QFutureWatcher<QString>::progressValueChanged,
+            this, &ImageSaver::progressChanged);
+    connect(&watcher, &QFutureWatcher<QString>::finished,
+            this, &ImageSaver::onFinished);
+}
+
+// 析构时取消并等待后台任务，避免任务引用已销毁的对象
+ImageSaver::~ImageSaver()
+{
+    watcher.cancel();
+    watcher.waitForFinished();
+}
+
+// 开始后台保存
+bool ImageSaver::start(const QImage &background, const TiledCanvas &drawing,
+                       const QString &fileName, const Options &options,
+                       const QByteArray &shapes, const QVector<LayerStack::Layer> &layers)
+{
+    if (isRunning()) return false;
+
+    currentFile = fileName;
+    // 参数按值传递，只增加图像的引用计数，不在GUI线程复制像素
+    watcher.setFuture(QtConcurrent::run(&ImageSaver::saveJob,
+                                        background, drawing, fileName, options, shapes, layers));
+    return true;
+}
+
+// 取消正在进行的保存
+void ImageSaver::cancel()
+{
+    watcher.cancel();
+}
+
+// 是否有保存任务在进行
+bool ImageSaver::isRunning() const
+{
+    return watcher.isRunning();
+}
+
+// 根据扩展名选择编码格式，未知扩展名使用PNG
+QByteArray ImageSaver::formatForFile(const QString &fileName)
+{
+    if (ProjectFile::isProjectFile(fileName)) return ProjectFile::Suffix;
+    QString suffix = QFileInfo(fileName).suffix().toLower();
+    if (suffix == "jpg" || suffix == "jpeg") return "jpeg";
+    if (suffix == "bmp") return "bmp";
+    if (suffix == "svg") return "svg";
+    if (suffix == "pdf") return "pdf";
+    return "png";
+}
+
+// 工程文件和矢量格式保存的是形状本身，需要形状列表
+bool ImageSaver::needsShapes(const QString &fileName)
+{
+    QByteArray format = formatForFile(fileName);
+    return format == ProjectFile::Suffix || VectorExporter::isVectorFormat(format);
+}
+
+// 在工作线程中合成并编码
+void ImageSaver::saveJob(QPromise<QString> &promise, QImage background, TiledCanvas drawing,
+                         QString fileName, Options options, QByteArray shapes,
+                         QVector<LayerStack::Layer> layers)
+{
+    Profiler::Scope profile(Profiler::SaveLoad);
+    promise.setProgressRange(0, 100);
+    QByteArray format = formatForFile(fileName);
+
+    // 工程文件：像素原样写入，不需要合成和编码
+    if (format == ProjectFile::Suffix) {
+        QString error = ProjectFile::write(fileName, background, drawing, shapes, layers,
+                                           [&promise](int done, int total) {
+                                               promise.setProgressValue(100 * done / total);
+                                               return !promise.isCanceled();
+                                           });
+        if (promise.isCanceled()) return;
+        promise.setProgressValue(100);
+        promise.addResult(error);
+        return;
+    }
+
+    // 矢量格式：在工作线程中重建一份形状，按绘制顺序重放到SVG/PDF
+    if (VectorExporter::isVectorFormat(format)) {
+        QVector<Scene::Item> items;
+        QString error = ProjectFile::decodeShapes(shapes, items) ?
+                            VectorExporter::write(fileName, drawing.size(), background, items, layers,
+                                                  [&promise](int done, int total) {
+                                                      promise.setProgressValue(100 * done / total);
+                                                      return !promise.isCanceled();
+                                                  }) :
+                            QString("无法读取形状");
+        if (promise.isCanceled()) return;
+        promise.setProgressValue(100);
+        promise.addResult(error);
+        return;
+    }
+
+    // 只有背景图像本身带透明通道且格式支持时才保留透明；没有背景时画布显示为白色，
+    // 橡皮擦也是白色笔画，保存时同样以白色为底
+    bool hasAlpha = format == "png" && !background.isNull() && background.hasAlphaChannel();
+    QColor base = hasAlpha ? Qt::transparent : Qt::white;
+
+    // 1. 合成：不保留透明时先铺白色背景，与界面显示一致；只有绘制层时各带在线程池中并行合成，
+    //    有其他图层时按图层栈逐层混合
+    LayerStack stack;
+    stack.resize(drawing.size());
+    if (!layers.isEmpty()) {
+        stack.setLayers(layers);
+    }
+    QImage finalImage = stack.isTrivial() ?
+        Compositor::composite(background, drawing, base,
+                              [&promise](int done, int total) {
+                                  promise.setProgressValue(CompositeShare * done / total);
+                                  return !promise.isCanceled();
+                              }) :
+        stack.flatten(background, drawing, base);
+    if (promise.isCanceled() || finalImage.isNull()) return;
+    if (!hasAlpha) {
+        finalImage = finalImage.convertToFormat(QImage::Format_RGB32);
+    }
+    promise.setProgressValue(CompositeShare);
+
+    // 2. 编码：先写入临时文件，成功后才替换目标文件
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        promise.addResult(QString("无法写入文件: %1").arg(file.errorString()));
+        return;
+    }
+
+    CancellableDevice device(&file, promise);
+    device.open(QIODevice::WriteOnly);
+    QImageWriter writer(&device, format);
+    if (options.quality >= 0) {
+        writer.setQuality(options.quality);
+    }
+    if (options.compression >= 0) {
+        writer.setCompression(options.compression);
+        // PNG编码器通过质量参数控制zlib压缩级别
+        if (format == "png" && options.quality < 0) {
+            writer.setQuality(100 - qBound(0, options.compression, 9) * 100 / 9);
+        }
+    }
+
+    bool ok = writer.write(finalImage);
+    if (promise.isCanceled()) {
+        file.cancelWriting();
+        return;
+    }
+    if (!ok) {
+        file.cancelWriting();
+        promise.addResult(QString("编码失败: %1").arg(writer.errorString()));
+        return;
+    }
+    if (!file.commit()) {
+        promise.addResult(QString("无法写入文件: %1").arg(file.errorString()));
+        return;
+    }
+
+    promise.setProgressValue(100);
+    promise.addResult(QString());
+}
+
+// 任务结束：根据结果发出finished信号
+void ImageSaver::onFinished()
+{
+    if (watcher.isCanceled()) {
+        emit finished(false, "保存已取消");
+        return;
+    }
+
+    QString error = watcher.future().resultCount() > 0 ? watcher.result() : QString("保存失败");
+    if (error.isEmpty()) {
+        emit finished(true, QString("已保存到 %1").arg(currentFile));
+    } else {
+        emit finished(false, error);
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef IMAGESAVER_H
+#define IMAGESAVER_H
+
+#include <QObject>
+#include <QImage>
+#include <QString>
+#include <QByteArray>
+#include <QFutureWatcher>
+#include <QPromise>
+#include "layerstack.h"
+#include "tiledcanvas.h"
+
+/**
+ * @brief 后台图像保存任务
+ *
+ * 在GUI线程只取得两个平面的隐式共享快照，合成与编码都在线程池中进行，
+ * 期间报告进度并可随时取消。编码格式由文件扩展名决定，工程文件(.ppd)不合成，按ProjectFile的格式写入；
+ * SVG/PDF也不合成，由VectorExporter嵌入背景并重放形状。有其他图层时栅格格式按图层栈合成。
+ */
+class ImageSaver : public QObject
+{
+    Q_OBJECT  // Qt元对象系统宏
+
+public:
+    /**
+     * @brief 编码选项
+     */
+    struct Options {
+        int quality = -1;      // 图像质量(0-100，JPEG使用；-1为默认值)
+        int compression = -1;  // PNG压缩级别(0-9，-1为默认值)
+    };
+
+    explicit ImageSaver(QObject *parent = nullptr);
+    ~ImageSaver() override;
+
+    /**
+     * @brief 开始后台保存
+     * @param background 背景平面快照(可以为空)
+     * @param drawing 绘制平面快照(图块隐式共享，GUI线程之后的绘制不会影响它)
+     * @param fileName 目标文件名，扩展名决定编码格式
+     * @param options 编码选项
+     * @param shapes 序列化的形状(ProjectFile::encodeShapes()的结果)，只有工程文件和矢量格式使用
+     * @param layers 图层栈中的所有图层快照(为空时只有绘制层)
+     * @return 已有保存任务在进行时返回false
+     */
+    bool start(const QImage &background, const TiledCanvas &drawing,
+               const QString &fileName, const Options &options,
+               const QByteArray &shapes = QByteArray(),
+               const QVector<LayerStack::Layer> &layers = QVector<LayerStack::Layer>());
+
+    void cancel();  // 取消正在进行的保存
+    bool isRunning() const;  // 是否有保存任务在进行
+
+    static QByteArray formatForFile(const QString &fileName);  // 根据扩展名选择编码格式(工程文件为"ppd")
+    static bool needsShapes(const QString &fileName);  // 保存时是否需要形状列表(工程文件和矢量格式)
+
+signals:
+    void progressChanged(int percent);  // 保存进度(0-100)
+    void finished(bool ok, const QString &message);  // 保存结束，message为结果说明
+
+private:
+    // 在工作线程中合成并编码，结果为错误信息(成功时为空)
+    static void saveJob(QPromise<QString> &promise, QImage background, TiledCanvas drawing,
+                        QString fileName, Options options, QByteArray shapes,
+                        QVector<LayerStack::Layer> layers);
+    void onFinished();  // 任务结束处理
+
+    QFutureWatcher<QString> watcher;  // 监视后台任务
+    QString currentFile;  // 正在保存的文件名
+};
+
+#endif // IMAGESAVER_H
@@ -0,0 +1,192 @@
+#include "inputreplayer.h"
+#include "paintarea.h"
+#include <QCoreApplication>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <QTimer>
+#include <algorithm>
+#include <memory>
+
+// 直方图桶的时间范围
+QString InputReplayer::bucketLabel(int bucket)
+{
+    if (bucket <= 0) return "<1us";
+    if (bucket >= HistogramBuckets - 1) return QString(">=%1us").arg(1 << (HistogramBuckets - 2));
+    return QString("%1-%2us").arg(1 << (bucket - 1)).arg(1 << bucket);
+}
+
+// 多行文本形式的报告
+QString InputReplayer::Report::toText() const
+{
+    QString text;
+    text += QString("事件数: %1%2\n").arg(events).arg(cancelled ? " (已取消)" : "");
+    text += QString("回放用时: %1 ms，事件处理合计: %2 ms\n")
+                .arg(wallTime / 1e6, 0, 'f', 1)
+                .arg(totalTime / 1e6, 0, 'f', 1);
+    text += QString("处理时间 p50: %1 us，p99: %2 us，最长: %3 us\n")
+                .arg(p50 / 1e3, 0, 'f', 1)
+                .arg(p99 / 1e3, 0, 'f', 1)
+                .arg(max / 1e3, 0, 'f', 1);
+
+    // 直方图只列出首尾非空桶之间的部分
+    int first = 0;
+    int last = histogram.size() - 1;
+    while (first <= last && histogram[first] == 0) ++first;
+    while (last >= first && histogram[last] == 0) --last;
+    int peak = first <= last ? *std::max_element(histogram.begin() + first, histogram.begin() + last + 1) : 0;
+    for (int i = first; i <= last; ++i) {
+        int bar = peak > 0 ? (histogram[i] * 40 + peak - 1) / peak : 0;
+        text += QString("%1 %2 %3\n")
+                    .arg(bucketLabel(i), 12)
+                    .arg(histogram[i], 7)
+                    .arg(QString(bar, '#'));
+    }
+
+    text += QString("绘制层哈希: %1 (%2)")
+                .arg(endHash, 16, 16, QChar('0'))
+                .arg(endMatched ? "与录制结果一致" : "与录制结果不同");
+    if (!sizeMatched) text += "\n注意: 控件尺寸与录制时不同，坐标转换结果可能不同";
+    if (!startMatched) text += "\n注意: 回放前的画布与录制开始时不同";
+    return text;
+}
+
+// 构造函数
+InputReplayer::InputReplayer(QObject *parent)
+    : QObject(parent) {}
+
+// 开始回放
+bool InputReplayer::start(PaintArea *area, const InputTrace &trace, bool realtime, QString *error)
+{
+    if (running || !area || trace.isEmpty()) return false;
+
+    // 恢复录制开始时的视图，坐标转换才与录制时一致；窗口尺寸不同时偏移可能被限制而无法恢复
+    area->setView(trace.fitToWindow, trace.zoom, trace.offset);
+    if (!trace.fitToWindow && (!qFuzzyCompare(area->zoom(), trace.zoom) || area->viewOffset() != trace.offset)) {
+        if (error) {
+            *error = QString("无法恢复录制时的视图(缩放 %1%，偏移 %2,%3)，请把窗口调整为录制时的尺寸 %4x%5")
+                         .arg(trace.zoom * 100, 0, 'f', 0)
+                         .arg(trace.offset.x()).arg(trace.offset.y())
+                         .arg(trace.widgetSize.width()).arg(trace.widgetSize.height());
+        }
+        return false;
+    }
+
+    this->area = area;
+    this->trace = trace;
+    this->realtime = realtime;
+    running = true;
+    startMatched = area->contentHash() == trace.startHash;
+    next = 0;
+    durations.clear();
+    durations.reserve(trace.events.size());
+    clock.start();
+
+    // 从事件循环开始，调用者可以先连接finished信号
+    QTimer::singleShot(0, this, &InputReplayer::replayNext);
+    return true;
+}
+
+// 取消回放
+void InputReplayer::cancel()
+{
+    if (running) finish(true);
+}
+
+// 送出所有到时的事件，然后等待下一个事件
+void InputReplayer::replayNext()
+{
+    if (!running) return;
+    if (!area) {
+        finish(true);
+        return;
+    }
+
+    if (next < trace.events.size()) {
+        const InputTrace::Event &event = trace.events[next];
+        if (realtime) {
+            qint64 waitMs = (event.time * 1000 - clock.nsecsElapsed()) / 1000000;
+            if (waitMs > 0) {
+                QTimer::singleShot(waitMs, this, &InputReplayer::replayNext);
+                return;
+            }
+        }
+        dispatch(event);
+        ++next;
+    }
+
+    if (next >= trace.events.size()) {
+        finish(false);
+        return;
+    }
+    // 每个事件之后都回到事件循环，让重绘等积压的工作照常处理
+    QTimer::singleShot(0, this, &InputReplayer::replayNext);
+}
+
+// 送出一个事件并记录处理时间
+void InputReplayer::dispatch(const InputTrace::Event &event)
+{
+    // 按下时恢复录制时的工具参数
+    if (event.type == QEvent::MouseButtonPress) {
+        area->setDrawShape(static_cast<PaintArea::DrawShape>(event.tool));
+        area->setPenColor(event.color);
+        area->setPenWidth(event.width);
+        area->setStrokeTolerance(event.tolerance);
+        area->setStrokeSmoothing(event.smoothing);
+        area->setFillTolerance(event.fillTolerance);
+    }
+
+    QPointF pos(event.pos);
+    std::unique_ptr<QEvent> input;
+    if (event.type == QEvent::Wheel) {
+        input.reset(new QWheelEvent(pos, area->mapToGlobal(pos), QPoint(), QPoint(0, event.delta),
+                                    event.buttons, Qt::NoModifier, Qt::NoScrollPhase, false));
+    } else if (event.type == QEvent::KeyPress || event.type == QEvent::KeyRelease) {
+        input.reset(new QKeyEvent(event.type, event.key, Qt::NoModifier));
+    } else {
+        input.reset(new QMouseEvent(event.type, pos, area->mapToGlobal(pos),
+                                    event.button, event.buttons, Qt::NoModifier));
+    }
+    QElapsedTimer timer;
+    timer.start();
+    QCoreApplication::sendEvent(area, input.get());
+    durations.append(timer.nsecsElapsed());
+}
+
+// 统计并发出结果
+void InputReplayer::finish(bool cancelled)
+{
+    running = false;
+
+    Report report;
+    report.events = durations.size();
+    report.wallTime = clock.nsecsElapsed();
+    report.cancelled = cancelled;
+    report.histogram.fill(0, HistogramBuckets);
+    for (qint64 duration : std::as_const(durations)) {
+        report.totalTime += duration;
+        // 按微秒数的二进制位数分桶
+        qint64 us = duration / 1000;
+        int bucket = 0;
+        while (us > 0 && bucket < HistogramBuckets - 1) {
+            us >>= 1;
+            ++bucket;
+        }
+        ++report.histogram[bucket];
+    }
+
+    std::sort(durations.begin(), durations.end());
+    if (!durations.isEmpty()) {
+        report.p50 = durations[(durations.size() - 1) * 50 / 100];
+        report.p99 = durations[(durations.size() - 1) * 99 / 100];
+        report.max = durations.last();
+    }
+
+    report.startMatched = startMatched;
+    if (area) {
+        report.sizeMatched = area->size() == trace.widgetSize;
+        report.endHash = area->contentHash();
+        report.endMatched = !cancelled && report.endHash == trace.endHash;
+    }
+    emit finished(report);
+}
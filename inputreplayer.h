@@ -0,0 +1,81 @@
+#ifndef INPUTREPLAYER_H
+#define INPUTREPLAYER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+#include <QVector>
+#include "inputtrace.h"
+
+class PaintArea;
+
+/**
+ * @brief 把录制的输入重新送给绘图区域并测量每个事件的处理时间
+ *
+ * 事件通过QCoreApplication::sendEvent送达，与真实输入一样经过mousePressEvent/
+ * mouseMoveEvent/mouseReleaseEvent以及wheelEvent/keyPressEvent/keyReleaseEvent。
+ * 回放前先恢复录制开始时的缩放和偏移，无法恢复时拒绝回放。可以按录制时的节奏回放，也可以尽快回放；
+ * 两种方式下每个事件之间都会回到事件循环，重绘照常进行。
+ */
+class InputReplayer : public QObject
+{
+    Q_OBJECT  // Qt元对象系统宏
+
+public:
+    /**
+     * @brief 回放结果
+     */
+    struct Report {
+        int events = 0;  // 回放的事件数
+        qint64 wallTime = 0;  // 回放总耗时(纳秒)
+        qint64 totalTime = 0;  // 事件处理时间之和(纳秒)
+        qint64 p50 = 0;  // 处理时间中位数(纳秒)
+        qint64 p99 = 0;  // 处理时间99分位数(纳秒)
+        qint64 max = 0;  // 最长处理时间(纳秒)
+        QVector<int> histogram;  // 按处理时间分桶的事件数，见bucketLabel()
+        bool sizeMatched = false;  // 控件尺寸是否与录制时相同
+        bool startMatched = false;  // 回放前的绘制层是否与录制开始时相同
+        quint64 endHash = 0;  // 回放后绘制层的内容哈希
+        bool endMatched = false;  // 回放结果是否与录制结束时相同
+        bool cancelled = false;  // 是否被取消
+
+        QString toText() const;  // 多行文本形式的报告
+    };
+
+    static const int HistogramBuckets = 18;  // 直方图桶数：<1微秒、[1,2)、[2,4)……、>=65536微秒
+    static QString bucketLabel(int bucket);  // 直方图桶的时间范围
+
+    explicit InputReplayer(QObject *parent = nullptr);
+
+    /**
+     * @brief 开始回放
+     * @param area 目标绘图区域
+     * @param trace 录制的输入
+     * @param realtime true按录制时的节奏回放，false尽快回放
+     * @param error 失败时的原因(可为空)
+     * @return 已有回放在进行、录制为空或无法恢复录制时的视图时返回false
+     */
+    bool start(PaintArea *area, const InputTrace &trace, bool realtime, QString *error = nullptr);
+
+    void cancel();  // 取消回放，已回放的事件不会撤销
+    bool isRunning() const { return running; }  // 是否正在回放
+
+signals:
+    void finished(const InputReplayer::Report &report);  // 回放结束(包括被取消)
+
+private:
+    void replayNext();  // 送出所有到时的事件，然后等待下一个事件
+    void dispatch(const InputTrace::Event &event);  // 送出一个事件并记录处理时间
+    void finish(bool cancelled);  // 统计并发出结果
+
+    QPointer<PaintArea> area;  // 目标绘图区域
+    InputTrace trace;  // 正在回放的输入
+    bool realtime = false;  // 是否按录制时的节奏回放
+    bool running = false;  // 是否正在回放
+    bool startMatched = false;  // 回放前的绘制层是否与录制开始时相同
+    int next = 0;  // 下一个事件的下标
+    QElapsedTimer clock;  // 回放开始后的时间
+    QVector<qint64> durations;  // 每个事件的处理时间(纳秒)
+};
+
+#endif // INPUTREPLAYER_H
@@ -0,0 +1,186 @@
+#include "inputtrace.h"
+#include <QDataStream>
+#include <QFile>
+#include <limits>
+
+namespace {
+
+const quint32 Magic = 0x50545243;  // "PTRC"
+const quint16 Version = 5;  // 版本2在按下事件中增加了笔画简化/平滑设置，版本3增加了油漆桶容差，
+                            // 版本4增加了录制开始时的视图状态以及滚轮和按键事件，
+                            // 版本5的缩放比例按双精度保存(版本4为单精度)
+
+// 事件类型在文件中的编码
+enum EventCode : quint8 {
+    PressCode,
+    MoveCode,
+    ReleaseCode,
+    WheelCode,
+    KeyPressCode,
+    KeyReleaseCode
+};
+
+// 事件类型对应的编码
+quint8 eventCode(QEvent::Type type)
+{
+    switch (type) {
+    case QEvent::MouseButtonPress: return PressCode;
+    case QEvent::MouseButtonRelease: return ReleaseCode;
+    case QEvent::Wheel: return WheelCode;
+    case QEvent::KeyPress: return KeyPressCode;
+    case QEvent::KeyRelease: return KeyReleaseCode;
+    default: return MoveCode;
+    }
+}
+
+// 编码对应的事件类型
+QEvent::Type eventType(quint8 code)
+{
+    switch (code) {
+    case PressCode: return QEvent::MouseButtonPress;
+    case ReleaseCode: return QEvent::MouseButtonRelease;
+    case WheelCode: return QEvent::Wheel;
+    case KeyPressCode: return QEvent::KeyPress;
+    case KeyReleaseCode: return QEvent::KeyRelease;
+    default: return QEvent::MouseMove;
+    }
+}
+
+} // namespace
+
+// 保存到文件：时间按与上一事件的差值存储，只有按下事件带工具参数，滚轮和按键事件各带增量和键值
+bool InputTrace::save(const QString &fileName, QString *error) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    out << Magic << Version << widgetSize << startHash << endHash << quint8(fitToWindow);
+    // 缩放比例必须原样恢复：按单精度保存时坐标转换的取整会差一个像素
+    out.setFloatingPointPrecision(QDataStream::DoublePrecision);
+    out << zoom;
+    out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    out << qint32(offset.x()) << qint32(offset.y()) << qint32(events.size());
+
+    qint64 lastTime = 0;
+    for (const Event &event : events) {
+        quint8 code = eventCode(event.type);
+        out << code << quint32(qBound<qint64>(0, event.time - lastTime, std::numeric_limits<quint32>::max()))
+            << qint32(event.pos.x()) << qint32(event.pos.y())
+            << quint8(event.button) << quint8(event.buttons.toInt());
+        if (code == PressCode) {
+            out << quint8(event.tool) << quint32(event.color.rgba()) << quint16(event.width)
+                << float(event.tolerance) << quint8(event.smoothing) << quint8(event.fillTolerance);
+        } else if (code == WheelCode) {
+            out << qint32(event.delta);
+        } else if (code == KeyPressCode || code == KeyReleaseCode) {
+            out << quint32(event.key);
+        }
+        lastTime = event.time;
+    }
+
+    if (out.status() != QDataStream::Ok || !file.flush()) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+// 从文件读取
+bool InputTrace::load(const QString &fileName, QString *error)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    quint32 magic = 0;
+    quint16 version = 0;
+    qint32 count = 0;
+    in >> magic >> version;
+    if (magic != Magic || version < 1 || version > Version) {
+        if (error) *error = "不是输入录制文件或版本不受支持";
+        return false;
+    }
+    in >> widgetSize >> startHash >> endHash;
+    fitToWindow = true;
+    zoom = 1.0;
+    offset = QPoint();
+    if (version >= 4) {
+        quint8 fit;
+        qint32 offsetX, offsetY;
+        in >> fit;
+        if (version >= 5) in.setFloatingPointPrecision(QDataStream::DoublePrecision);
+        in >> zoom;
+        in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+        in >> offsetX >> offsetY;
+        fitToWindow = fit != 0;
+        offset = QPoint(offsetX, offsetY);
+    }
+    in >> count;
+
+    events.clear();
+    events.reserve(qMax(0, count));
+    qint64 time = 0;
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        quint8 code;
+        quint32 delta;
+        qint32 x, y;
+        quint8 button, buttons;
+        in >> code >> delta >> x >> y >> button >> buttons;
+
+        Event event;
+        event.type = eventType(code);
+        time += delta;
+        event.time = time;
+        event.pos = QPoint(x, y);
+        event.button = Qt::MouseButton(button);
+        event.buttons = Qt::MouseButtons::fromInt(buttons);
+        if (code == PressCode) {
+            quint8 tool;
+            quint32 rgba;
+            quint16 width;
+            in >> tool >> rgba >> width;
+            event.tool = tool;
+            event.color = QColor::fromRgba(rgba);
+            event.width = width;
+            if (version >= 2) {
+                float tolerance;
+                quint8 smoothing;
+                in >> tolerance >> smoothing;
+                event.tolerance = tolerance;
+                event.smoothing = smoothing != 0;
+            }
+            if (version >= 3) {
+                quint8 fillTolerance;
+                in >> fillTolerance;
+                event.fillTolerance = fillTolerance;
+            }
+        } else if (code == WheelCode) {
+            qint32 delta;
+            in >> delta;
+            event.delta = delta;
+        } else if (code == KeyPressCode || code == KeyReleaseCode) {
+            quint32 key;
+            in >> key;
+            event.key = int(key);
+        }
+        events.append(event);
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        if (error) *error = "录制文件已损坏";
+        events.clear();
+        return false;
+    }
+    return true;
+}
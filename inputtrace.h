@@ -0,0 +1,70 @@
+#ifndef INPUTTRACE_H
+#define INPUTTRACE_H
+
+#include <QColor>
+#include <QEvent>
+#include <QPoint>
+#include <QSize>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief 录制的鼠标输入序列
+ *
+ * 记录绘图区域收到的按下/移动/释放事件及其相对录制开始的时间，以及改变视图的滚轮缩放、
+ * 空格按下/松开和方向键平移；按下事件还记录当时的
+ * 绘图形状、画笔颜色、宽度、笔画简化/平滑设置和油漆桶容差。坐标为窗口坐标，另外保存录制时的控件尺寸，回放时以相同尺寸
+ * 重现坐标转换；录制开始时的缩放比例和偏移也一并保存，回放前先恢复。录制开始和结束时绘制层的内容哈希用于检查回放结果是否一致。
+ *
+ * 文件格式为QDataStream二进制：文件头之后每个事件只占十余字节。
+ */
+class InputTrace {
+public:
+    /**
+     * @brief 一个输入事件
+     */
+    struct Event {
+        QEvent::Type type = QEvent::MouseMove;  // 鼠标按下、移动、释放，滚轮，或按键按下、松开
+        qint64 time = 0;  // 相对录制开始的时间(微秒)
+        QPoint pos;  // 窗口坐标(鼠标和滚轮事件)
+        Qt::MouseButton button = Qt::NoButton;  // 触发事件的按键
+        Qt::MouseButtons buttons = Qt::NoButton;  // 事件发生时按下的按键
+        int tool = 0;  // 绘图形状(PaintArea::DrawShape，仅按下事件)
+        QColor color;  // 画笔颜色(仅按下事件)
+        int width = 0;  // 画笔宽度(仅按下事件)
+        double tolerance = 0;  // 笔画简化容差(仅按下事件)
+        bool smoothing = false;  // 笔画是否平滑(仅按下事件)
+        int fillTolerance = 32;  // 油漆桶颜色容差(仅按下事件，旧版本文件为默认值)
+        int delta = 0;  // 滚轮的纵向角度增量(仅滚轮事件)
+        int key = 0;  // 按键(Qt::Key，仅按键事件)
+    };
+
+    QSize widgetSize;  // 录制时的控件尺寸
+    bool fitToWindow = true;  // 录制开始时是否为适应窗口(旧版本文件没有缩放，总是适应窗口)
+    double zoom = 1.0;  // 录制开始时的缩放比例
+    QPoint offset;  // 录制开始时画布在窗口中的偏移
+    quint64 startHash = 0;  // 录制开始时绘制层的内容哈希
+    quint64 endHash = 0;  // 录制结束时绘制层的内容哈希
+    QVector<Event> events;  // 按时间顺序的事件
+
+    bool isEmpty() const { return events.isEmpty(); }
+    qint64 duration() const { return events.isEmpty() ? 0 : events.last().time; }  // 总时长(微秒)
+
+    /**
+     * @brief 保存到文件
+     * @param fileName 文件名
+     * @param error 失败时的错误信息
+     * @return 是否成功
+     */
+    bool save(const QString &fileName, QString *error = nullptr) const;
+
+    /**
+     * @brief 从文件读取
+     * @param fileName 文件名
+     * @param error 失败时的错误信息
+     * @return 是否成功
+     */
+    bool load(const QString &fileName, QString *error = nullptr);
+};
+
+#endif // INPUTTRACE_H
@@ -0,0 +1,299 @@
+#include "layerstack.h"
+
+// 构造函数：只有一个绘制层
+LayerStack::LayerStack()
+{
+    Layer document;
+    document.name = "绘制层";
+    document.document = true;
+    layers.append(document);
+}
+
+// 改变所有图层的尺寸，缓存随之重建
+void LayerStack::resize(const QSize &size)
+{
+    if (size == canvasSize) return;
+
+    canvasSize = size;
+    for (Layer &layer : layers) {
+        if (!layer.document) layer.canvas.resize(size);
+    }
+    belowCache = TiledCanvas(size);
+    aboveCache = TiledCanvas(size);
+    belowValid = QBitArray(belowCache.tileCount());
+    aboveValid = QBitArray(aboveCache.tileCount());
+}
+
+// 设置背景：只比较cacheKey，同一张图像重复设置不会使缓存失效
+void LayerStack::setBackground(const QImage &image)
+{
+    if (image.cacheKey() == background.cacheKey()) return;
+
+    background = image;
+    invalidateBelow();
+}
+
+// 绘制层的下标
+int LayerStack::documentIndex() const
+{
+    for (int i = 0; i < layers.size(); ++i) {
+        if (layers[i].document) return i;
+    }
+    return 0;
+}
+
+// 是否只有默认属性的绘制层
+bool LayerStack::isTrivial() const
+{
+    const Layer &document = documentLayer();
+    return layers.size() == 1 && document.visible && document.opacity >= 1.0 &&
+           document.mode == QPainter::CompositionMode_SourceOver;
+}
+
+// 在最上方加入一个栅格图层
+int LayerStack::addLayer(const QString &name, const QImage &image)
+{
+    Layer layer;
+    layer.name = name;
+    layer.canvas = TiledCanvas(canvasSize);
+    layer.canvas.writeImage(QPoint(0, 0), image);
+    layer.canvas.clearDirty();
+    layers.append(layer);
+
+    int index = layers.size() - 1;
+    invalidateAt(index);
+    return index;
+}
+
+// 删除图层
+void LayerStack::removeLayer(int index)
+{
+    if (index < 0 || index >= layers.size() || layers[index].document) return;
+
+    invalidateAt(index);
+    layers.remove(index);
+}
+
+// 把图层移动到新的位置：移动的可能是绘制层，两侧的缓存都要重建
+void LayerStack::moveLayer(int from, int to)
+{
+    if (from < 0 || from >= layers.size() || to < 0 || to >= layers.size() || from == to) return;
+
+    layers.move(from, to);
+    invalidateBelow();
+    invalidateAbove();
+}
+
+// 设置图层是否可见
+void LayerStack::setVisible(int index, bool visible)
+{
+    if (layers[index].visible == visible) return;
+    layers[index].visible = visible;
+    invalidateAt(index);
+}
+
+// 设置图层不透明度
+void LayerStack::setOpacity(int index, qreal opacity)
+{
+    opacity = qBound(0.0, opacity, 1.0);
+    if (layers[index].opacity == opacity) return;
+    layers[index].opacity = opacity;
+    invalidateAt(index);
+}
+
+// 设置图层混合模式
+void LayerStack::setBlendMode(int index, QPainter::CompositionMode mode)
+{
+    if (layers[index].mode == mode) return;
+    layers[index].mode = mode;
+    invalidateAt(index);
+}
+
+// 替换所有图层，栅格图层调整为画布尺寸
+void LayerStack::setLayers(const QVector<Layer> &newLayers)
+{
+    int documents = 0;
+    for (const Layer &layer : newLayers) {
+        if (layer.document) ++documents;
+    }
+    if (documents != 1) return;
+
+    layers = newLayers;
+    for (Layer &layer : layers) {
+        if (layer.document) {
+            layer.canvas = TiledCanvas();
+        } else if (layer.canvas.size() != canvasSize) {
+            layer.canvas.resize(canvasSize);
+        }
+    }
+    invalidateBelow();
+    invalidateAbove();
+}
+
+// 绘制层之下是否有可见的栅格图层
+bool LayerStack::hasLayersBelow() const
+{
+    for (int i = 0; i < documentIndex(); ++i) {
+        if (layers[i].visible) return true;
+    }
+    return false;
+}
+
+// 绘制层之上是否有可见的栅格图层
+bool LayerStack::hasLayersAbove() const
+{
+    for (int i = documentIndex() + 1; i < layers.size(); ++i) {
+        if (layers[i].visible) return true;
+    }
+    return false;
+}
+
+// 上方可见图层是否都是普通混合模式：只有源覆盖可以先合并再混合到下方
+bool LayerStack::isAboveCacheable() const
+{
+    for (int i = documentIndex() + 1; i < layers.size(); ++i) {
+        if (layers[i].visible && layers[i].mode != QPainter::CompositionMode_SourceOver) return false;
+    }
+    return true;
+}
+
+// 获取绘制层之下的合成缓存
+const TiledCanvas &LayerStack::below(const QRect &area)
+{
+    rebuild(belowCache, belowValid, area, 0, documentIndex() - 1, true);
+    return belowCache;
+}
+
+// 获取绘制层之上的合成缓存
+const TiledCanvas &LayerStack::above(const QRect &area)
+{
+    rebuild(aboveCache, aboveValid, area, documentIndex() + 1, layers.size() - 1, false);
+    return aboveCache;
+}
+
+// 不使用缓存，逐层绘制整个图层栈：每个图层都要在区域内混合一次
+void LayerStack::render(QPainter &painter, const QRect &area, const QImage &backgroundImage,
+                        const TiledCanvas &document) const
+{
+    if (!backgroundImage.isNull()) {
+        painter.drawImage(area.topLeft(), backgroundImage, area);
+    }
+    for (const Layer &layer : layers) {
+        if (!layer.visible) continue;
+        drawCanvas(painter, layer.document ? document : layer.canvas, area, layer.opacity, layer.mode);
+    }
+}
+
+// 使用缓存绘制：下方缓存、绘制层、上方缓存，无论有多少图层都只混合三次
+void LayerStack::renderCached(QPainter &painter, const QRect &area, const TiledCanvas &document)
+{
+    const QPainter::CompositionMode normal = QPainter::CompositionMode_SourceOver;
+    drawCanvas(painter, below(area), area, 1.0, normal);
+
+    const Layer &documentLayer = layers[documentIndex()];
+    if (documentLayer.visible) {
+        drawCanvas(painter, document, area, documentLayer.opacity, documentLayer.mode);
+    }
+
+    if (!isAboveCacheable()) {
+        for (int i = documentIndex() + 1; i < layers.size(); ++i) {
+            if (layers[i].visible) drawCanvas(painter, layers[i].canvas, area, layers[i].opacity, layers[i].mode);
+        }
+        return;
+    }
+    drawCanvas(painter, above(area), area, 1.0, normal);
+}
+
+// 把图层栈合成为一张图像
+QImage LayerStack::flatten(const QImage &backgroundImage, const TiledCanvas &document,
+                           const QColor &base) const
+{
+    QImage result(document.size(), QImage::Format_ARGB32_Premultiplied);
+    if (result.isNull()) return result;
+    result.fill(backgroundImage.isNull() ? base : QColor(Qt::transparent));
+
+    QPainter painter(&result);
+    render(painter, document.rect(), backgroundImage, document);
+    return result;
+}
+
+// 按不透明度和混合模式绘制画布中与区域相交的图块，未分配的图块是透明的，
+// 对提供的几种混合模式都不改变目标，直接跳过
+void LayerStack::drawCanvas(QPainter &painter, const TiledCanvas &canvas, const QRect &area,
+                            qreal opacity, QPainter::CompositionMode mode)
+{
+    if (opacity <= 0.0) return;
+
+    painter.save();
+    painter.setOpacity(opacity);
+    painter.setCompositionMode(mode);
+    for (int index : canvas.tilesIn(area)) {
+        if (!canvas.hasTile(index)) continue;
+
+        QRect tileArea = canvas.tileRect(index);
+        QRect part = area.intersected(tileArea).intersected(canvas.rect());
+        painter.drawImage(part.topLeft(), canvas.tile(index), part.translated(-tileArea.topLeft()));
+    }
+    painter.restore();
+}
+
+// 下方缓存全部失效
+void LayerStack::invalidateBelow()
+{
+    belowValid.fill(false);
+}
+
+// 上方缓存全部失效
+void LayerStack::invalidateAbove()
+{
+    aboveValid.fill(false);
+}
+
+// 图层属性改变时只需重建它所在一侧的缓存；绘制层本身不在任何缓存中
+void LayerStack::invalidateAt(int index)
+{
+    int document = documentIndex();
+    if (index < document) {
+        invalidateBelow();
+    } else if (index > document) {
+        invalidateAbove();
+    }
+}
+
+// 重建缓存中区域内失效的图块：所有图层图块对齐，逐图块把[first, last]中的图层依次混合；
+// 下方缓存没有背景时先铺底色，非普通混合模式的结果才与flatten()直接混合到底色上一致
+void LayerStack::rebuild(TiledCanvas &cache, QBitArray &valid, const QRect &area, int first, int last,
+                         bool withBackground)
+{
+    for (int index : cache.tilesIn(area)) {
+        if (valid.testBit(index)) continue;
+        valid.setBit(index);
+
+        QRect tileArea = cache.tileRect(index);
+        QImage tile = TiledCanvas::createTile();
+        bool painted = false;
+        {
+            QPainter painter(&tile);
+            painter.translate(-tileArea.topLeft());
+            if (withBackground && !background.isNull()) {
+                painter.drawImage(tileArea.topLeft(), background, tileArea);
+                painted = true;
+            }
+            for (int i = first; i <= last; ++i) {
+                const Layer &layer = layers[i];
+                if (!layer.visible || !layer.canvas.hasTile(index)) continue;
+
+                if (withBackground && !painted) {
+                    painter.fillRect(tileArea, QColor::fromRgba(BaseColor));
+                    painted = true;
+                }
+                painter.setOpacity(layer.opacity);
+                painter.setCompositionMode(layer.mode);
+                painter.drawImage(tileArea.topLeft(), layer.canvas.tile(index));
+                painted = true;
+            }
+        }
+        cache.setTile(index, painted ? tile : QImage());
+    }
+    cache.clearDirty();  // 缓存不参与历史记录
+}
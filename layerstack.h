@@ -0,0 +1,127 @@
+#ifndef LAYERSTACK_H
+#define LAYERSTACK_H
+
+#include <QBitArray>
+#include <QImage>
+#include <QPainter>
+#include <QRect>
+#include <QSize>
+#include <QString>
+#include <QVector>
+#include "tiledcanvas.h"
+
+/**
+ * @brief 图层栈：背景之上按顺序叠放的图层，其中一层是文档的绘制层
+ *
+ * 绘制层的像素、形状和历史仍由PaintArea管理，图层栈只记录它的位置和显示属性；
+ * 其余图层是导入的栅格图层。每层可以隐藏、调整不透明度和混合模式，所有图层与画布等大、图块对齐。
+ *
+ * 图层栈缓存两张合成图：绘制层之下(含背景)的所有图层，以及绘制层之上的所有图层。
+ * 绘制时只需混合"下方缓存、绘制层、上方缓存"三个缓冲，与图层数量无关。
+ * 缓存按图块失效，只在被请求的区域内重建。上方缓存要求上方图层都是普通混合模式
+ * (源覆盖满足结合律，可以预先合并)，否则上方图层需要逐层绘制。
+ */
+class LayerStack {
+public:
+    /**
+     * @brief 一个图层
+     */
+    struct Layer {
+        QString name;  // 图层名称
+        TiledCanvas canvas;  // 图层像素(绘制层为空，像素在PaintArea中)
+        bool document = false;  // 是否为文档的绘制层
+        bool visible = true;  // 是否可见
+        qreal opacity = 1.0;  // 不透明度(0-1)
+        QPainter::CompositionMode mode = QPainter::CompositionMode_SourceOver;  // 混合模式
+    };
+
+    static const QRgb BaseColor = 0xffffffff;  // 没有背景时下方缓存的底色，与窗口和保存时铺的白色一致
+
+    LayerStack();
+
+    void resize(const QSize &size);  // 改变所有图层的尺寸，保留重叠部分
+    void setBackground(const QImage &background);  // 设置背景，图像变化时下方缓存失效
+
+    int count() const { return layers.size(); }  // 图层数(含绘制层)
+    const Layer &layer(int index) const { return layers.at(index); }  // 获取图层，下标0为最底层
+    int documentIndex() const;  // 绘制层的下标
+    const Layer &documentLayer() const { return layers.at(documentIndex()); }  // 绘制层
+    bool isTrivial() const;  // 是否只有默认属性的绘制层(可以直接按背景+绘制层合成)
+
+    /**
+     * @brief 在最上方加入一个栅格图层
+     * @param name 图层名称
+     * @param image 图层内容，从左上角开始放置，超出画布的部分被裁掉
+     * @return 新图层的下标
+     */
+    int addLayer(const QString &name, const QImage &image);
+    void removeLayer(int index);  // 删除图层(绘制层不能删除)
+    void moveLayer(int from, int to);  // 把图层移动到新的位置
+    void setVisible(int index, bool visible);  // 设置图层是否可见
+    void setOpacity(int index, qreal opacity);  // 设置图层不透明度
+    void setBlendMode(int index, QPainter::CompositionMode mode);  // 设置图层混合模式
+    void setLayers(const QVector<Layer> &layers);  // 替换所有图层(必须恰好包含一个绘制层)
+    QVector<Layer> allLayers() const { return layers; }  // 所有图层(图块隐式共享)
+
+    bool hasLayersBelow() const;  // 绘制层之下是否有可见的栅格图层
+    bool hasLayersAbove() const;  // 绘制层之上是否有可见的栅格图层
+    bool isAboveCacheable() const;  // 上方可见图层是否都是普通混合模式
+
+    /**
+     * @brief 获取绘制层之下(含背景)的合成缓存，先重建区域内失效的图块
+     * @param area 需要使用的区域(画布坐标)
+     */
+    const TiledCanvas &below(const QRect &area);
+
+    /**
+     * @brief 获取绘制层之上的合成缓存，先重建区域内失效的图块；只在isAboveCacheable()时有效
+     * @param area 需要使用的区域(画布坐标)
+     */
+    const TiledCanvas &above(const QRect &area);
+
+    /**
+     * @brief 不使用缓存，逐层绘制区域内的整个图层栈
+     * @param painter 画布坐标的绘制器(调用者负责目标的初始内容)
+     * @param area 需要绘制的区域
+     * @param background 背景平面(可以为空)
+     * @param document 绘制层
+     */
+    void render(QPainter &painter, const QRect &area, const QImage &background,
+                const TiledCanvas &document) const;
+
+    /**
+     * @brief 使用缓存绘制区域：下方缓存、绘制层、上方缓存三次混合
+     */
+    void renderCached(QPainter &painter, const QRect &area, const TiledCanvas &document);
+
+    /**
+     * @brief 把图层栈合成为一张图像(用于保存)
+     * @param background 背景平面(可以为空)
+     * @param document 绘制层
+     * @param base 没有背景时的底色
+     */
+    QImage flatten(const QImage &background, const TiledCanvas &document, const QColor &base) const;
+
+    /**
+     * @brief 按图层的不透明度和混合模式绘制画布中与区域相交的图块
+     */
+    static void drawCanvas(QPainter &painter, const TiledCanvas &canvas, const QRect &area,
+                           qreal opacity, QPainter::CompositionMode mode);
+
+private:
+    void invalidateBelow();  // 下方缓存全部失效
+    void invalidateAbove();  // 上方缓存全部失效
+    void invalidateAt(int index);  // 按图层所在的一侧使对应缓存失效
+    void rebuild(TiledCanvas &cache, QBitArray &valid, const QRect &area, int first, int last,
+                 bool withBackground);  // 重建缓存中区域内失效的图块
+
+    QVector<Layer> layers;  // 从下到上的图层
+    QSize canvasSize;  // 画布尺寸
+    QImage background;  // 背景平面(与PaintArea共享数据)
+    TiledCanvas belowCache;  // 绘制层之下的合成缓存
+    TiledCanvas aboveCache;  // 绘制层之上的合成缓存
+    QBitArray belowValid;  // 下方缓存中有效的图块
+    QBitArray aboveValid;  // 上方缓存中有效的图块
+};
+
+#endif // LAYERSTACK_H
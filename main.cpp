@@ -1,8 +1,99 @@
 #include "mainwindow.h"
+#include "batchrenderer.h"
+#include "inputreplayer.h"
+#include "profiler.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QGuiApplication>
 #include <QStyleFactory>
+#include <QTextStream>
 #include <QPalette>
 
+/**
+ * @brief 无界面批量渲染模式，不创建任何窗口
+ * @param argc 命令行参数个数
+ * @param argv 命令行参数数组
+ * @return 全部脚本渲染成功时返回0
+ */
+static int runBatch(int argc, char *argv[])
+{
+    // 未指定平台插件时使用offscreen，无需显示服务器
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("按形状脚本批量渲染图像");
+    parser.addHelpOption();
+    QCommandLineOption batchOption("batch", "以无界面批量渲染模式运行");
+    QCommandLineOption outputOption(QStringList() << "o" << "output-dir",
+                                    "脚本未指定输出文件时的输出目录", "dir");
+    QCommandLineOption threadsOption(QStringList() << "j" << "threads",
+                                     "并行渲染的线程数(默认为CPU核心数)", "n");
+    parser.addOption(batchOption);
+    parser.addOption(outputOption);
+    parser.addOption(threadsOption);
+    parser.addPositionalArgument("scripts", "形状脚本(.json或文本格式)", "scripts...");
+    parser.process(app);
+
+    if (parser.positionalArguments().isEmpty()) {
+        parser.showHelp(1);
+    }
+
+    BatchRenderer::Options options;
+    options.outputDir = parser.value(outputOption);
+    options.threads = parser.value(threadsOption).toInt();
+    return BatchRenderer(options).run(parser.positionalArguments());
+}
+
+/**
+ * @brief 无界面回放录制的输入，报告每个事件的处理时间和最终画布哈希
+ * @param argc 命令行参数个数
+ * @param argv 命令行参数数组
+ * @return 回放结果与录制结果一致时返回0
+ */
+static int runReplay(int argc, char *argv[])
+{
+    // 未指定平台插件时使用offscreen，无需显示服务器
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("回放录制的鼠标输入并测量处理延迟");
+    parser.addHelpOption();
+    QCommandLineOption replayOption("replay", "回放的录制文件", "trace");
+    QCommandLineOption realtimeOption("realtime", "按录制时的节奏回放(默认尽快回放)");
+    parser.addOption(replayOption);
+    parser.addOption(realtimeOption);
+    parser.process(app);
+
+    InputTrace trace;
+    QString error;
+    if (!trace.load(parser.value(replayOption), &error)) {
+        QTextStream(stderr) << parser.value(replayOption) << ": " << error << Qt::endl;
+        return 1;
+    }
+
+    // 空白画布，控件尺寸与录制时相同，坐标转换结果一致
+    PaintArea area;
+    area.resize(trace.widgetSize);
+    area.show();
+
+    InputReplayer replayer;
+    QObject::connect(&replayer, &InputReplayer::finished, [&app](const InputReplayer::Report &report) {
+        QTextStream(stdout) << report.toText() << Qt::endl;
+        app.exit(report.endMatched ? 0 : 1);
+    });
+    if (!replayer.start(&area, trace, parser.isSet(realtimeOption), &error)) {
+        QTextStream(stderr) << (error.isEmpty() ? QString("录制文件中没有事件") : error) << Qt::endl;
+        return 1;
+    }
+    return app.exec();
+}
+
 /**
  * @brief 应用程序的主入口函数
  * @param argc 命令行参数个数
@@ -11,6 +102,16 @@
  */
 int main(int argc, char *argv[])
 {
+    // 带--batch参数时进入无界面批量渲染模式，带--replay参数时无界面回放录制的输入
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--batch") == 0) {
+            return runBatch(argc, argv);
+        }
+        if (qstrcmp(argv[i], "--replay") == 0) {
+            return runReplay(argc, argv);
+        }
+    }
+
     // 创建Qt应用程序实例
     QApplication a(argc, argv);
 
@@ -55,5 +156,15 @@ int main(int argc, char *argv[])
     w.show();
 
     // 进入主事件循环
-    return a.exec();
+    int result = a.exec();
+
+    // PAINTPROJECT_PROFILE指定了.json文件时写出性能跟踪
+    QString traceFile = Profiler::environmentTraceFile();
+    if (!traceFile.isEmpty() && Profiler::isEnabled()) {
+        QString error;
+        if (!Profiler::writeTrace(traceFile, &error)) {
+            qWarning("无法写入性能跟踪 %s: %s", qPrintable(traceFile), qPrintable(error));
+        }
+    }
+    return result;
 }
@@ -12,10 +12,38 @@
 #include <QToolButton>
 #include <QStatusBar>
 #include <QMessageBox>
+#include <QInputDialog>
+#include <QFileInfo>
+#include <QDockWidget>
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+#include "profiler.h"
+
+namespace {
+
+/**
+ * @brief 图层面板中可选的混合模式
+ */
+struct BlendModeEntry {
+    const char *name;  // 显示名称
+    QPainter::CompositionMode mode;  // 对应的合成模式
+};
+
+const BlendModeEntry BlendModes[] = {
+    {"正常", QPainter::CompositionMode_SourceOver},
+    {"正片叠底", QPainter::CompositionMode_Multiply},
+    {"滤色", QPainter::CompositionMode_Screen},
+    {"叠加", QPainter::CompositionMode_Overlay},
+    {"变暗", QPainter::CompositionMode_Darken},
+    {"变亮", QPainter::CompositionMode_Lighten},
+    {"差值", QPainter::CompositionMode_Difference},
+};
+
+} // namespace
 
 // 主窗口构造函数
 MainWindow::MainWindow(QWidget *parent)
-    : QMainWindow(parent), currentColor(Qt::black)  // 初始化父类和当前颜色(默认为黑色)
+    : QMainWindow(parent), currentColor(Qt::black), updatingLayers(false)  // 初始化父类和当前颜色(默认为黑色)
 {
     setWindowTitle("绘图工具");  // 设置窗口标题
     resize(1256, 800);          // 设置窗口初始大小
@@ -27,10 +55,38 @@ MainWindow::MainWindow(QWidget *parent)
     // 初始化UI组件
     createToolBar();    // 创建工具栏
     createStatusBar();  // 创建状态栏
+    createLayerDock();  // 创建图层面板
 
     // 连接信号槽：当绘图区域光标位置改变时，更新状态栏显示
     connect(paintArea, &PaintArea::cursorPositionChanged,
             this, &MainWindow::updateCursorPosition);
+    // 连接信号槽：缩放比例改变时更新状态栏显示
+    connect(paintArea, &PaintArea::zoomChanged,
+            this, &MainWindow::updateZoomLabel);
+    // 连接信号槽：后台保存的进度和结果显示在状态栏
+    connect(paintArea, &PaintArea::saveProgressChanged,
+            saveProgressBar, &QProgressBar::setValue);
+    connect(paintArea, &PaintArea::saveFinished,
+            this, &MainWindow::onSaveFinished);
+    // 连接信号槽：后台加载结束时更新状态栏
+    connect(paintArea, &PaintArea::loadFinished,
+            this, &MainWindow::onLoadFinished);
+    // 连接信号槽：图层改变时刷新图层面板
+    connect(paintArea, &PaintArea::layersChanged,
+            this, &MainWindow::refreshLayerList);
+
+    // 输入回放结束时显示延迟报告
+    replayer = new InputReplayer(this);
+    connect(replayer, &InputReplayer::finished,
+            this, &MainWindow::onReplayFinished);
+
+    // 性能统计开启时定时刷新状态栏；设置了PAINTPROJECT_PROFILE时启动即开启
+    profileTimer = new QTimer(this);
+    profileTimer->setInterval(500);
+    connect(profileTimer, &QTimer::timeout, this, &MainWindow::updateProfileLabel);
+    Profiler::enableFromEnvironment();
+    profileAction->setChecked(Profiler::isEnabled());
+    toggleProfiling(Profiler::isEnabled());
 }
 
 // 创建工具栏函数
@@ -47,7 +103,7 @@ void MainWindow::createToolBar()
     // 创建"打开"动作
     QAction *openAction = new QAction(style()->standardIcon(QStyle::SP_DialogOpenButton), "  打开  ", this);
     openAction->setShortcut(QKeySequence::Open);  // 设置快捷键(Ctrl+O)
-    openAction->setStatusTip("打开图像文件");     // 设置状态栏提示
+    openAction->setStatusTip("打开图像或工程文件");     // 设置状态栏提示
     connect(openAction, &QAction::triggered, this, &MainWindow::openImage);  // 连接信号槽
 
     // 创建"保存"动作
@@ -74,9 +130,76 @@ void MainWindow::createToolBar()
     redoAction->setStatusTip("重做上一步撤销的操作");  // 设置状态栏提示
     connect(redoAction, &QAction::triggered, this, &MainWindow::redo);  // 连接信号槽
 
+    // 创建"矢量历史"动作(可勾选)，切换为记录形状命令的历史模式
+    QAction *historyModeAction = new QAction(style()->standardIcon(QStyle::SP_FileDialogDetailedView), "矢量历史", this);
+    historyModeAction->setCheckable(true);
+    historyModeAction->setStatusTip("记录形状命令并定期保存检查点，历史几乎不受内存限制");  // 设置状态栏提示
+    connect(historyModeAction, &QAction::toggled, this, &MainWindow::toggleHistoryMode);  // 连接信号槽
+
     // 将动作添加到工具栏
     mainToolBar->addAction(undoAction);
     mainToolBar->addAction(redoAction);
+    mainToolBar->addAction(historyModeAction);
+    mainToolBar->addSeparator();  // 添加分隔线
+
+    // 视图操作组 ==============================================
+    // 创建"放大"/"缩小"动作，以窗口中心缩放(滚轮以光标为中心缩放)
+    QAction *zoomInAction = new QAction(style()->standardIcon(QStyle::SP_ArrowUp), "  放大  ", this);
+    zoomInAction->setShortcut(QKeySequence::ZoomIn);  // 设置快捷键(Ctrl++)
+    zoomInAction->setStatusTip("放大视图(最大800%)；也可用滚轮以光标为中心缩放");  // 设置状态栏提示
+    connect(zoomInAction, &QAction::triggered, paintArea, &PaintArea::zoomIn);  // 连接信号槽
+
+    QAction *zoomOutAction = new QAction(style()->standardIcon(QStyle::SP_ArrowDown), "  缩小  ", this);
+    zoomOutAction->setShortcut(QKeySequence::ZoomOut);  // 设置快捷键(Ctrl+-)
+    zoomOutAction->setStatusTip("缩小视图(最小5%)");  // 设置状态栏提示
+    connect(zoomOutAction, &QAction::triggered, paintArea, &PaintArea::zoomOut);  // 连接信号槽
+
+    // 创建"适应窗口"和"原尺寸"动作
+    QAction *zoomFitAction = new QAction(style()->standardIcon(QStyle::SP_TitleBarMaxButton), "适应窗口", this);
+    zoomFitAction->setShortcut(QKeySequence("Ctrl+0"));  // 设置快捷键
+    zoomFitAction->setStatusTip("缩放到完整显示画布；缩放后可用中键或按住空格拖动、方向键平移");  // 设置状态栏提示
+    connect(zoomFitAction, &QAction::triggered, paintArea, &PaintArea::zoomToFit);  // 连接信号槽
+
+    QAction *zoomActualAction = new QAction(style()->standardIcon(QStyle::SP_TitleBarNormalButton), "原尺寸", this);
+    zoomActualAction->setShortcut(QKeySequence("Ctrl+1"));  // 设置快捷键
+    zoomActualAction->setStatusTip("按100%显示画布");  // 设置状态栏提示
+    connect(zoomActualAction, &QAction::triggered, paintArea, &PaintArea::zoomActualSize);  // 连接信号槽
+
+    // 将动作添加到工具栏
+    mainToolBar->addAction(zoomInAction);
+    mainToolBar->addAction(zoomOutAction);
+    mainToolBar->addAction(zoomFitAction);
+    mainToolBar->addAction(zoomActualAction);
+    mainToolBar->addSeparator();  // 添加分隔线
+
+    // 诊断工具组 ==============================================
+    // 创建"录制"动作(可勾选)，记录鼠标输入用于重现卡顿
+    recordAction = new QAction(style()->standardIcon(QStyle::SP_DialogYesButton), "  录制  ", this);
+    recordAction->setCheckable(true);
+    recordAction->setStatusTip("录制鼠标输入，结束时保存为录制文件");  // 设置状态栏提示
+    connect(recordAction, &QAction::toggled, this, &MainWindow::toggleRecording);  // 连接信号槽
+
+    // 创建"回放"动作
+    replayAction = new QAction(style()->standardIcon(QStyle::SP_MediaPlay), "  回放  ", this);
+    replayAction->setStatusTip("回放录制的输入并报告每个事件的处理时间");  // 设置状态栏提示
+    connect(replayAction, &QAction::triggered, this, &MainWindow::replayInput);  // 连接信号槽
+
+    // 创建"性能"动作(可勾选)，统计各阶段耗时并显示在状态栏
+    profileAction = new QAction(style()->standardIcon(QStyle::SP_ComputerIcon), "  性能  ", this);
+    profileAction->setCheckable(true);
+    profileAction->setStatusTip("统计事件处理、预览、合成、历史和保存/加载的耗时");  // 设置状态栏提示
+    connect(profileAction, &QAction::toggled, this, &MainWindow::toggleProfiling);  // 连接信号槽
+
+    // 创建"导出跟踪"动作
+    exportTraceAction = new QAction(style()->standardIcon(QStyle::SP_FileDialogContentsView), "导出跟踪", this);
+    exportTraceAction->setStatusTip("把记录的耗时导出为Chrome跟踪文件(chrome://tracing)");  // 设置状态栏提示
+    connect(exportTraceAction, &QAction::triggered, this, &MainWindow::exportTrace);  // 连接信号槽
+
+    // 将动作添加到工具栏
+    mainToolBar->addAction(recordAction);
+    mainToolBar->addAction(replayAction);
+    mainToolBar->addAction(profileAction);
+    mainToolBar->addAction(exportTraceAction);
     mainToolBar->addSeparator();  // 添加分隔线
 
     // 绘图工具组 ==============================================
@@ -87,7 +210,7 @@ void MainWindow::createToolBar()
 
     // 创建形状选择下拉框
     shapeComboBox = new QComboBox(this);
-    shapeComboBox->addItems({"自由绘制", "直线", "矩形", "椭圆", "箭头", "五角星", "菱形", "心形", "橡皮擦", "编组选择"});  // 添加各种绘图工具选项
+    shapeComboBox->addItems({"自由绘制", "直线", "矩形", "椭圆", "箭头", "五角星", "菱形", "心形", "橡皮擦", "编组选择", "油漆桶"});  // 添加各种绘图工具选项
     shapeComboBox->setFixedWidth(120);  // 设置固定宽度
     shapeComboBox->setSizeAdjustPolicy(QComboBox::AdjustToContents);  // 设置大小调整策略
     // 连接下拉框选择变化信号到槽函数
@@ -116,6 +239,45 @@ void MainWindow::createToolBar()
 
     mainToolBar->addWidget(sizeSpinBox);  // 将选择框添加到工具栏
 
+    // 添加"笔画简化"标签
+    QLabel *toleranceLabel = new QLabel("    笔画简化:  ", this);
+    toleranceLabel->setStyleSheet("QLabel { color: #555; }");  // 设置标签样式(灰色文字)
+    mainToolBar->addWidget(toleranceLabel);
+
+    // 创建笔画简化容差调节框(自由绘制和橡皮擦)
+    toleranceSpinBox = new QDoubleSpinBox(this);
+    toleranceSpinBox->setRange(0.0, 5.0);     // 设置范围(0为不简化)
+    toleranceSpinBox->setSingleStep(0.25);    // 设置步长
+    toleranceSpinBox->setValue(0.5);          // 设置默认值(只省略共线的采样点)
+    toleranceSpinBox->setSuffix(" px");       // 设置后缀
+    toleranceSpinBox->setFixedWidth(80);      // 设置固定宽度
+    toleranceSpinBox->setToolTip("省略与笔画偏差不超过该距离的鼠标采样点");  // 设置工具提示
+    connect(toleranceSpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
+            this, &MainWindow::changeStrokeTolerance);
+    mainToolBar->addWidget(toleranceSpinBox);
+
+    // 创建"平滑"动作(可勾选)，自由绘制的笔画连成样条曲线
+    smoothAction = new QAction("平滑", this);
+    smoothAction->setCheckable(true);
+    smoothAction->setStatusTip("把自由绘制的笔画连成经过所有点的平滑曲线");  // 设置状态栏提示
+    connect(smoothAction, &QAction::toggled, this, &MainWindow::toggleSmoothing);  // 连接信号槽
+    mainToolBar->addAction(smoothAction);
+
+    // 添加"填充容差"标签
+    QLabel *fillLabel = new QLabel("    填充容差:  ", this);
+    fillLabel->setStyleSheet("QLabel { color: #555; }");  // 设置标签样式(灰色文字)
+    mainToolBar->addWidget(fillLabel);
+
+    // 创建油漆桶颜色容差调节框
+    fillToleranceSpinBox = new QSpinBox(this);
+    fillToleranceSpinBox->setRange(0, 255);      // 设置范围(0为只填充完全相同的颜色)
+    fillToleranceSpinBox->setValue(32);          // 设置默认值(包含抗锯齿边缘附近的相近颜色)
+    fillToleranceSpinBox->setFixedWidth(60);     // 设置固定宽度
+    fillToleranceSpinBox->setToolTip("油漆桶填充颜色各通道与点击处相差不超过该值的连通区域");  // 设置工具提示
+    connect(fillToleranceSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &MainWindow::changeFillTolerance);
+    mainToolBar->addWidget(fillToleranceSpinBox);
+
     // 添加"画笔颜色"标签
     QLabel *colorLabel = new QLabel("    画笔颜色:  ", this);
     colorLabel->setStyleSheet("QLabel { color: #555; }");  // 设置标签样式(灰色文字)
@@ -148,15 +310,207 @@ void MainWindow::createStatusBar()
     shapeInfoLabel->setStyleSheet("QLabel { padding: 2px 8px; }");  // 设置内边距
 
     // 创建缩放比例标签
-    zoomLabel = new QLabel("缩放: 100%", this);
+    zoomLabel = new QLabel(this);
+    updateZoomLabel(paintArea->zoom());
     zoomLabel->setStyleSheet("QLabel { padding: 2px 8px; }");  // 设置内边距
 
+    // 创建耗时统计标签(性能统计开启时才显示)
+    profileLabel = new QLabel(this);
+    profileLabel->setStyleSheet("QLabel { padding: 2px 8px; color: #555; }");  // 设置内边距和颜色
+    profileLabel->hide();
+
+    // 创建后台保存进度条和取消按钮(保存时才显示)
+    saveProgressBar = new QProgressBar(this);
+    saveProgressBar->setRange(0, 100);
+    saveProgressBar->setFixedWidth(160);
+    saveProgressBar->setFormat("保存中 %p%");
+    saveProgressBar->hide();
+    cancelSaveBtn = new QPushButton("取消", this);
+    cancelSaveBtn->setToolTip("取消保存");
+    cancelSaveBtn->hide();
+    connect(cancelSaveBtn, &QPushButton::clicked, paintArea, &PaintArea::cancelSave);
+
     // 将标签添加到状态栏(永久部件，不会被挤掉)
+    statusBar()->addPermanentWidget(profileLabel);
+    statusBar()->addPermanentWidget(saveProgressBar);
+    statusBar()->addPermanentWidget(cancelSaveBtn);
     statusBar()->addPermanentWidget(cursorPosLabel);
     statusBar()->addPermanentWidget(shapeInfoLabel);
     statusBar()->addPermanentWidget(zoomLabel);
 }
 
+// 创建图层面板：图层列表、调整顺序的按钮、不透明度和混合模式
+void MainWindow::createLayerDock()
+{
+    QDockWidget *dock = new QDockWidget("图层", this);
+    dock->setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea);
+    QWidget *panel = new QWidget(dock);
+    QVBoxLayout *layout = new QVBoxLayout(panel);
+
+    // 图层列表，勾选框控制显示/隐藏
+    layerList = new QListWidget(panel);
+    connect(layerList, &QListWidget::itemChanged, this, &MainWindow::onLayerItemChanged);
+    connect(layerList, &QListWidget::currentRowChanged, this, &MainWindow::onLayerSelected);
+    layout->addWidget(layerList);
+
+    // 导入、删除和调整顺序的按钮
+    QHBoxLayout *buttons = new QHBoxLayout;
+    QPushButton *importBtn = new QPushButton("导入", panel);
+    importBtn->setToolTip("导入图像作为新图层");
+    connect(importBtn, &QPushButton::clicked, this, &MainWindow::importLayer);
+    removeLayerBtn = new QPushButton("删除", panel);
+    removeLayerBtn->setToolTip("删除选中的图层(绘制层不能删除)");
+    connect(removeLayerBtn, &QPushButton::clicked, this, &MainWindow::removeLayer);
+    QPushButton *upBtn = new QPushButton("上移", panel);
+    connect(upBtn, &QPushButton::clicked, this, &MainWindow::moveLayerUp);
+    QPushButton *downBtn = new QPushButton("下移", panel);
+    connect(downBtn, &QPushButton::clicked, this, &MainWindow::moveLayerDown);
+    buttons->addWidget(importBtn);
+    buttons->addWidget(removeLayerBtn);
+    buttons->addWidget(upBtn);
+    buttons->addWidget(downBtn);
+    layout->addLayout(buttons);
+
+    // 不透明度滑块(0-100%)
+    QHBoxLayout *opacityRow = new QHBoxLayout;
+    opacityRow->addWidget(new QLabel("不透明度:", panel));
+    opacitySlider = new QSlider(Qt::Horizontal, panel);
+    opacitySlider->setRange(0, 100);
+    opacitySlider->setValue(100);
+    connect(opacitySlider, &QSlider::valueChanged, this, &MainWindow::changeLayerOpacity);
+    opacityRow->addWidget(opacitySlider);
+    layout->addLayout(opacityRow);
+
+    // 混合模式下拉框
+    QHBoxLayout *blendRow = new QHBoxLayout;
+    blendRow->addWidget(new QLabel("混合模式:", panel));
+    blendComboBox = new QComboBox(panel);
+    for (const BlendModeEntry &entry : BlendModes) {
+        blendComboBox->addItem(entry.name);
+    }
+    connect(blendComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::changeLayerBlendMode);
+    blendRow->addWidget(blendComboBox);
+    layout->addLayout(blendRow);
+
+    dock->setWidget(panel);
+    addDockWidget(Qt::RightDockWidgetArea, dock);
+    refreshLayerList();
+}
+
+// 选中的图层在图层栈中的下标：列表第一行是最上层
+int MainWindow::selectedLayer() const
+{
+    int row = layerList->currentRow();
+    return row < 0 ? -1 : paintArea->layerStack().count() - 1 - row;
+}
+
+// 按图层栈重建图层列表，尽量保持原来的选中行
+void MainWindow::refreshLayerList()
+{
+    const LayerStack &layers = paintArea->layerStack();
+    int row = qBound(0, layerList->currentRow(), layers.count() - 1);
+
+    updatingLayers = true;
+    layerList->clear();
+    for (int index = layers.count() - 1; index >= 0; --index) {
+        const LayerStack::Layer &layer = layers.layer(index);
+        QListWidgetItem *item = new QListWidgetItem(layer.name, layerList);
+        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+        item->setCheckState(layer.visible ? Qt::Checked : Qt::Unchecked);
+        if (layer.document) {
+            QFont font = item->font();
+            font.setBold(true);  // 笔画总是画在绘制层上
+            item->setFont(font);
+        }
+    }
+    layerList->setCurrentRow(row);
+    updatingLayers = false;
+    onLayerSelected();
+}
+
+// 选中的图层改变，同步不透明度和混合模式
+void MainWindow::onLayerSelected()
+{
+    int index = selectedLayer();
+    if (updatingLayers || index < 0) return;
+
+    const LayerStack::Layer &layer = paintArea->layerStack().layer(index);
+    updatingLayers = true;
+    opacitySlider->setValue(qRound(layer.opacity * 100));
+    for (int i = 0; i < blendComboBox->count(); ++i) {
+        if (BlendModes[i].mode == layer.mode) blendComboBox->setCurrentIndex(i);
+    }
+    removeLayerBtn->setEnabled(!layer.document);
+    updatingLayers = false;
+}
+
+// 图层列表项勾选状态改变
+void MainWindow::onLayerItemChanged(QListWidgetItem *item)
+{
+    if (updatingLayers) return;
+    int index = paintArea->layerStack().count() - 1 - layerList->row(item);
+    paintArea->setLayerVisible(index, item->checkState() == Qt::Checked);
+}
+
+// 导入图像作为新图层
+void MainWindow::importLayer()
+{
+    QString filePath = QFileDialog::getOpenFileName(this,
+                                                    "导入图层",
+                                                    "",
+                                                    "图像文件 (*.png *.jpg *.jpeg *.bmp)");
+    if (filePath.isEmpty()) return;
+
+    if (paintArea->importLayer(filePath)) {
+        statusBar()->showMessage("正在导入图层...");
+        layerList->setCurrentRow(0);  // 新图层在最上方
+    } else {
+        statusBar()->showMessage("正在导入其他图层，请稍候", 3000);
+    }
+}
+
+// 删除选中的图层
+void MainWindow::removeLayer()
+{
+    int index = selectedLayer();
+    if (index >= 0) paintArea->removeLayer(index);
+}
+
+// 选中的图层上移一层(列表中向上一行)
+void MainWindow::moveLayerUp()
+{
+    int index = selectedLayer();
+    if (index < 0 || index + 1 >= paintArea->layerStack().count()) return;
+    layerList->setCurrentRow(layerList->currentRow() - 1);
+    paintArea->moveLayer(index, index + 1);
+}
+
+// 选中的图层下移一层(列表中向下一行)
+void MainWindow::moveLayerDown()
+{
+    int index = selectedLayer();
+    if (index <= 0) return;
+    layerList->setCurrentRow(layerList->currentRow() + 1);
+    paintArea->moveLayer(index, index - 1);
+}
+
+// 改变选中图层的不透明度
+void MainWindow::changeLayerOpacity(int percent)
+{
+    int index = selectedLayer();
+    if (updatingLayers || index < 0) return;
+    paintArea->setLayerOpacity(index, percent / 100.0);
+}
+
+// 改变选中图层的混合模式
+void MainWindow::changeLayerBlendMode(int index)
+{
+    int layer = selectedLayer();
+    if (updatingLayers || layer < 0 || index < 0) return;
+    paintArea->setLayerBlendMode(layer, BlendModes[index].mode);
+}
+
 // 改变颜色槽函数
 void MainWindow::changeColor()
 {
@@ -193,18 +547,79 @@ void MainWindow::changeShape(int index)
     shapeInfoLabel->setText("工具: " + shapeName);       // 更新状态栏显示
 }
 
+// 改变笔画简化容差槽函数
+void MainWindow::changeStrokeTolerance(double tolerance)
+{
+    paintArea->setStrokeTolerance(tolerance);
+}
+
+// 改变油漆桶颜色容差槽函数
+void MainWindow::changeFillTolerance(int tolerance)
+{
+    paintArea->setFillTolerance(tolerance);
+}
+
+// 开启/关闭笔画平滑槽函数
+void MainWindow::toggleSmoothing(bool smooth)
+{
+    paintArea->setStrokeSmoothing(smooth);
+}
+
 // 保存图像槽函数
 void MainWindow::saveImage()
 {
+    // 同一时间只允许一个后台保存任务
+    if (paintArea->isSaving()) {
+        statusBar()->showMessage("正在保存，请稍候", 3000);
+        return;
+    }
+
     // 打开文件保存对话框
     QString filePath = QFileDialog::getSaveFileName(this,
                                                     "保存图片",
                                                     "",
-                                                    "PNG图像 (*.png);;JPEG图像 (*.jpg *.jpeg);;BMP图像 (*.bmp)");
+                                                    "PNG图像 (*.png);;JPEG图像 (*.jpg *.jpeg);;BMP图像 (*.bmp);;"
+                                                    "SVG矢量图 (*.svg);;PDF文档 (*.pdf);;工程文件 (*.ppd)");
 
-    // 如果用户选择了文件路径
-    if (!filePath.isEmpty()) {
-        paintArea->saveImage(filePath);  // 保存图像到指定路径
+    // 如果用户取消了对话框
+    if (filePath.isEmpty()) return;
+
+    // 没有扩展名时默认保存为PNG
+    if (QFileInfo(filePath).suffix().isEmpty()) {
+        filePath += ".png";
+    }
+
+    // 根据格式询问编码参数
+    ImageSaver::Options options;
+    QByteArray format = ImageSaver::formatForFile(filePath);
+    bool ok = true;
+    if (format == "jpeg") {
+        options.quality = QInputDialog::getInt(this, "JPEG质量", "图像质量(0-100):",
+                                               90, 0, 100, 1, &ok);
+    } else if (format == "png") {
+        options.compression = QInputDialog::getInt(this, "PNG压缩", "压缩级别(0-9，越大文件越小、越慢):",
+                                                   6, 0, 9, 1, &ok);
+    }
+    if (!ok) return;
+
+    // 启动后台保存并显示进度
+    if (paintArea->saveImage(filePath, options)) {
+        saveProgressBar->setValue(0);
+        saveProgressBar->show();
+        cancelSaveBtn->show();
+    }
+}
+
+// 后台保存结束槽函数
+void MainWindow::onSaveFinished(bool ok, const QString &message)
+{
+    saveProgressBar->hide();
+    cancelSaveBtn->hide();
+
+    if (ok) {
+        statusBar()->showMessage(message, 5000);
+    } else {
+        QMessageBox::warning(this, "保存图片", message);
     }
 }
 
@@ -215,11 +630,26 @@ void MainWindow::openImage()
     QString filePath = QFileDialog::getOpenFileName(this,
                                                     "打开图片",
                                                     "",
-                                                    "图像文件 (*.png *.jpg *.jpeg *.bmp)");
+                                                    "图像和工程文件 (*.png *.jpg *.jpeg *.bmp *.ppd);;"
+                                                    "工程文件 (*.ppd)");
 
     // 如果用户选择了文件
     if (!filePath.isEmpty()) {
-        paintArea->loadImage(filePath);  // 加载图像文件
+        // 在后台加载图像文件，界面保持响应
+        if (paintArea->loadImage(filePath)) {
+            statusBar()->showMessage("正在加载图像...");
+        } else {
+            statusBar()->showMessage("正在加载其他图像，请稍候", 3000);
+        }
+    }
+}
+
+// 后台加载结束槽函数
+void MainWindow::onLoadFinished(bool ok, const QString &message)
+{
+    statusBar()->clearMessage();
+    if (!ok) {
+        QMessageBox::warning(this, "打开图片", message);
     }
 }
 
@@ -237,9 +667,141 @@ void MainWindow::redo()
     update();          // 更新界面
 }
 
+// 切换历史模式槽函数
+void MainWindow::toggleHistoryMode(bool commandMode)
+{
+    paintArea->setHistoryMode(commandMode ? PaintArea::CommandHistoryMode
+                                          : PaintArea::TileHistoryMode);
+}
+
 // 更新光标位置槽函数
 void MainWindow::updateCursorPosition(const QPoint& pos)
 {
     // 更新状态栏显示的光标位置
     cursorPosLabel->setText(QString("位置: %1, %2").arg(pos.x()).arg(pos.y()));
 }
+
+// 更新缩放比例显示槽函数
+void MainWindow::updateZoomLabel(double factor)
+{
+    zoomLabel->setText(QString("缩放: %1%").arg(qRound(factor * 100)));
+}
+
+// 开始/结束录制输入槽函数
+void MainWindow::toggleRecording(bool record)
+{
+    if (record) {
+        paintArea->startRecording();
+        replayAction->setEnabled(false);  // 录制期间不能回放
+        statusBar()->showMessage("正在录制输入...");
+        return;
+    }
+
+    InputTrace trace = paintArea->stopRecording();
+    replayAction->setEnabled(true);
+    statusBar()->clearMessage();
+    if (trace.isEmpty()) return;
+
+    QString filePath = QFileDialog::getSaveFileName(this, "保存录制", "", "输入录制 (*.ptrace)");
+    if (filePath.isEmpty()) return;
+    if (QFileInfo(filePath).suffix().isEmpty()) {
+        filePath += ".ptrace";
+    }
+
+    QString error;
+    if (trace.save(filePath, &error)) {
+        statusBar()->showMessage(QString("已保存 %1 个事件").arg(trace.events.size()), 5000);
+    } else {
+        QMessageBox::warning(this, "保存录制", error);
+    }
+}
+
+// 回放录制的输入槽函数
+void MainWindow::replayInput()
+{
+    if (replayer->isRunning()) {
+        replayer->cancel();
+        return;
+    }
+
+    QString filePath = QFileDialog::getOpenFileName(this, "回放录制", "", "输入录制 (*.ptrace)");
+    if (filePath.isEmpty()) return;
+
+    InputTrace trace;
+    QString error;
+    if (!trace.load(filePath, &error)) {
+        QMessageBox::warning(this, "回放录制", error);
+        return;
+    }
+
+    // 选择按录制时的节奏还是尽快回放
+    bool ok = false;
+    QString speed = QInputDialog::getItem(this, "回放录制", "回放速度:",
+                                          {"按录制时的节奏", "尽快"}, 0, false, &ok);
+    if (!ok) return;
+
+    if (replayer->start(paintArea, trace, speed == "按录制时的节奏", &error)) {
+        recordAction->setEnabled(false);
+        replayAction->setText("  停止  ");
+        statusBar()->showMessage(QString("正在回放 %1 个事件...").arg(trace.events.size()));
+    } else if (!error.isEmpty()) {
+        QMessageBox::warning(this, "回放录制", error);
+    }
+}
+
+// 回放结束槽函数
+void MainWindow::onReplayFinished(const InputReplayer::Report &report)
+{
+    recordAction->setEnabled(true);
+    replayAction->setText("  回放  ");
+    statusBar()->clearMessage();
+
+    // 回放会切换工具参数，恢复为工具栏上的设置
+    changeShape(shapeComboBox->currentIndex());
+    paintArea->setPenColor(currentColor);
+    paintArea->setPenWidth(sizeSpinBox->value());
+    paintArea->setStrokeTolerance(toleranceSpinBox->value());
+    paintArea->setStrokeSmoothing(smoothAction->isChecked());
+    paintArea->setFillTolerance(fillToleranceSpinBox->value());
+
+    QMessageBox box(QMessageBox::Information, "回放结果", report.toText(), QMessageBox::Ok, this);
+    box.setStyleSheet("QLabel { font-family: monospace; }");  // 直方图需要等宽字体对齐
+    box.exec();
+}
+
+// 开启/关闭性能统计槽函数
+void MainWindow::toggleProfiling(bool enabled)
+{
+    Profiler::setEnabled(enabled);
+    exportTraceAction->setEnabled(enabled);
+    profileLabel->setVisible(enabled);
+    if (enabled) {
+        updateProfileLabel();
+        profileTimer->start();
+    } else {
+        profileTimer->stop();
+    }
+}
+
+// 导出Chrome跟踪文件槽函数
+void MainWindow::exportTrace()
+{
+    QString filePath = QFileDialog::getSaveFileName(this, "导出跟踪", "", "Chrome跟踪 (*.json)");
+    if (filePath.isEmpty()) return;
+    if (QFileInfo(filePath).suffix().isEmpty()) {
+        filePath += ".json";
+    }
+
+    QString error;
+    if (Profiler::writeTrace(filePath, &error)) {
+        statusBar()->showMessage("跟踪已导出，可在chrome://tracing或Perfetto中打开", 5000);
+    } else {
+        QMessageBox::warning(this, "导出跟踪", error);
+    }
+}
+
+// 刷新状态栏中的各阶段耗时
+void MainWindow::updateProfileLabel()
+{
+    profileLabel->setText(Profiler::summary());
+}
@@ -4,11 +4,17 @@
 #include <QMainWindow>
 #include <QPushButton>
 #include <QSpinBox>
+#include <QDoubleSpinBox>
 #include <QComboBox>
 #include <QToolBar>
 #include <QStatusBar>
 #include <QLabel>
+#include <QListWidget>
+#include <QSlider>
+#include <QProgressBar>
+#include <QTimer>
 #include "paintarea.h"
+#include "inputreplayer.h"
 
 /**
  * @brief 主窗口类，负责应用程序的主界面和功能控制
@@ -29,16 +35,40 @@ private slots:
     void changeColor();  // 改变绘图颜色
     void changeBrushSize(int size);  // 改变画笔大小
     void changeShape(int index);  // 改变绘图形状
+    void changeStrokeTolerance(double tolerance);  // 改变笔画简化容差
+    void toggleSmoothing(bool smooth);  // 开启/关闭笔画平滑
+    void changeFillTolerance(int tolerance);  // 改变油漆桶颜色容差
     void saveImage();  // 保存图像
+    void onSaveFinished(bool ok, const QString &message);  // 后台保存结束
     void openImage();  // 打开图像
+    void onLoadFinished(bool ok, const QString &message);  // 后台加载结束
     void undo();  // 撤销操作
     void redo();  // 重做操作
+    void toggleHistoryMode(bool commandMode);  // 切换矢量/图块历史模式
     void updateCursorPosition(const QPoint& pos);  // 更新光标位置显示
+    void updateZoomLabel(double factor);  // 更新缩放比例显示
+    void toggleRecording(bool record);  // 开始/结束录制输入
+    void replayInput();  // 回放录制的输入
+    void onReplayFinished(const InputReplayer::Report &report);  // 回放结束
+    void toggleProfiling(bool enabled);  // 开启/关闭性能统计
+    void exportTrace();  // 导出Chrome跟踪文件
+    void updateProfileLabel();  // 刷新状态栏中的各阶段耗时
+    void importLayer();  // 导入图像作为新图层
+    void removeLayer();  // 删除选中的图层
+    void moveLayerUp();  // 选中的图层上移一层
+    void moveLayerDown();  // 选中的图层下移一层
+    void onLayerItemChanged(QListWidgetItem *item);  // 图层列表项勾选状态改变(显示/隐藏)
+    void onLayerSelected();  // 选中的图层改变，同步不透明度和混合模式
+    void changeLayerOpacity(int percent);  // 改变选中图层的不透明度
+    void changeLayerBlendMode(int index);  // 改变选中图层的混合模式
+    void refreshLayerList();  // 按图层栈重建图层列表
 
 private:
     // 私有辅助函数
     void createToolBar();  // 创建工具栏
     void createStatusBar();  // 创建状态栏
+    void createLayerDock();  // 创建图层面板
+    int selectedLayer() const;  // 选中的图层在图层栈中的下标(没有选中时为-1)
     QPushButton* createToolButton(const QString& text, const QString& tooltip = "");  // 创建工具按钮
 
     // 成员变量
@@ -47,13 +77,32 @@ private:
     QPushButton *colorBtn;  // 颜色选择按钮
     QSpinBox *sizeSpinBox;  // 画笔大小调节框
     QComboBox *shapeComboBox;  // 形状选择下拉框
+    QDoubleSpinBox *toleranceSpinBox;  // 笔画简化容差调节框
+    QAction *smoothAction;  // 笔画平滑动作
+    QSpinBox *fillToleranceSpinBox;  // 油漆桶颜色容差调节框
     QAction *undoAction;  // 撤销动作
     QAction *redoAction;  // 重做动作
+    QAction *recordAction;  // 录制输入动作
+    QAction *replayAction;  // 回放输入动作
+    InputReplayer *replayer;  // 输入回放
+    QAction *profileAction;  // 性能统计动作
+    QAction *exportTraceAction;  // 导出跟踪动作
+    QTimer *profileTimer;  // 定时刷新耗时统计
+
+    // 图层面板控件(列表第一行是最上层)
+    QListWidget *layerList;  // 图层列表，勾选表示可见
+    QSlider *opacitySlider;  // 选中图层的不透明度
+    QComboBox *blendComboBox;  // 选中图层的混合模式
+    QPushButton *removeLayerBtn;  // 删除图层按钮
+    bool updatingLayers;  // 正在按图层栈刷新面板(忽略控件发出的信号)
 
     // 状态栏控件
     QLabel *cursorPosLabel;  // 显示光标位置
     QLabel *shapeInfoLabel;  // 显示形状信息
     QLabel *zoomLabel;  // 显示缩放比例
+    QLabel *profileLabel;  // 显示各阶段耗时(性能统计开启时)
+    QProgressBar *saveProgressBar;  // 后台保存进度
+    QPushButton *cancelSaveBtn;  // 取消保存按钮
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,125 @@
+#include "mipmap.h"
+#include <QtMath>
+#include <cstring>
+
+// 缩放比例对应的层级：选择比例不小于scale的最粗层级，剩下的缩小不超过一半
+int Mipmap::levelFor(qreal scale)
+{
+    if (scale >= 1.0 || scale <= 0.0) return 0;
+    int level = qFloor(std::log2(1.0 / scale));
+    return qBound(0, level, MaxLevel);
+}
+
+// 按方块平均缩小：每个目标像素是源中2^level×2^level个预乘像素各通道的平均值
+void Mipmap::downsample(const QImage &source, const QRect &sourceRect,
+                        QImage &target, const QPoint &targetPos, int level)
+{
+    const int factor = 1 << level;
+    const int shift = level * 2;
+    const int round = (1 << shift) >> 1;
+    QRect clipped = sourceRect.intersected(source.rect());
+    const int width = qMin(sourceRect.width() / factor, target.width() - targetPos.x());
+    const int height = qMin(sourceRect.height() / factor, target.height() - targetPos.y());
+
+    for (int y = 0; y < height; ++y) {
+        quint32 *out = reinterpret_cast<quint32 *>(target.scanLine(targetPos.y() + y)) + targetPos.x();
+        int top = sourceRect.y() + y * factor;
+        for (int x = 0; x < width; ++x) {
+            int left = sourceRect.x() + x * factor;
+            quint32 sum[4] = {0, 0, 0, 0};
+            int bottom = qMin(top + factor, clipped.bottom() + 1);
+            int right = qMin(left + factor, clipped.right() + 1);
+            for (int sy = top; sy < bottom; ++sy) {
+                const quint32 *in = reinterpret_cast<const quint32 *>(source.constScanLine(sy));
+                for (int sx = left; sx < right; ++sx) {
+                    quint32 pixel = in[sx];
+                    sum[0] += pixel & 0xff;
+                    sum[1] += (pixel >> 8) & 0xff;
+                    sum[2] += (pixel >> 16) & 0xff;
+                    sum[3] += pixel >> 24;
+                }
+            }
+            int count = qMax(0, bottom - top) * qMax(0, right - left);
+            if (count == factor * factor) {
+                out[x] = ((sum[0] + round) >> shift) | (((sum[1] + round) >> shift) << 8) |
+                         (((sum[2] + round) >> shift) << 16) | (((sum[3] + round) >> shift) << 24);
+            } else if (count > 0) {
+                // 源图像边缘不完整的方块只平均实际存在的像素，避免边缘变淡
+                out[x] = ((sum[0] + count / 2) / count) | (((sum[1] + count / 2) / count) << 8) |
+                         (((sum[2] + count / 2) / count) << 16) | (((sum[3] + count / 2) / count) << 24);
+            } else {
+                out[x] = 0;
+            }
+        }
+    }
+}
+
+// 设置原图，只有图像真正改变时才丢弃已生成的层级
+void ImagePyramid::setImage(const QImage &image)
+{
+    if (image.cacheKey() == original.cacheKey()) return;
+
+    original = image;
+    levels.clear();
+}
+
+// 获取层级，第一次使用时从原图整层生成
+QImage ImagePyramid::level(int level)
+{
+    if (level <= 0 || original.isNull()) return original;
+
+    if (levels.size() <= level) levels.resize(level + 1);
+    if (levels[level].isNull()) {
+        QImage source = original.format() == QImage::Format_ARGB32_Premultiplied ?
+                            original : original.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        int factor = 1 << level;
+        QSize size((source.width() + factor - 1) / factor, (source.height() + factor - 1) / factor);
+        QImage result(size, QImage::Format_ARGB32_Premultiplied);
+        Mipmap::downsample(source, QRect(QPoint(0, 0), size * factor), result, QPoint(0, 0), level);
+        levels[level] = result;
+    }
+    return levels[level];
+}
+
+// 构造函数
+CanvasPyramid::CanvasPyramid()
+    : currentLevel(0) {}
+
+// 获取画布的缩小图像：层级或画布尺寸改变时重新分配，之后只重新缩小修订号变化的图块
+const QImage &CanvasPyramid::level(const TiledCanvas &canvas, int level, const QRect &area)
+{
+    const int block = TiledCanvas::TileSize >> level;
+    if (level != currentLevel || canvas.size() != canvasSize) {
+        currentLevel = level;
+        canvasSize = canvas.size();
+        image = QImage(canvas.columns() * block, canvas.rows() * block, QImage::Format_ARGB32_Premultiplied);
+        revisions = QVector<quint64>(canvas.tileCount(), ~quint64(0));  // 全部视为过期
+    }
+
+    for (int index : canvas.tilesIn(area)) {
+        quint64 revision = canvas.revision(index);
+        if (revisions[index] == revision) continue;
+        revisions[index] = revision;
+
+        QPoint pos((index % canvas.columns()) * block, (index / canvas.columns()) * block);
+        if (!canvas.hasTile(index)) {
+            // 未分配的图块是透明的
+            for (int y = 0; y < block; ++y) {
+                std::memset(image.scanLine(pos.y() + y) + pos.x() * 4, 0, block * 4);
+            }
+            continue;
+        }
+        QImage tile = canvas.tile(index);
+        Mipmap::downsample(tile, tile.rect(), image, pos, level);
+    }
+    return image;
+}
+
+// 释放缩小图像
+void CanvasPyramid::clear()
+{
+    currentLevel = 0;
+    canvasSize = QSize();
+    image = QImage();
+    revisions.clear();
+}
@@ -0,0 +1,75 @@
+#ifndef MIPMAP_H
+#define MIPMAP_H
+
+#include <QImage>
+#include <QPoint>
+#include <QRect>
+#include <QVector>
+#include "tiledcanvas.h"
+
+/**
+ * @brief 缩小显示用的多级图像(mipmap)
+ *
+ * 第k层是原图按2^k×2^k方块平均缩小的结果。缩小显示时先选择不小于目标比例的最细层级，
+ * 剩下的缩放不超过一半，每帧的开销只与窗口中可见的像素数有关，而与画布尺寸和缩放比例无关。
+ */
+class Mipmap {
+public:
+    static const int MaxLevel = 5;  // 最粗的层级(1/32，足够5%的缩放)
+
+    static int levelFor(qreal scale);  // 缩放比例对应的层级(放大和原尺寸为0)
+    static qreal levelScale(int level) { return 1.0 / (1 << level); }  // 层级相对原图的比例
+
+    /**
+     * @brief 把源图像中的区域按方块平均缩小后写入目标图像
+     * @param source 预乘ARGB32格式的源图像
+     * @param sourceRect 源区域，宽高应为2^level的整数倍
+     * @param target 预乘ARGB32格式的目标图像
+     * @param targetPos 结果在目标图像中的位置
+     * @param level 层级
+     */
+    static void downsample(const QImage &source, const QRect &sourceRect,
+                           QImage &target, const QPoint &targetPos, int level);
+};
+
+/**
+ * @brief 背景图像的各个层级，第一次使用某一层时整层生成，背景改变后丢弃
+ */
+class ImagePyramid {
+public:
+    void setImage(const QImage &image);  // 设置原图，cacheKey变化时丢弃已生成的层级
+    QImage level(int level);  // 获取层级(0为原图)
+
+private:
+    QImage original;  // 原图
+    QVector<QImage> levels;  // 已生成的层级(下标为层级，未生成为空图像)
+};
+
+/**
+ * @brief 分块画布当前层级的缩小图像
+ *
+ * 每个图块对应缩小图像中一个对齐的方块，按图块修订号增量更新：绘制时只有被写过的图块需要重新缩小。
+ * 只保留一个层级，缩放比例跨越层级时整层按需重建，内存不超过画布的1/4。
+ */
+class CanvasPyramid {
+public:
+    CanvasPyramid();
+
+    /**
+     * @brief 获取画布的缩小图像，先更新区域内变化过的图块
+     * @param canvas 画布
+     * @param level 层级(1到Mipmap::MaxLevel)
+     * @param area 需要使用的区域(画布坐标)
+     * @return 缩小图像，画布坐标乘以Mipmap::levelScale(level)即为图像坐标
+     */
+    const QImage &level(const TiledCanvas &canvas, int level, const QRect &area);
+    void clear();  // 释放缩小图像
+
+private:
+    int currentLevel;  // 当前层级(0表示没有)
+    QSize canvasSize;  // 对应的画布尺寸
+    QImage image;  // 缩小图像(按完整图块对齐)
+    QVector<quint64> revisions;  // 每个图块在缩小图像中的修订号
+};
+
+#endif // MIPMAP_H
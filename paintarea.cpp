@@ -2,9 +2,17 @@
 #include <QPainterPath>
 #include <QDebug>
 #include <QResizeEvent>
+#include <QWheelEvent>
+#include <QKeyEvent>
+#include <QScreen>
 #include <cmath>
 #include <QFileDialog>
+#include <QFileInfo>
 #include "shapes.h"
+#include "shapefactory.h"
+#include "profiler.h"
+#include "projectfile.h"
+#include "floodfill.h"
 
 // 构造函数，初始化绘图区域
 PaintArea::PaintArea(QWidget *parent) : QWidget(parent)
@@ -15,21 +23,64 @@ PaintArea::PaintArea(QWidget *parent) : QWidget(parent)
     setAttribute(Qt::WA_StaticContents);
     // 启用鼠标跟踪
     setMouseTracking(true);
+    // 接受键盘焦点，用于空格平移和方向键
+    setFocusPolicy(Qt::StrongFocus);
 
     // 初始化成员变量
     isSelecting = false;          // 是否正在选择区域
     selectionRect = QRect();      // 选择区域矩形
     drawing = false;              // 是否正在绘制
     currentShapeType = Freehand;  // 默认绘制类型为自由绘制
-    // 创建800x600的透明背景图像
-    image = QImage(800, 600, QImage::Format_ARGB32_Premultiplied);
-    image.fill(Qt::white);        // 填充白色背景
-    tempImage = image;            // 临时图像用于预览
+    scaleFactor = 1.0;            // 初始缩放比例
+    scaledBackgroundScale = 0.0;  // 尚未生成背景缓存
+    scaledBackgroundKey = 0;
+    fitToWindow = true;           // 默认适应窗口
+    panning = false;              // 是否正在拖动平移
+    spaceHeld = false;            // 是否按住空格
+    movingSelection = false;      // 是否正在拖动选中的形状
+    recording = false;            // 是否正在录制输入
+    previewPending = false;       // 没有积压的预览
+    cursorPending = false;        // 没有积压的光标位置
+    // 创建800x600的透明绘制层，只包含文档中的形状，图块在第一次绘制时才分配
+    image = TiledCanvas(QSize(800, 600));
+    resetPreview();               // 透明预览图层
+
+    // 每帧最多刷新一次预览和光标位置
+    frameTimer = new QTimer(this);
+    frameTimer->setSingleShot(true);
+    frameTimer->setTimerType(Qt::PreciseTimer);
+    connect(frameTimer, &QTimer::timeout, this, &PaintArea::flushFrame);
+    frameClock.start();
+
+    // 后台加载任务
+    loading = false;
+    imageLoader = new ImageLoader(this);
+    connect(imageLoader, &ImageLoader::previewReady, this, &PaintArea::onLoadPreview);
+    connect(imageLoader, &ImageLoader::loaded, this, &PaintArea::onImageLoaded);
+    connect(imageLoader, &ImageLoader::projectLoaded, this, &PaintArea::onProjectLoaded);
+    connect(imageLoader, &ImageLoader::failed, this, &PaintArea::onLoadFailed);
+
+    // 后台导入图层任务，只使用全分辨率结果
+    layerLoader = new ImageLoader(this);
+    connect(layerLoader, &ImageLoader::loaded, this, &PaintArea::onLayerLoaded);
+    connect(layerLoader, &ImageLoader::failed, this, [this](const QString &message) {
+        emit loadFinished(false, message);
+    });
+    layers.resize(image.size());
+
+    // 后台保存任务，进度和结果转发给外部
+    imageSaver = new ImageSaver(this);
+    connect(imageSaver, &ImageSaver::progressChanged, this, &PaintArea::saveProgressChanged);
+    connect(imageSaver, &ImageSaver::finished, this, &PaintArea::saveFinished);
 
     // 默认画笔设置
     penColor = Qt::black;         // 黑色画笔
     penWidth = 3;                 // 3像素宽度
-    undoStack.push(image);        // 初始状态压入撤销栈
+    strokeTolerance = 0.5;        // 只省略与相邻点共线的采样点，不改变笔画外观
+    strokeSmoothing = false;      // 默认不平滑
+    fillTolerance = 32;           // 油漆桶容纳抗锯齿边缘附近的相近颜色
+    historyMode = TileHistoryMode;        // 默认使用图块差量历史
+    history.reset(originalImage, image);  // 初始状态作为历史起点
 }
 
 // 设置画笔颜色
@@ -44,53 +95,277 @@ void PaintArea::setPenWidth(int width)
     penWidth = width;
 }
 
+// 设置笔画简化容差
+void PaintArea::setStrokeTolerance(double tolerance)
+{
+    strokeTolerance = tolerance;
+}
+
+// 设置笔画是否平滑
+void PaintArea::setStrokeSmoothing(bool smooth)
+{
+    strokeSmoothing = smooth;
+}
+
+// 设置油漆桶的颜色容差
+void PaintArea::setFillTolerance(int tolerance)
+{
+    fillTolerance = qBound(0, tolerance, 255);
+}
+
 // 设置当前绘制形状类型
 void PaintArea::setDrawShape(DrawShape shape)
 {
     currentShapeType = shape;
+    // 离开编组选择工具时取消选中
+    if (shape != GroupSelect) {
+        clearSelection();
+    }
+}
+
+// 向形状工厂注册每种绘图形状的创建函数，编组选择不创建形状
+static bool registerShapes()
+{
+    ShapeFactory::registerShape(PaintArea::Freehand, &ShapeFactory::acquire<PathShape>);  // 自由绘制
+    ShapeFactory::registerShape(PaintArea::Line, &ShapeFactory::acquire<LineShape>);  // 直线
+    ShapeFactory::registerShape(PaintArea::Rectangle, &ShapeFactory::acquire<RectangleShape>);  // 矩形
+    ShapeFactory::registerShape(PaintArea::Ellipse, &ShapeFactory::acquire<EllipseShape>);  // 椭圆
+    ShapeFactory::registerShape(PaintArea::Arrow, &ShapeFactory::acquire<ArrowShape>);  // 箭头
+    ShapeFactory::registerShape(PaintArea::Star, &ShapeFactory::acquire<StarShape>);  // 星形
+    ShapeFactory::registerShape(PaintArea::Diamond, &ShapeFactory::acquire<DiamondShape>);  // 菱形
+    ShapeFactory::registerShape(PaintArea::Heart, &ShapeFactory::acquire<HeartShape>);  // 心形
+    // 橡皮擦：白色路径
+    ShapeFactory::registerShape(PaintArea::Eraser, [](const QPoint &start, const QColor &, int width) {
+        ShapeHandle shape = ShapeFactory::acquire<PathShape>(start, Qt::white, width);
+        static_cast<PathShape *>(shape.get())->setEraser(true);
+        return shape;
+    });
+    ShapeFactory::registerShape(PaintArea::Fill, &ShapeFactory::acquire<FillShape>);  // 油漆桶(区域在填充后设置)
+    return true;
+}
+
+// 按绘图形状从形状工厂创建对应的形状对象
+ShapeHandle PaintArea::createShape(DrawShape type, const QPoint &start, const QColor &color, int width)
+{
+    static const bool registered = registerShapes();  // 第一次调用时注册(线程安全)
+    Q_UNUSED(registered);
+    return ShapeFactory::create(type, start, color, width);
 }
 
 // 更新缩放比例和偏移量
 void PaintArea::updateScaleAndOffset()
 {
     QSize widgetSize = size();  // 获取当前控件大小
+    double oldScale = scaleFactor;
+
+    // 没有原始图像时，适应窗口模式下画布跟随窗口大小，缩放后画布尺寸固定
+    origImageSize = !originalImage.isNull() ? originalImage.size() :
+                    fitToWindow ? widgetSize : image.size();
 
-    if (originalImage.isNull()) {
+    if (!fitToWindow) {
+        clampOffset();  // 保持当前缩放比例，只修正偏移
+    } else if (originalImage.isNull()) {
         // 如果没有原始图像，使用1:1比例
         scaleFactor = 1.0;
         offset = QPoint(0, 0);
-        origImageSize = widgetSize;
     } else {
         // 计算适合控件大小的缩放比例
-        origImageSize = originalImage.size();
         scaleFactor = qMin(static_cast<double>(widgetSize.width()) / origImageSize.width(),
                            static_cast<double>(widgetSize.height()) / origImageSize.height());
         // 计算居中偏移量
         offset = QPoint((widgetSize.width() - origImageSize.width() * scaleFactor) / 2,
                         (widgetSize.height() - origImageSize.height() * scaleFactor) / 2);
     }
+
+    // 只有缩放比例、原始图像或可见部分变化时才重新缩放背景
+    if (scaleFactor != scaledBackgroundScale ||
+        originalImage.cacheKey() != scaledBackgroundKey || offset != scaledBackgroundOffset ||
+        canvasRect().intersected(rect()) != scaledBackgroundRect) {
+        rebuildScaledBackground();
+    }
+    if (scaleFactor != oldScale) {
+        emit zoomChanged(scaleFactor);
+    }
 }
 
-// 物理坐标(窗口坐标)转换为逻辑坐标(图像坐标)
-QPoint PaintArea::physicalToLogical(const QPoint &physicalPoint) const
+// 限制偏移量：画布小于窗口的方向居中，大于窗口的方向不露出画布以外的区域
+void PaintArea::clampOffset()
+{
+    QSize content = origImageSize * scaleFactor;
+    int x = content.width() <= width() ? (width() - content.width()) / 2 :
+                                         qBound(width() - content.width(), offset.x(), 0);
+    int y = content.height() <= height() ? (height() - content.height()) / 2 :
+                                           qBound(height() - content.height(), offset.y(), 0);
+    offset = QPoint(x, y);
+}
+
+// 画布内容在窗口中所占的区域(放大时可能超出窗口)
+QRect PaintArea::canvasRect() const
+{
+    return QRect(offset, origImageSize * scaleFactor);
+}
+
+// 重建缩放后的背景缓存：只缩放窗口中可见的部分，缩小时从最接近的层级缩放，
+// 开销只与窗口大小有关，与原始图像尺寸和缩放比例无关
+void PaintArea::rebuildScaledBackground()
 {
-    QPoint adjustedPoint = physicalPoint;
+    QRect contentRect = canvasRect();
+    scaledBackgroundScale = scaleFactor;
+    scaledBackgroundKey = originalImage.cacheKey();
+    scaledBackgroundRect = contentRect.intersected(rect());
+    scaledBackgroundOffset = offset;
 
-    // 如果有原始图像，确保坐标在图像区域内
-    if (!originalImage.isNull()) {
-        QRect contentRect(offset, origImageSize * scaleFactor);
-        adjustedPoint.setX(qBound(contentRect.left(), physicalPoint.x(), contentRect.right()));
-        adjustedPoint.setY(qBound(contentRect.top(), physicalPoint.y(), contentRect.bottom()));
+    if (originalImage.isNull() || scaledBackgroundRect.isEmpty()) {
+        scaledBackground = QPixmap();
+        return;
     }
 
-    // 如果没有原始图像，确保坐标在控件范围内
-    if (originalImage.isNull()) {
-        return QPoint(
-            qBound(0, physicalPoint.x(), width()-1),
-            qBound(0, physicalPoint.y(), height()-1));
+    // 原尺寸且完全可见时直接使用原始图像
+    if (contentRect.size() == originalImage.size() && scaledBackgroundRect == contentRect) {
+        scaledBackground = QPixmap::fromImage(originalImage);
+        return;
     }
 
-    // 计算逻辑坐标
+    backgroundMips.setImage(originalImage);
+    int level = Mipmap::levelFor(scaleFactor);
+    QImage source = backgroundMips.level(level);
+    qreal sx = static_cast<qreal>(originalImage.width()) / contentRect.width() * Mipmap::levelScale(level);
+    qreal sy = static_cast<qreal>(originalImage.height()) / contentRect.height() * Mipmap::levelScale(level);
+    QRectF sourceRect((scaledBackgroundRect.x() - contentRect.x()) * sx,
+                      (scaledBackgroundRect.y() - contentRect.y()) * sy,
+                      scaledBackgroundRect.width() * sx,
+                      scaledBackgroundRect.height() * sy);
+
+    QImage visible(scaledBackgroundRect.size(), QImage::Format_ARGB32_Premultiplied);
+    visible.fill(Qt::transparent);
+    QPainter painter(&visible);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, scaleFactor < 1.0);  // 放大时保持像素清晰
+    painter.drawImage(QRectF(visible.rect()), source, sourceRect);
+    painter.end();
+    scaledBackground = QPixmap::fromImage(visible);
+}
+
+// 设置缩放比例，锚点下的画布位置保持不动
+void PaintArea::setZoom(double factor, const QPoint &anchor)
+{
+    factor = qBound(MinZoom, factor, MaxZoom);
+    if (!fitToWindow && factor == scaleFactor) return;
+
+    // 锚点对应的画布坐标(浮点，避免多次缩放后漂移)
+    QPointF logical((anchor.x() - offset.x()) / scaleFactor, (anchor.y() - offset.y()) / scaleFactor);
+    fitToWindow = false;
+    scaleFactor = factor;
+    offset = QPoint(qRound(anchor.x() - logical.x() * factor), qRound(anchor.y() - logical.y() * factor));
+
+    QResizeEvent fakeEvent(size(), size());
+    resizeEvent(&fakeEvent);  // 更新偏移、背景缓存和图层尺寸
+    emit zoomChanged(scaleFactor);
+}
+
+// 以窗口中心放大一级
+void PaintArea::zoomIn()
+{
+    setZoom(scaleFactor * 1.25, rect().center());
+}
+
+// 以窗口中心缩小一级
+void PaintArea::zoomOut()
+{
+    setZoom(scaleFactor / 1.25, rect().center());
+}
+
+// 适应窗口
+void PaintArea::zoomToFit()
+{
+    fitToWindow = true;
+    QResizeEvent fakeEvent(size(), size());
+    resizeEvent(&fakeEvent);
+}
+
+// 原尺寸
+void PaintArea::zoomActualSize()
+{
+    setZoom(1.0, rect().center());
+}
+
+// 按窗口像素平移视图：只重建可见背景，其余内容直接按新偏移绘制
+void PaintArea::panBy(const QPoint &delta)
+{
+    if (fitToWindow || delta.isNull()) return;
+
+    QPoint oldOffset = offset;
+    offset += delta;
+    updateScaleAndOffset();
+    if (offset != oldOffset) update();
+}
+
+// 直接恢复视图状态，偏移仍按当前窗口大小限制
+void PaintArea::setView(bool fit, double factor, const QPoint &viewOffset)
+{
+    if (fit) {
+        zoomToFit();
+        return;
+    }
+
+    fitToWindow = false;
+    scaleFactor = qBound(MinZoom, factor, MaxZoom);
+    offset = viewOffset;
+    QResizeEvent fakeEvent(size(), size());
+    resizeEvent(&fakeEvent);  // 更新偏移、背景缓存和图层尺寸
+    emit zoomChanged(scaleFactor);
+    update();
+}
+
+// 滚轮以光标为中心缩放，每一格缩放1.25倍(触控板的小步滚动按比例缩放)
+void PaintArea::wheelEvent(QWheelEvent *event)
+{
+    recordEvent(event);
+    int delta = event->angleDelta().y();
+    if (delta == 0) {
+        event->ignore();
+        return;
+    }
+    setZoom(scaleFactor * std::pow(1.25, delta / 120.0), event->position().toPoint());
+    event->accept();
+}
+
+// 按住空格时左键拖动变为平移，方向键每次平移窗口的十分之一
+void PaintArea::keyPressEvent(QKeyEvent *event)
+{
+    recordEvent(event);
+    QPoint step(width() / 10, height() / 10);
+    switch (event->key()) {
+    case Qt::Key_Space:
+        if (!event->isAutoRepeat()) {
+            spaceHeld = true;
+            setCursor(Qt::OpenHandCursor);
+        }
+        break;
+    case Qt::Key_Left: panBy(QPoint(step.x(), 0)); break;
+    case Qt::Key_Right: panBy(QPoint(-step.x(), 0)); break;
+    case Qt::Key_Up: panBy(QPoint(0, step.y())); break;
+    case Qt::Key_Down: panBy(QPoint(0, -step.y())); break;
+    default:
+        QWidget::keyPressEvent(event);
+    }
+}
+
+// 松开空格结束平移模式
+void PaintArea::keyReleaseEvent(QKeyEvent *event)
+{
+    recordEvent(event);
+    if (event->key() == Qt::Key_Space && !event->isAutoRepeat()) {
+        spaceHeld = false;
+        if (!panning) unsetCursor();
+        return;
+    }
+    QWidget::keyReleaseEvent(event);
+}
+
+// 物理坐标(窗口坐标)转换为逻辑坐标(图像坐标)
+QPoint PaintArea::physicalToLogical(const QPoint &physicalPoint) const
+{
+    // 计算逻辑坐标，确保坐标在画布范围内
     int x = qBound(0.0, (physicalPoint.x() - offset.x()) / scaleFactor, origImageSize.width() - 1.0);
     int y = qBound(0.0, (physicalPoint.y() - offset.y()) / scaleFactor, origImageSize.height() - 1.0);
     return QPoint(x, y);
@@ -99,9 +374,6 @@ QPoint PaintArea::physicalToLogical(const QPoint &physicalPoint) const
 // 逻辑坐标(图像坐标)转换为物理坐标(窗口坐标)
 QPoint PaintArea::logicalToPhysical(const QPoint &logicalPoint) const
 {
-    if (originalImage.isNull()) {
-        return logicalPoint;
-    }
     return QPoint(
         logicalPoint.x() * scaleFactor + offset.x(),
         logicalPoint.y() * scaleFactor + offset.y()
@@ -122,90 +394,291 @@ void PaintArea::resizeEvent(QResizeEvent *event)
     QWidget::resizeEvent(event);
     updateScaleAndOffset();  // 更新缩放和偏移
 
-    // 如果有原始图像
-    if (!originalImage.isNull()) {
-        if (image.size() != originalImage.size()) {
-            // 创建新图像并保持原有内容
-            QImage newImage(originalImage.size(), QImage::Format_ARGB32_Premultiplied);
-            newImage.fill(Qt::transparent);
-            QPainter painter(&newImage);
-            painter.drawImage(0, 0, image);
-            image = newImage;
-        }
-    } else {
-        // 如果没有原始图像，调整图像大小
-        if (image.size() != event->size()) {
-            QImage newImage(event->size(), QImage::Format_ARGB32_Premultiplied);
-            newImage.fill(Qt::transparent);
-            QPainter painter(&newImage);
-            painter.drawImage(0, 0, image);
-            image = newImage;
-        }
+    // 有原始图像时绘制层与其等大，否则在适应窗口模式下跟随窗口大小；分块画布调整尺寸时保留原有图块
+    QSize canvasSize = !originalImage.isNull() ? originalImage.size() :
+                       fitToWindow ? event->size() : image.size();
+    if (image.size() != canvasSize) {
+        image.resize(canvasSize);
     }
 
-    tempImage = image;  // 重置临时图像
-    update();           // 触发重绘
+    // 预览图层需与主图像保持等大
+    if (tempImage.size() != image.size()) {
+        resetPreview();
+    }
+    syncLayers();
+    update();  // 触发重绘
 }
 
-// 保存图像到文件
-void PaintArea::saveImage(const QString &fileName)
+// 图层栈跟随绘制层尺寸和背景；背景没有变化时缓存保持有效
+void PaintArea::syncLayers()
 {
-    // 创建最终图像：如果有原始图像则复制原始图像，否则使用当前图像
-    QImage finalImage = originalImage.isNull() ? image : originalImage.copy();
-    QPainter painter(&finalImage);
-    painter.drawImage(0, 0, image);  // 将绘制内容合并到最终图像
-    finalImage.save(fileName, "PNG"); // 保存为PNG格式
+    layers.resize(image.size());
+    layers.setBackground(originalImage);
 }
 
-// 加载图像文件
-void PaintArea::loadImage(const QString &fileName)
+// 在后台保存图像到文件
+bool PaintArea::saveImage(const QString &fileName, const ImageSaver::Options &options)
 {
-    QImage loadedImage;
-    if (!loadedImage.load(fileName)) return;  // 加载失败则返回
+    // GUI线程只取得两个平面的隐式共享快照，合成与编码都在后台进行；
+    // 形状在之后可能被移动，工程文件和矢量格式需要的形状列表在这里序列化
+    QByteArray shapes;
+    if (ImageSaver::needsShapes(fileName)) {
+        shapes = ProjectFile::encodeShapes(scene.items());
+    }
+    return imageSaver->start(originalImage, image, fileName, options, shapes, layers.allLayers());
+}
 
-    // 保存当前状态到撤销栈
-    saveState();
+// 取消正在进行的保存
+void PaintArea::cancelSave()
+{
+    imageSaver->cancel();
+}
 
-    // 转换图像格式并保存为原始图像
-    originalImage = loadedImage.convertToFormat(QImage::Format_ARGB32_Premultiplied);
-    image = QImage(originalImage.size(), QImage::Format_ARGB32_Premultiplied);
-    image.fill(Qt::transparent);  // 透明背景
+// 是否正在后台保存
+bool PaintArea::isSaving() const
+{
+    return imageSaver->isRunning();
+}
+
+// 在后台加载图像文件：先显示预览，解码完成后再替换为全分辨率图像
+bool PaintArea::loadImage(const QString &fileName)
+{
+    if (!imageLoader->start(fileName, size())) return false;
+
+    loading = true;
+    return true;
+}
 
-    // 保存仅包含图片的状态到撤销栈
-    QImage initialState = originalImage.copy();
-    undoStack.push(initialState);
-    redoStack.clear();  // 清空重做栈
+// 是否正在后台加载图像
+bool PaintArea::isLoading() const
+{
+    return loading;
+}
+
+// 预览图解码完成，立即显示
+void PaintArea::onLoadPreview(const QImage &preview, const QSize &fullSize)
+{
+    loadingPreview = preview;
+    loadingSize = fullSize;
+    update();
+}
+
+// 全分辨率图像解码完成，替换为新的原始图像
+void PaintArea::onImageLoaded(const QImage &loadedImage)
+{
+    loading = false;
+    loadingPreview = QImage();
+
+    // 绘制层被清空，文档中的形状一并移出(撤销时恢复)
+    clearSelection();
+    HistoryCommand *command = new SceneResetCommand(scene.takeAll());
+
+    // 后台已转换为预乘格式，直接作为原始图像，新图像按适应窗口显示
+    originalImage = loadedImage;
+    fitToWindow = true;
+    replaceDrawing(TiledCanvas(originalImage.size()));  // 透明绘制层，不占用图块内存
+    syncLayers();  // 导入的图层保留，按新尺寸裁剪
+
+    // 记录加载操作，撤销时恢复加载前的两个平面
+    saveState(command);
 
     updateScaleAndOffset();  // 更新缩放和偏移
     update();               // 触发重绘
+    emit loadFinished(true, QString());
 }
 
-// 绘制事件处理
-void PaintArea::paintEvent(QPaintEvent *event)
+// 工程文件读取完成，替换背景、绘制层和文档中的形状
+void PaintArea::onProjectLoaded(const QImage &background, const TiledCanvas &drawing,
+                                const QVector<Scene::Item> &shapes,
+                                const QVector<LayerStack::Layer> &projectLayers)
 {
-    Q_UNUSED(event);  // 避免未使用参数警告
+    loading = false;
+    loadingPreview = QImage();
+
+    clearSelection();
+    HistoryCommand *command = new SceneResetCommand(scene.takeAll(), shapes);
+    command->applyScene(scene);
+
+    // 没有背景的工程与空白画布相同，绘制层随窗口大小调整
+    originalImage = background;
+    fitToWindow = true;
+    replaceDrawing(drawing);
+
+    // 记录打开操作，撤销时恢复打开前的文档
+    saveState(command);
 
+    QResizeEvent fakeEvent(size(), size());
+    resizeEvent(&fakeEvent);  // 更新缩放、偏移和预览图层尺寸
+
+    // 图层随工程替换(旧版本的工程只有绘制层)
+    layers = LayerStack();
+    syncLayers();
+    if (!projectLayers.isEmpty()) {
+        layers.setLayers(projectLayers);
+    }
+    emit layersChanged();
+    emit loadFinished(true, QString());
+}
+
+// 替换绘制层：尺寸不变时逐图块替换，原有的图块也被标记为写入，历史记录才能恢复它们
+void PaintArea::replaceDrawing(const TiledCanvas &drawing)
+{
+    if (image.size() != drawing.size()) {
+        image = drawing;
+        return;
+    }
+    for (int index = 0; index < image.tileCount(); ++index) {
+        if (image.hasTile(index) || drawing.hasTile(index)) {
+            image.setTile(index, drawing.tile(index));
+        }
+    }
+}
+
+// 在后台导入图像作为新图层
+bool PaintArea::importLayer(const QString &fileName)
+{
+    if (ProjectFile::isProjectFile(fileName)) {
+        emit loadFinished(false, "工程文件不能作为图层导入");
+        return false;
+    }
+    if (!layerLoader->start(fileName, QSize())) return false;
+
+    layerName = QFileInfo(fileName).completeBaseName();
+    return true;
+}
+
+// 导入的图层解码完成，放在最上方
+void PaintArea::onLayerLoaded(const QImage &layerImage)
+{
+    layers.addLayer(layerName, layerImage);
+    layersModified();
+    emit loadFinished(true, QString());
+}
+
+// 删除栅格图层
+void PaintArea::removeLayer(int index)
+{
+    layers.removeLayer(index);
+    layersModified();
+}
+
+// 调整图层顺序
+void PaintArea::moveLayer(int from, int to)
+{
+    layers.moveLayer(from, to);
+    layersModified();
+}
+
+// 显示或隐藏图层
+void PaintArea::setLayerVisible(int index, bool visible)
+{
+    layers.setVisible(index, visible);
+    layersModified();
+}
+
+// 设置图层不透明度
+void PaintArea::setLayerOpacity(int index, qreal opacity)
+{
+    layers.setOpacity(index, opacity);
+    layersModified();
+}
+
+// 设置图层混合模式
+void PaintArea::setLayerBlendMode(int index, QPainter::CompositionMode mode)
+{
+    layers.setBlendMode(index, mode);
+    layersModified();
+}
+
+// 图层改变后重绘并通知外部
+void PaintArea::layersModified()
+{
+    update();
+    emit layersChanged();
+}
+
+// 加载失败，恢复显示当前画布
+void PaintArea::onLoadFailed(const QString &message)
+{
+    loading = false;
+    loadingPreview = QImage();
+    update();
+    emit loadFinished(false, message);
+}
+
+// 绘制事件处理，只重绘被暴露的区域
+void PaintArea::paintEvent(QPaintEvent *event)
+{
+    Profiler::Scope profile(Profiler::Composite);
     QPainter painter(this);
-    painter.setRenderHint(QPainter::SmoothPixmapTransform);  // 启用平滑变换
-    painter.fillRect(rect(), Qt::white);  // 填充白色背景
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, scaleFactor < 1.0);  // 缩小时平滑，放大时保持像素清晰
 
-    // 如果有原始图像，绘制原始图像
-    if (!originalImage.isNull()) {
-        QRect drawRect(offset.x(), offset.y(),
-                       origImageSize.width() * scaleFactor,
-                       origImageSize.height() * scaleFactor);
-        painter.drawImage(drawRect, originalImage);
+    // 正在加载且已有预览时，只显示按最终尺寸居中的预览图
+    if (!loadingPreview.isNull()) {
+        for (const QRect &dirtyRect : event->region()) {
+            painter.fillRect(dirtyRect, Qt::white);
+        }
+        QSize fitSize = loadingSize.scaled(size(), Qt::KeepAspectRatio);
+        QRect fitRect(QPoint((width() - fitSize.width()) / 2, (height() - fitSize.height()) / 2), fitSize);
+        painter.drawImage(fitRect, loadingPreview);
+        return;
     }
 
-    // 绘制当前图像内容
-    QRect contentRect = !originalImage.isNull() ?
-                            QRect(offset, origImageSize * scaleFactor) :
-                            rect();
-    painter.drawImage(contentRect, image, image.rect());
+    QRect contentRect = canvasRect();
+    const LayerStack::Layer &documentLayer = layers.documentLayer();
+    bool layersBelow = layers.hasLayersBelow();
+    bool layersAbove = layers.hasLayersAbove();
+    for (const QRect &dirtyRect : event->region()) {
+        painter.fillRect(dirtyRect, Qt::white);  // 填充白色背景
+
+        // 绘制层之下有图层时使用合成好的下方缓存(已含背景)，否则直接拷贝已缩放好的背景
+        QRect backgroundRect = dirtyRect.intersected(scaledBackgroundRect);
+        if (layersBelow) {
+            drawLayerRect(painter, layers.below(logicalDirtyRect(contentRect, dirtyRect)),
+                          contentRect, dirtyRect, &belowMips);
+        } else if (!scaledBackground.isNull() && !backgroundRect.isEmpty()) {
+            painter.drawPixmap(backgroundRect.topLeft(), scaledBackground,
+                               backgroundRect.translated(-scaledBackgroundRect.topLeft()));
+        }
+
+        // 按绘制层的不透明度和混合模式绘制当前图像内容
+        painter.save();
+        painter.setOpacity(documentLayer.opacity);
+        painter.setCompositionMode(documentLayer.mode);
+        if (documentLayer.visible) {
+            drawLayerRect(painter, image, contentRect, dirtyRect, &drawingMips);
+        }
+
+        // 如果正在绘制，绘制临时图像(预览)，再在其上绘制尚未固定的浮动末段
+        if (drawing) {
+            drawLayerRect(painter, tempImage, contentRect, dirtyRect);
+            if (currentShape && dirtyRect.intersects(physicalUpdateRect(floatingRect))) {
+                painter.save();
+                painter.setClipRect(dirtyRect.intersected(contentRect));
+                painter.translate(contentRect.topLeft());
+                painter.scale(static_cast<qreal>(contentRect.width()) / image.width(),
+                              static_cast<qreal>(contentRect.height()) / image.height());
+                currentShape->drawFloating(painter);
+                painter.restore();
+            }
+        }
+        painter.restore();
 
-    // 如果正在绘制，绘制临时图像(预览)
-    if (drawing) {
-        painter.drawImage(contentRect, tempImage, tempImage.rect());
+        // 上方图层都是普通混合模式时只需绘制合成好的上方缓存，否则逐层绘制
+        if (layersAbove && layers.isAboveCacheable()) {
+            drawLayerRect(painter, layers.above(logicalDirtyRect(contentRect, dirtyRect)),
+                          contentRect, dirtyRect, &aboveMips);
+        } else if (layersAbove) {
+            for (int i = layers.documentIndex() + 1; i < layers.count(); ++i) {
+                const LayerStack::Layer &layer = layers.layer(i);
+                if (!layer.visible) continue;
+                painter.save();
+                painter.setOpacity(layer.opacity);
+                painter.setCompositionMode(layer.mode);
+                drawLayerRect(painter, layer.canvas, contentRect, dirtyRect);
+                painter.restore();
+            }
+        }
     }
 
     // 如果正在选择区域，绘制选择框
@@ -216,55 +689,145 @@ void PaintArea::paintEvent(QPaintEvent *event)
             logicalToPhysical(selectionRect.bottomRight()))
                          );
     }
+
+    // 如果有选中的形状，绘制其范围(拖动时跟随鼠标)
+    if (!selectedIds.isEmpty()) {
+        QRect outline = selectionOutline();
+        painter.setPen(QPen(Qt::blue, 1, Qt::DashDotLine));  // 蓝色点划线
+        painter.setBrush(Qt::NoBrush);
+        painter.drawRect(QRect(
+            logicalToPhysical(outline.topLeft()),
+            logicalToPhysical(outline.bottomRight()))
+                         );
+    }
+}
+
+// 只绘制图层落在脏矩形内的部分：把窗口中的脏矩形映射回图层坐标，
+// 再逐个绘制其中已分配的图块，未分配的图块是透明的，直接跳过；
+// 缩小到一半以下时从缩小层级中取出对应区域，每帧只处理可见的像素
+void PaintArea::drawLayerRect(QPainter &painter, const TiledCanvas &layer,
+                              const QRect &contentRect, const QRect &dirtyRect,
+                              CanvasPyramid *pyramid)
+{
+    QRect targetRect = dirtyRect.intersected(contentRect);
+    if (targetRect.isEmpty() || layer.isNull()) return;
+
+    qreal sx = static_cast<qreal>(layer.width()) / contentRect.width();
+    qreal sy = static_cast<qreal>(layer.height()) / contentRect.height();
+    QRectF sourceRect((targetRect.x() - contentRect.x()) * sx,
+                      (targetRect.y() - contentRect.y()) * sy,
+                      targetRect.width() * sx,
+                      targetRect.height() * sy);
+
+    int level = pyramid ? Mipmap::levelFor(scaleFactor) : 0;
+    if (level > 0) {
+        // 平滑缩放会采样到区域外一个像素，更新范围向外扩展一个缩小后的像素
+        int margin = 1 << level;
+        const QImage &reduced = pyramid->level(layer, level,
+                                               sourceRect.toAlignedRect().adjusted(-margin, -margin, margin, margin));
+        qreal factor = Mipmap::levelScale(level);
+        painter.drawImage(QRectF(targetRect), reduced,
+                          QRectF(sourceRect.topLeft() * factor, sourceRect.size() * factor));
+        return;
+    }
+
+    painter.save();
+    painter.setClipRect(targetRect);
+    for (int index : layer.tilesIn(sourceRect.toAlignedRect())) {
+        if (!layer.hasTile(index)) continue;
+
+        // 图块在窗口中的位置，相邻图块的目标矩形首尾相接
+        QRect tileArea = layer.tileRect(index).intersected(layer.rect());
+        QRectF tileTarget(contentRect.x() + tileArea.x() / sx,
+                          contentRect.y() + tileArea.y() / sy,
+                          tileArea.width() / sx,
+                          tileArea.height() / sy);
+        painter.drawImage(tileTarget, layer.tile(index), QRectF(QPointF(0, 0), tileArea.size()));
+    }
+    painter.restore();
+}
+
+// 窗口中的脏矩形对应的画布区域(向外取整，包含被部分覆盖的像素)
+QRect PaintArea::logicalDirtyRect(const QRect &contentRect, const QRect &dirtyRect) const
+{
+    QRect targetRect = dirtyRect.intersected(contentRect);
+    if (targetRect.isEmpty() || contentRect.isEmpty()) return QRect();
+
+    qreal sx = static_cast<qreal>(image.width()) / contentRect.width();
+    qreal sy = static_cast<qreal>(image.height()) / contentRect.height();
+    return QRectF((targetRect.x() - contentRect.x()) * sx,
+                  (targetRect.y() - contentRect.y()) * sy,
+                  targetRect.width() * sx,
+                  targetRect.height() * sy).toAlignedRect();
 }
 
 // 鼠标按下事件处理
 void PaintArea::mousePressEvent(QMouseEvent *event)
 {
-    // 如果是区域选择模式
+    Profiler::Scope profile(Profiler::EventHandling);
+    recordEvent(event);
+
+    // 中键或按住空格时左键拖动平移视图
+    if (event->button() == Qt::MiddleButton ||
+        (event->button() == Qt::LeftButton && spaceHeld)) {
+        panning = true;
+        panStart = event->pos();
+        setCursor(Qt::ClosedHandCursor);
+        return;
+    }
+
+    // 如果是编组选择模式
     if (currentShapeType == GroupSelect) {
-        selectionStart = physicalToLogical(event->pos());  // 记录选择起点
-        isSelecting = true;
+        QPoint logicalPoint = physicalToLogical(event->pos());
+
+        // 不在已选中的形状上按下时，用命中测试选中点中的形状；
+        // 填充区域常常铺满空白处，按在未选中的填充上只选中它，拖动仍然框选
+        bool onFill = false;
+        if (!selectionContains(logicalPoint)) {
+            int hit = scene.shapeAt(logicalPoint);
+            setSelectedShapes(hit >= 0 ? QVector<int>{hit} : QVector<int>());
+            onFill = hit >= 0 && dynamic_cast<const FillShape *>(scene.shape(hit).data());
+        }
+
+        if (!selectedIds.isEmpty() && !onFill) {
+            // 开始拖动选中的形状
+            movingSelection = true;
+            moveStart = logicalPoint;
+            moveCurrent = logicalPoint;
+        } else {
+            // 点在空白处或未选中的填充上，开始框选
+            selectionStart = logicalPoint;  // 记录选择起点
+            selectionEnd = logicalPoint;
+            selectionRect = QRect();
+            isSelecting = true;
+        }
+        return;
+    }
+
+    // 油漆桶在按下时立即填充，没有拖动和预览
+    if (currentShapeType == Fill) {
+        if (event->button() == Qt::LeftButton && !loading) {
+            fillAt(physicalToLogical(event->pos()));
+        }
         return;
     }
 
-    // 左键按下开始绘制
-    if (event->button() == Qt::LeftButton) {
+    // 左键按下开始绘制(加载图像期间画布即将被替换，不接受绘制)
+    if (event->button() == Qt::LeftButton && !loading) {
         QPoint logicalPoint = physicalToLogical(event->pos());  // 转换为逻辑坐标
         drawing = true;
-        tempImage = image.copy();  // 复制当前图像到临时图像
+        // 预览图层只在尺寸变化时重新分配，平时保持透明
+        if (tempImage.size() != image.size()) {
+            resetPreview();
+        }
 
         // 根据当前形状类型创建对应的Shape对象
-        switch(currentShapeType) {
-        case Freehand:  // 自由绘制
-            currentShape = new PathShape(logicalPoint, penColor, penWidth, false);
-            break;
-        case Line:      // 直线
-            currentShape = new LineShape(logicalPoint, penColor, penWidth);
-            break;
-        case Rectangle: // 矩形
-            currentShape = new RectangleShape(logicalPoint, penColor, penWidth);
-            break;
-        case Ellipse:   // 椭圆
-            currentShape = new EllipseShape(logicalPoint, penColor, penWidth);
-            break;
-        case Arrow:     // 箭头
-            currentShape = new ArrowShape(logicalPoint, penColor, penWidth);
-            break;
-        case Star:      // 星形
-            currentShape = new StarShape(logicalPoint, penColor, penWidth);
-            break;
-        case Diamond:   // 菱形
-            currentShape = new DiamondShape(logicalPoint, penColor, penWidth);
-            break;
-        case Heart:     // 心形
-            currentShape = new HeartShape(logicalPoint, penColor, penWidth);
-            break;
-        case Eraser:    // 橡皮擦
-            currentShape = new PathShape(logicalPoint, Qt::white, penWidth, true);
-            break;
-        case GroupSelect: // 已在上面处理
-            break;
+        currentShape = createShape(currentShapeType, logicalPoint, penColor, penWidth);
+
+        // 自由绘制和橡皮擦按设置简化和平滑笔画
+        if (PathShape *path = dynamic_cast<PathShape *>(currentShape.get())) {
+            path->setTolerance(strokeTolerance);
+            path->setSmoothing(strokeSmoothing);
         }
     }
 }
@@ -272,99 +835,296 @@ void PaintArea::mousePressEvent(QMouseEvent *event)
 // 鼠标移动事件处理
 void PaintArea::mouseMoveEvent(QMouseEvent *event)
 {
-    // 发射光标位置变化信号
+    Profiler::Scope profile(Profiler::EventHandling);
+    recordEvent(event);
+
+    // 正在平移时只移动视图
+    if (panning) {
+        panBy(event->pos() - panStart);
+        panStart = event->pos();
+        return;
+    }
+
+    // 光标位置变化信号在下一帧发出，同一帧内的多次移动只发出最后的位置
     QPoint currentLogicalPos = physicalToLogical(event->pos());
-    emit cursorPositionChanged(currentLogicalPos);
+    pendingCursorPos = currentLogicalPos;
+    cursorPending = true;
+    scheduleFrame();
 
     // 如果是区域选择模式
     if (isSelecting) {
+        QRect oldRect = selectionRect;
         selectionEnd = currentLogicalPos;
         selectionRect = QRect(selectionStart, selectionEnd).normalized();  // 标准化矩形
-        tempImage = image.copy();
-        // 在选择区域绘制虚线框
-        QPainter painter(&tempImage);
-        painter.setPen(QPen(Qt::blue, 1, Qt::DashLine));
-        painter.drawRect(selectionRect);
-        update();  // 触发重绘
+        // 选择框由paintEvent直接绘制，只需刷新新旧选择框覆盖的区域
+        update(physicalUpdateRect(oldRect.united(selectionRect)));
         return;
     }
 
-    // 如果正在绘制且有当前形状
+    // 如果正在拖动选中的形状，只移动范围框，释放时再真正移动形状
+    if (movingSelection) {
+        QRect oldOutline = selectionOutline();
+        moveCurrent = currentLogicalPos;
+        update(physicalUpdateRect(oldOutline.united(selectionOutline())));
+        return;
+    }
+
+    // 如果正在绘制且有当前形状：每个采样点都更新形状几何，预览在下一帧统一重绘
     if ((event->buttons() & Qt::LeftButton) && drawing && currentShape) {
         currentShape->update(currentLogicalPos);  // 更新形状
-
-        // 实时绘制到临时图像
-        tempImage = image.copy();
-        QPainter painter(&tempImage);
-        currentShape->draw(painter);  // 绘制当前形状
-
-        update();  // 触发重绘
+        previewPending = true;
     }
 }
 
 // 鼠标释放事件处理
 void PaintArea::mouseReleaseEvent(QMouseEvent *event)
 {
-    // 如果是区域选择模式
+    Profiler::Scope profile(Profiler::EventHandling);
+    recordEvent(event);
+
+    // 结束平移
+    if (panning) {
+        panning = false;
+        if (spaceHeld) {
+            setCursor(Qt::OpenHandCursor);
+        } else {
+            unsetCursor();
+        }
+        return;
+    }
+
+    // 如果是区域选择模式，选中完全位于选择框内的形状(没有拖动时保留按下时的选择)
     if (isSelecting) {
         isSelecting = false;
-        if (!selectionRect.isNull()) {
-            // 复制选择区域并移动
-            QImage newImage = image.copy();
-            QPainter painter(&newImage);
-            QPoint logicalEnd = physicalToLogical(event->pos());
-            QPoint offset = logicalEnd - selectionStart;
-
-            QImage selectedArea = image.copy(selectionRect);
-            painter.fillRect(selectionRect, Qt::white);  // 清除原位置
-            painter.drawImage(selectionRect.translated(offset), selectedArea, selectionRect);
-
-            image = newImage;
-            saveState();  // 保存状态
-            update();     // 触发重绘
+        QRect band = selectionRect;
+        selectionRect = QRect();
+        if (selectionEnd != selectionStart) {
+            setSelectedShapes(scene.shapesContainedIn(band));
+        }
+        update(physicalUpdateRect(band));  // 擦除选择框
+        return;
+    }
+
+    // 如果正在拖动选中的形状，按拖动距离移动形状
+    if (movingSelection) {
+        movingSelection = false;
+        QPoint delta = physicalToLogical(event->pos()) - moveStart;
+        if (!delta.isNull()) {
+            moveSelectedShapes(delta);
         }
         return;
     }
 
     // 如果是左键释放且正在绘制
     if (event->button() == Qt::LeftButton && drawing && currentShape) {
-        QPainter painter(&image);
-        currentShape->draw(painter);  // 将形状绘制到主图像
+        QRect dirty = previewRect.united(currentShape->paintRect());
+        clearPreview();  // 形状已提交，清除预览
 
-        delete currentShape;  // 释放形状对象
-        currentShape = nullptr;
+        // 形状的副本交给绘制命令，由命令将形状绘制到主图像并加入文档；
+        // 正在绘制的形状回到对象池，下一笔复用它的路径点缓冲区
+        HistoryCommand *command = new ShapeCommand(scene.allocateId(),
+                                                   ShapeFactory::share(currentShape->clone()));
+        currentShape.reset();
+        command->apply(originalImage, image);
+        command->applyScene(scene);
+        commitCommand(command);  // 记录到历史
 
-        saveState();    // 保存状态
         drawing = false; // 结束绘制
-        update();       // 触发重绘
+        update(physicalUpdateRect(dirty));  // 只刷新形状所在区域
+    }
+}
+
+// 安排在下一帧刷新：距上一次刷新已超过一帧时在本轮事件处理后立即刷新，
+// 否则等到一帧结束，期间到达的移动事件只累积到形状几何中
+void PaintArea::scheduleFrame()
+{
+    if (frameTimer->isActive()) return;
+
+    qint64 wait = frameInterval() - frameClock.elapsed();
+    frameTimer->start(qMax<qint64>(0, wait));
+}
+
+// 刷新积压的预览和光标位置
+void PaintArea::flushFrame()
+{
+    frameClock.restart();
+
+    // 形状在等待期间可能已经提交，此时不再需要预览
+    if (previewPending && drawing && currentShape) {
+        updatePreview();  // 局部重绘预览
+    }
+    previewPending = false;
+
+    if (cursorPending) {
+        cursorPending = false;
+        emit cursorPositionChanged(pendingCursorPos);
+    }
+}
+
+// 一帧的时长，按控件所在屏幕的刷新率计算(无法获取时按60Hz)
+int PaintArea::frameInterval() const
+{
+    QScreen *current = screen();
+    qreal rate = current ? current->refreshRate() : 0;
+    return rate > 0 ? qMax(1, qRound(1000.0 / rate)) : 16;
+}
+
+// 重置预览图层：与主图像等大且完全透明
+void PaintArea::resetPreview()
+{
+    tempImage = TiledCanvas(image.size());
+    previewRect = QRect();
+    floatingRect = QRect();
+}
+
+// 在预览图层上局部重绘当前形状
+// 只清除上一帧形状所在区域并重绘新形状，开销与形状大小相关而与画布大小无关
+void PaintArea::updatePreview()
+{
+    Profiler::Scope profile(Profiler::PreviewRaster);
+
+    // 自由绘制/橡皮擦等只追加的形状：预览图层即持久笔画缓冲区，只画新增的固定线段；
+    // 简化时浮动的末段不写入缓冲区，由paintEvent每帧绘制，只需刷新它的新旧位置
+    if (currentShape->isIncremental()) {
+        QRect newRect = currentShape->pendingRect().intersected(tempImage.rect());
+        tempImage.paint(newRect, [this](QPainter &painter, const QRect &) {
+            currentShape->drawPending(painter);
+        });
+        currentShape->markDrawn();
+        QRect oldFloating = floatingRect;
+        floatingRect = currentShape->floatingRect().intersected(tempImage.rect());
+        previewRect = previewRect.united(newRect).united(floatingRect);
+        update(physicalUpdateRect(newRect.united(oldFloating).united(floatingRect)));  // 只刷新变化的线段
+        return;
     }
+
+    QRect newRect = currentShape->paintRect().intersected(tempImage.rect());
+    QRect dirty = previewRect.united(newRect);
+
+    // 用透明色覆盖旧形状所在区域，再只在新形状覆盖的图块上绘制
+    tempImage.clearRect(previewRect);
+    tempImage.paint(newRect, [this](QPainter &painter, const QRect &) {
+        currentShape->draw(painter);
+    });
+
+    previewRect = newRect;
+    update(physicalUpdateRect(dirty));  // 只刷新新旧形状覆盖的区域
 }
 
-// 清除选择区域
+// 清除预览图层上残留的形状
+void PaintArea::clearPreview()
+{
+    if (previewRect.isEmpty()) return;
+
+    tempImage.clearRect(previewRect);
+    previewRect = QRect();
+    floatingRect = QRect();
+}
+
+// 逻辑脏矩形转换为窗口中需要刷新的区域
+QRect PaintArea::physicalUpdateRect(const QRect &logicalRect) const
+{
+    if (logicalRect.isEmpty()) return QRect();
+
+    // 缩放时坐标取整可能丢失像素，向外多扩展一些
+    int margin = static_cast<int>(std::ceil(scaleFactor)) + 1;
+    return logicalToPhysical(logicalRect).adjusted(-margin, -margin, margin, margin);
+}
+
+// 清除选择区域和选中的形状
 void PaintArea::clearSelection()
 {
     isSelecting = false;
+    movingSelection = false;
     selectionRect = QRect();
+    selectedIds.clear();
+    selectedRect = QRect();
     update();  // 触发重绘
 }
 
-// 撤销操作
-void PaintArea::undo()
+// 设置选中的形状并刷新新旧范围框
+void PaintArea::setSelectedShapes(const QVector<int> &ids)
 {
-    if (undoStack.size() > 1) {
-        redoStack.push(undoStack.pop());  // 从撤销栈弹出并压入重做栈
-        QImage stateImage = undoStack.top();  // 获取上一个状态
+    QRect oldOutline = selectedRect;
+    selectedIds = ids;
+    selectedRect = scene.paintRect(ids);
+    update(physicalUpdateRect(oldOutline.united(selectedRect)));
+}
 
-        // 恢复状态
-        originalImage = QImage(stateImage.size(), QImage::Format_ARGB32_Premultiplied);
-        originalImage.fill(Qt::transparent);
-        QPainter painter(&originalImage);
-        painter.drawImage(0, 0, stateImage);
+// 点是否落在某个选中的形状上(按形状实际绘制的像素，不按范围框)
+bool PaintArea::selectionContains(const QPoint &point) const
+{
+    if (!selectedRect.contains(point)) return false;
+    for (int id : selectedIds) {
+        if (scene.shape(id)->contains(point)) return true;
+    }
+    return false;
+}
+
+// 选中形状的范围框，拖动时跟随鼠标偏移
+QRect PaintArea::selectionOutline() const
+{
+    return movingSelection ? selectedRect.translated(moveCurrent - moveStart) : selectedRect;
+}
 
-        image = QImage(stateImage.size(), QImage::Format_ARGB32_Premultiplied);
-        image.fill(Qt::transparent);
+// 移动选中的形状：平移文档中的形状，只重绘新旧位置覆盖的区域
+void PaintArea::moveSelectedShapes(const QPoint &delta)
+{
+    QRect oldRect = selectedRect;
+    scene.translate(selectedIds, delta);
+    selectedRect = scene.paintRect(selectedIds);
 
-        // 触发大小调整事件
+    QRect dirty = oldRect.united(selectedRect).intersected(image.rect());
+    renderScene(dirty);
+
+    // 记录移动命令，保存受影响区域移动后的像素供命令历史重放
+    commitCommand(new MoveShapesCommand(selectedIds, delta, dirty, image.toImage(dirty)));
+    update(physicalUpdateRect(oldRect.united(selectedRect)));
+}
+
+// 按文档重绘绘制层的指定区域：清空该区域后按顺序重绘与之相交的形状
+void PaintArea::renderScene(const QRect &region)
+{
+    if (region.isEmpty()) return;
+
+    // 每个图块只重绘与它相交的形状
+    image.clearRect(region);
+    image.paint(region, [this](QPainter &painter, const QRect &tileClip) {
+        scene.render(painter, tileClip);
+    });
+}
+
+// 油漆桶填充：按背景和绘制层合成后的颜色找出连通区域，作为填充形状加入文档，
+// 与其他形状一样可以移动、保存和导出；绘制层只有区域覆盖的图块被写入，历史也只记录这些图块
+void PaintArea::fillAt(const QPoint &logicalPoint)
+{
+    if (!image.rect().contains(logicalPoint)) return;
+
+    QVector<QRect> region = FloodFill::fill(originalImage, image, logicalPoint, fillTolerance);
+    if (region.isEmpty()) return;
+
+    ShapeHandle shape = createShape(Fill, logicalPoint, penColor, 0);
+    static_cast<FillShape *>(shape.get())->setRegion(region);
+    QRect dirty = shape->paintRect();
+
+    HistoryCommand *command = new ShapeCommand(scene.allocateId(), ShapeFactory::share(std::move(shape)));
+    command->apply(originalImage, image);
+    command->applyScene(scene);
+    commitCommand(command);  // 记录到历史
+    update(physicalUpdateRect(dirty));  // 只刷新填充区域
+}
+
+// 撤销操作
+void PaintArea::undo()
+{
+    Profiler::Scope profile(Profiler::History);
+    // 图块历史只把记录的图块写回，命令历史从最近的检查点重放
+    clearSelection();  // 选中的形状可能被撤销
+    bool changed = historyMode == CommandHistoryMode ?
+                       commandHistory.undo(originalImage, image, scene) :
+                       history.undo(originalImage, image, scene);
+    if (changed) {
+        // 背景可能被整体替换，触发大小调整事件以更新缩放和图层尺寸
         QResizeEvent fakeEvent(size(), size());
         resizeEvent(&fakeEvent);
         update();  // 触发重绘
@@ -374,19 +1134,12 @@ void PaintArea::undo()
 // 重做操作
 void PaintArea::redo()
 {
-    if (!redoStack.isEmpty()) {
-        undoStack.push(redoStack.pop());  // 从重做栈弹出并压入撤销栈
-        QImage stateImage = undoStack.top();  // 获取状态
-
-        // 恢复状态
-        originalImage = QImage(stateImage.size(), QImage::Format_ARGB32_Premultiplied);
-        originalImage.fill(Qt::transparent);
-        QPainter painter(&originalImage);
-        painter.drawImage(0, 0, stateImage);
-
-        image = QImage(stateImage.size(), QImage::Format_ARGB32_Premultiplied);
-        image.fill(Qt::transparent);
-
+    Profiler::Scope profile(Profiler::History);
+    clearSelection();
+    bool changed = historyMode == CommandHistoryMode ?
+                       commandHistory.redo(originalImage, image, scene) :
+                       history.redo(originalImage, image, scene);
+    if (changed) {
         // 触发大小调整事件
         QResizeEvent fakeEvent(size(), size());
         resizeEvent(&fakeEvent);
@@ -394,22 +1147,142 @@ void PaintArea::redo()
     }
 }
 
-// 保存当前状态到撤销栈
-void PaintArea::saveState()
+// 把当前状态的变化记录到历史(用于无法表示为命令的操作，如加载图像)
+// command只用于撤销/重做时同步文档，可以为空
+void PaintArea::saveState(HistoryCommand *command)
 {
-    // 创建状态图像：如果有原始图像则使用原始图像，否则使用当前图像
-    QImage stateImage = originalImage.isNull() ?
-                            image.copy() :
-                            originalImage.copy();
+    Profiler::Scope profile(Profiler::History);
+    if (historyMode == CommandHistoryMode) {
+        commandHistory.recordCheckpoint(originalImage, image, command);
+    } else {
+        // 与上一次记录的状态按图块比较
+        history.commit(originalImage, image, command);
+    }
+}
 
-    // 将当前绘制内容合并到状态图像
-    QPainter painter(&stateImage);
-    painter.drawImage(0, 0, image);
+// 记录一条已经应用到图像和文档上的命令
+void PaintArea::commitCommand(HistoryCommand *command)
+{
+    Profiler::Scope profile(Profiler::History);
+    if (historyMode == CommandHistoryMode) {
+        commandHistory.record(command, originalImage, image);
+    } else {
+        // 图块历史比较像素，命令只用于同步文档
+        history.commit(originalImage, image, command);
+    }
+}
+
+// 切换历史模式，新的历史以当前图像为起点
+void PaintArea::setHistoryMode(HistoryMode mode)
+{
+    if (mode == historyMode) return;
+
+    historyMode = mode;
+    if (historyMode == CommandHistoryMode) {
+        commandHistory.reset(originalImage, image);
+    } else {
+        history.reset(originalImage, image);
+    }
+}
+
+// 设置命令历史的检查点间隔
+void PaintArea::setCheckpointInterval(int interval)
+{
+    commandHistory.setCheckpointInterval(interval);
+}
+
+// 设置历史内存预算
+void PaintArea::setHistoryBudget(qint64 bytes)
+{
+    history.setByteBudget(bytes);
+}
+
+// 获取历史内存预算
+qint64 PaintArea::historyBudget() const
+{
+    return history.byteBudget();
+}
+
+// 开始录制鼠标输入，记录当前控件尺寸、视图状态和绘制层内容
+void PaintArea::startRecording()
+{
+    trace = InputTrace();
+    trace.widgetSize = size();
+    trace.fitToWindow = fitToWindow;
+    trace.zoom = scaleFactor;
+    trace.offset = offset;
+    trace.startHash = contentHash();
+    recording = true;
+    recordClock.start();
+}
+
+// 结束录制并返回录制的输入
+InputTrace PaintArea::stopRecording()
+{
+    if (!recording) return InputTrace();
+
+    recording = false;
+    trace.endHash = contentHash();
+    InputTrace result = trace;
+    trace = InputTrace();
+    return result;
+}
+
+// 录制时记录一个鼠标事件，按下事件同时记录当时的工具参数
+void PaintArea::recordEvent(QMouseEvent *event)
+{
+    if (!recording) return;
 
-    // 如果状态有变化，保存到撤销栈
-    if (undoStack.isEmpty() || undoStack.top() != stateImage) {
-        undoStack.push(stateImage);
-        if (undoStack.size() > 50) undoStack.removeFirst();  // 限制栈大小
-        redoStack.clear();  // 清空重做栈
+    InputTrace::Event recorded;
+    recorded.type = event->type();
+    recorded.time = recordClock.nsecsElapsed() / 1000;
+    recorded.pos = event->pos();
+    recorded.button = event->button();
+    recorded.buttons = event->buttons();
+    if (recorded.type == QEvent::MouseButtonPress) {
+        recorded.tool = currentShapeType;
+        recorded.color = penColor;
+        recorded.width = penWidth;
+        recorded.tolerance = strokeTolerance;
+        recorded.smoothing = strokeSmoothing;
+        recorded.fillTolerance = fillTolerance;
     }
+    trace.events.append(recorded);
+}
+
+// 录制时记录一个滚轮事件，回放时按相同位置和增量缩放
+void PaintArea::recordEvent(QWheelEvent *event)
+{
+    if (!recording) return;
+
+    InputTrace::Event recorded;
+    recorded.type = QEvent::Wheel;
+    recorded.time = recordClock.nsecsElapsed() / 1000;
+    recorded.pos = event->position().toPoint();
+    recorded.buttons = event->buttons();
+    recorded.delta = event->angleDelta().y();
+    trace.events.append(recorded);
+}
+
+// 录制时记录改变视图的按键：空格按下/松开(自动重复除外)和方向键按下
+void PaintArea::recordEvent(QKeyEvent *event)
+{
+    if (!recording) return;
+
+    int key = event->key();
+    bool space = key == Qt::Key_Space && !event->isAutoRepeat();
+    bool arrow = event->type() == QEvent::KeyPress && key >= Qt::Key_Left && key <= Qt::Key_Down;
+    if (!space && !arrow) return;
+
+    InputTrace::Event recorded;
+    recorded.type = event->type();
+    recorded.time = recordClock.nsecsElapsed() / 1000;
+    recorded.key = key;
+    trace.events.append(recorded);
+}
+
+// 绘制层的内容哈希
+quint64 PaintArea::contentHash() const
+{
+    return image.contentHash();
 }
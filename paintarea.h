@@ -5,10 +5,21 @@
 #include <QMouseEvent>
 #include <QWidget>
 #include <QImage>
+#include <QPixmap>
 #include <QPainter>
-#include <QStack>
 #include <QPoint>
 #include "shapes.h"
+#include "tilehistory.h"
+#include "commandhistory.h"
+#include "scene.h"
+#include "tiledcanvas.h"
+#include "imagesaver.h"
+#include "imageloader.h"
+#include "inputtrace.h"
+#include "layerstack.h"
+#include "mipmap.h"
+#include <QElapsedTimer>
+#include <QTimer>
 
 /**
  * @brief 绘图区域类，负责实际的绘图功能和图像处理
@@ -37,7 +48,16 @@ public:
         Diamond,       // 6:菱形
         Heart,         // 7:心形
         Eraser,        // 8:橡皮擦
-        GroupSelect    // 9:编组选择
+        GroupSelect,   // 9:编组选择
+        Fill           // 10:油漆桶填充
+    };
+
+    /**
+     * @brief 历史记录模式枚举
+     */
+    enum HistoryMode {
+        TileHistoryMode,     // 0:按图块记录像素差量
+        CommandHistoryMode   // 1:记录形状命令并定期保存栅格检查点
     };
 
     // 构造函数和功能方法
@@ -45,11 +65,96 @@ public:
     void setPenColor(const QColor &color);  // 设置画笔颜色
     void setPenWidth(int width);  // 设置画笔宽度
     void setDrawShape(DrawShape shape);  // 设置绘图形状
-    void saveImage(const QString &fileName);  // 保存图像到文件
-    void loadImage(const QString &fileName);  // 从文件加载图像
+    void setStrokeTolerance(double tolerance);  // 设置自由绘制/橡皮擦笔画的简化容差(像素，0为不简化)
+    void setStrokeSmoothing(bool smooth);  // 设置自由绘制/橡皮擦笔画是否平滑
+    void setFillTolerance(int tolerance);  // 设置油漆桶的颜色容差(0-255)
+
+    /**
+     * @brief 按绘图形状从形状工厂创建对应的形状对象
+     * @param type 绘图形状(橡皮擦总是使用白色)
+     * @param start 起点坐标
+     * @param color 画笔颜色
+     * @param width 画笔宽度
+     * @return 来自对象池的新形状，释放时自动回到对象池；编组选择没有对应的形状，返回空；
+     *         油漆桶返回区域为空的填充形状
+     */
+    static ShapeHandle createShape(DrawShape type, const QPoint &start, const QColor &color, int width);
+    /**
+     * @brief 在后台保存图像到文件，编码格式由扩展名决定；.ppd保存为工程文件(含形状，可继续编辑)，
+     *        .svg/.pdf导出为与分辨率无关的矢量文件
+     * @param fileName 文件名
+     * @param options 编码质量/压缩选项
+     * @return 已有保存任务在进行时返回false
+     */
+    bool saveImage(const QString &fileName,
+                   const ImageSaver::Options &options = ImageSaver::Options());
+    void cancelSave();  // 取消正在进行的保存
+    bool isSaving() const;  // 是否正在后台保存
+    /**
+     * @brief 在后台从文件加载图像或工程文件，先显示预览再替换为全分辨率图像
+     * @param fileName 文件名
+     * @return 已有加载任务在进行时返回false
+     */
+    bool loadImage(const QString &fileName);
+    bool isLoading() const;  // 是否正在后台加载图像
     void undo();  // 撤销操作
     void redo();  // 重做操作
-    void clearSelection();  // 清除选择
+    void clearSelection();  // 清除选择区域和选中的形状
+    const QVector<int> &selectedShapes() const { return selectedIds; }  // 选中的形状id
+
+    /**
+     * @brief 设置撤销/重做历史可占用的内存预算
+     * @param bytes 预算字节数，超出时丢弃最早的历史记录
+     */
+    void setHistoryBudget(qint64 bytes);
+    qint64 historyBudget() const;  // 获取历史内存预算(字节)
+    void setHistoryMode(HistoryMode mode);  // 切换历史模式(会以当前图像重新开始记录)
+    HistoryMode currentHistoryMode() const { return historyMode; }  // 获取当前历史模式
+    void setCheckpointInterval(int interval);  // 设置命令历史每隔多少条命令保存检查点
+
+    void startRecording();  // 开始录制鼠标输入
+    InputTrace stopRecording();  // 结束录制并返回录制的输入
+    bool isRecording() const { return recording; }  // 是否正在录制
+    quint64 contentHash() const;  // 绘制层的内容哈希，用于比较回放结果
+
+    // 图层：笔画总是画在绘制层上，其余图层是导入的栅格图层(图层操作不进入撤销历史)
+    const LayerStack &layerStack() const { return layers; }  // 图层栈
+    /**
+     * @brief 在后台加载图像文件，作为新的栅格图层放在最上方
+     * @param fileName 图像文件名(不能是工程文件)
+     * @return 已有导入任务在进行时返回false
+     */
+    bool importLayer(const QString &fileName);
+    void removeLayer(int index);  // 删除栅格图层
+    void moveLayer(int from, int to);  // 调整图层顺序
+    void setLayerVisible(int index, bool visible);  // 显示或隐藏图层
+    void setLayerOpacity(int index, qreal opacity);  // 设置图层不透明度(0-1)
+    void setLayerBlendMode(int index, QPainter::CompositionMode mode);  // 设置图层混合模式
+
+    // 缩放与平移：滚轮以光标为中心缩放，中键或按住空格拖动平移，方向键平移
+    static constexpr double MinZoom = 0.05;  // 最小缩放比例
+    static constexpr double MaxZoom = 8.0;  // 最大缩放比例
+    double zoom() const { return scaleFactor; }  // 当前缩放比例(1为原尺寸)
+    bool isFitToWindow() const { return fitToWindow; }  // 是否为适应窗口模式
+    /**
+     * @brief 设置缩放比例，锚点下的画布位置保持不动
+     * @param factor 缩放比例，限制在MinZoom到MaxZoom之间
+     * @param anchor 锚点(窗口坐标)
+     */
+    void setZoom(double factor, const QPoint &anchor);
+    void zoomIn();  // 以窗口中心放大一级
+    void zoomOut();  // 以窗口中心缩小一级
+    void zoomToFit();  // 适应窗口(窗口大小改变时跟随)
+    void zoomActualSize();  // 原尺寸(100%)
+    void panBy(const QPoint &delta);  // 按窗口像素平移视图
+    QPoint viewOffset() const { return offset; }  // 画布在窗口中的偏移
+    /**
+     * @brief 直接恢复视图状态(用于回放录制的输入)
+     * @param fit 是否适应窗口，为true时忽略其余参数
+     * @param factor 缩放比例，限制在MinZoom到MaxZoom之间
+     * @param viewOffset 画布在窗口中的偏移(窗口坐标)
+     */
+    void setView(bool fit, double factor, const QPoint &viewOffset);
 
 protected:
     // 重写的Qt事件处理函数
@@ -58,6 +163,9 @@ protected:
     void mouseMoveEvent(QMouseEvent *event) override;  // 鼠标移动事件
     void mouseReleaseEvent(QMouseEvent *event) override;  // 鼠标释放事件
     void resizeEvent(QResizeEvent *event) override;  // 大小改变事件
+    void wheelEvent(QWheelEvent *event) override;  // 滚轮缩放
+    void keyPressEvent(QKeyEvent *event) override;  // 空格进入平移、方向键平移
+    void keyReleaseEvent(QKeyEvent *event) override;  // 松开空格结束平移
 
 private:
     // 坐标转换辅助函数
@@ -65,34 +173,115 @@ private:
     QPoint logicalToPhysical(const QPoint &logicalPoint) const;  // 逻辑坐标转物理坐标
     QRect logicalToPhysical(const QRect &logicalRect) const;  // 逻辑矩形转物理矩形
     void updateScaleAndOffset();  // 更新缩放比例和偏移量
-    void saveState();  // 保存当前状态到撤销栈
+    void clampOffset();  // 限制偏移量：画布小于窗口时居中，否则不露出画布以外的区域
+    QRect canvasRect() const;  // 画布内容在窗口中所占的区域
+    void rebuildScaledBackground();  // 重建缩放后的背景缓存
+    void drawLayerRect(QPainter &painter, const TiledCanvas &layer,
+                       const QRect &contentRect, const QRect &dirtyRect,
+                       CanvasPyramid *pyramid = nullptr);  // 只绘制图层落在脏矩形内的部分(缩小时使用对应层级)
+    QRect logicalDirtyRect(const QRect &contentRect, const QRect &dirtyRect) const;  // 窗口脏矩形对应的画布区域
+    void syncLayers();  // 图层栈跟随绘制层尺寸和背景
+    void layersModified();  // 图层改变后重绘并通知外部
+    void saveState(HistoryCommand *command = nullptr);  // 把当前状态的变化记录到历史
+    void commitCommand(HistoryCommand *command);  // 记录已应用的命令(接管所有权)
+    void recordEvent(QMouseEvent *event);  // 录制时记录一个鼠标事件
+    void recordEvent(QWheelEvent *event);  // 录制时记录一个滚轮事件
+    void recordEvent(QKeyEvent *event);  // 录制时记录一个改变视图的按键事件
+    void replaceDrawing(const TiledCanvas &drawing);  // 替换绘制层，尺寸不变时逐图块替换以便历史记录差量
+
+    // 文档与编组选择辅助函数
+    void setSelectedShapes(const QVector<int> &ids);  // 设置选中的形状
+    QRect selectionOutline() const;  // 选中形状的范围框(拖动时带偏移)
+    bool selectionContains(const QPoint &point) const;  // 点是否落在某个选中的形状上
+    void moveSelectedShapes(const QPoint &delta);  // 移动选中的形状并局部重绘
+    void renderScene(const QRect &region);  // 按文档重绘绘制层的指定区域
+    void fillAt(const QPoint &logicalPoint);  // 从指定位置进行油漆桶填充并提交为填充形状
+
+    // 预览相关辅助函数
+    void resetPreview();  // 重置预览图层为与主图像等大的透明图像
+    void updatePreview();  // 仅在脏矩形内重绘当前形状的预览
+    void clearPreview();  // 清除预览图层上残留的形状
+    QRect physicalUpdateRect(const QRect &logicalRect) const;  // 逻辑脏矩形转为需要刷新的窗口区域
+
+    // 输入合并：移动事件只更新形状几何，预览和光标位置每帧最多刷新一次
+    void scheduleFrame();  // 安排在下一帧刷新积压的预览和光标位置
+    void flushFrame();  // 刷新积压的预览和光标位置
+    int frameInterval() const;  // 一帧的时长(毫秒)，按屏幕刷新率计算
 
     // 图像相关成员
     QSize origImageSize;  // 原始图像尺寸
     double scaleFactor;  // 缩放因子
     QPoint offset;  // 偏移量
 
-    QImage image;  // 主图像
+    TiledCanvas image;  // 绘制层(稀疏分块，只包含文档中的形状)
     QImage originalImage;  // 原始图像(用于缩放)
-    QImage tempImage;  // 临时图像(用于绘制过程中的预览)
+    QPixmap scaledBackground;  // 按当前缩放比例缩放好的背景可见部分
+    double scaledBackgroundScale;  // 背景缓存对应的缩放比例
+    qint64 scaledBackgroundKey;  // 背景缓存对应的原始图像cacheKey
+    QRect scaledBackgroundRect;  // 背景缓存在窗口中的位置(画布与窗口的交集)
+    QPoint scaledBackgroundOffset;  // 背景缓存对应的偏移量
+    bool fitToWindow;  // 是否适应窗口(否则使用固定的缩放比例)
+    bool panning;  // 是否正在拖动平移
+    bool spaceHeld;  // 是否按住空格(左键拖动变为平移)
+    QPoint panStart;  // 上一次平移的鼠标位置
+    ImagePyramid backgroundMips;  // 背景的各个缩小层级
+    CanvasPyramid drawingMips;  // 绘制层当前的缩小层级
+    CanvasPyramid belowMips;  // 下方图层缓存当前的缩小层级
+    CanvasPyramid aboveMips;  // 上方图层缓存当前的缩小层级
+    TiledCanvas tempImage;  // 预览图层(稀疏分块，仅包含正在绘制的形状)
+    QRect previewRect;  // 预览图层上一帧形状所占的逻辑区域
+    QRect floatingRect;  // 上一帧每帧直接绘制的浮动末段所占的逻辑区域
+    QTimer *frameTimer;  // 按帧刷新积压工作的单次定时器
+    QElapsedTimer frameClock;  // 上一次刷新后的时间
+    bool previewPending;  // 当前形状是否有尚未绘制到预览的采样点
+    bool cursorPending;  // 光标位置是否有尚未发出的变化
+    QPoint pendingCursorPos;  // 最新的光标逻辑位置
 
     // 选择相关成员
     bool isSelecting;  // 是否正在选择
     QRect selectionRect;  // 选择矩形
     QPoint selectionStart;  // 选择开始点
     QPoint selectionEnd;  // 选择结束点
+    QVector<int> selectedIds;  // 选中的形状id
+    QRect selectedRect;  // 选中形状的绘制范围
+    bool movingSelection;  // 是否正在拖动选中的形状
+    QPoint moveStart;  // 拖动起点
+    QPoint moveCurrent;  // 拖动当前点
 
     // 绘图相关成员
     bool drawing;  // 是否正在绘图
     DrawShape currentShapeType;  // 当前绘图形状类型
-    Shape* currentShape;  // 当前正在绘制的形状对象
+    ShapeHandle currentShape;  // 当前正在绘制的形状对象(提交时复制一份，自身回到对象池)
 
     QColor penColor;  // 画笔颜色
     int penWidth;  // 画笔宽度
+    double strokeTolerance;  // 笔画简化容差(像素)
+    bool strokeSmoothing;  // 笔画是否平滑
+    int fillTolerance;  // 油漆桶的颜色容差
+
+    ImageSaver *imageSaver;  // 后台保存任务
+    ImageLoader *imageLoader;  // 后台加载任务
+    bool loading;  // 是否正在加载图像
+    QImage loadingPreview;  // 加载过程中显示的预览图
+    QSize loadingSize;  // 正在加载的图像的全分辨率尺寸
+
+    // 图层栈：背景与绘制层之外的栅格图层及合成缓存
+    LayerStack layers;
+    ImageLoader *layerLoader;  // 后台导入图层任务
+    QString layerName;  // 正在导入的图层名称
 
-    // 撤销/重做栈
-    QStack<QImage> undoStack;  // 撤销栈
-    QStack<QImage> redoStack;  // 重做栈
+    // 文档模型：所有已提交的形状及其空间索引
+    Scene scene;
+
+    // 撤销/重做历史
+    HistoryMode historyMode;  // 当前历史模式
+    TileHistory history;  // 图块差量历史
+    CommandHistory commandHistory;  // 命令历史
+
+    // 输入录制
+    bool recording;  // 是否正在录制
+    InputTrace trace;  // 已录制的输入
+    QElapsedTimer recordClock;  // 录制开始后的时间
 
 signals:
     /**
@@ -100,6 +289,21 @@ signals:
      * @param pos 新的光标位置
      */
     void cursorPositionChanged(const QPoint& pos);
+
+    void saveProgressChanged(int percent);  // 后台保存进度(0-100)
+    void saveFinished(bool ok, const QString &message);  // 后台保存结束
+    void loadFinished(bool ok, const QString &message);  // 后台加载结束
+    void layersChanged();  // 图层列表或图层属性改变
+    void zoomChanged(double factor);  // 缩放比例改变
+
+private slots:
+    void onLoadPreview(const QImage &preview, const QSize &fullSize);  // 预览图解码完成
+    void onImageLoaded(const QImage &loadedImage);  // 全分辨率图像解码完成
+    void onProjectLoaded(const QImage &background, const TiledCanvas &drawing,
+                         const QVector<Scene::Item> &shapes,
+                         const QVector<LayerStack::Layer> &projectLayers);  // 工程文件读取完成
+    void onLayerLoaded(const QImage &layerImage);  // 导入的图层解码完成
+    void onLoadFailed(const QString &message);  // 加载失败
 };
 
 #endif // PAINTAREA_H
@@ -0,0 +1,238 @@
+#include "profiler.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QStringList>
+#include <QThread>
+#include <QVector>
+#include <algorithm>
+#include <atomic>
+
+namespace {
+
+const int WindowSize = 512;  // 每个阶段参与滚动统计的最近次数
+const int TraceCapacity = 200000;  // 跟踪环形缓冲区的事件数
+const char *const EnvironmentVariable = "PAINTPROJECT_PROFILE";
+
+/**
+ * @brief 跟踪缓冲区中的一个完整事件
+ */
+struct TraceEvent {
+    qint64 start;  // 开始时间(纳秒)
+    qint64 duration;  // 耗时(纳秒)
+    int thread;  // 线程编号
+    Profiler::Stage stage;  // 阶段
+};
+
+/**
+ * @brief 统计数据，所有访问都在mutex保护下
+ */
+struct ProfilerState {
+    QMutex mutex;
+    QVector<qint64> windows[Profiler::StageCount];  // 每个阶段最近的耗时(环形)
+    int windowNext[Profiler::StageCount] = {};  // 每个阶段下一个写入位置
+    QVector<TraceEvent> trace;  // 跟踪事件(环形)
+    int traceNext = 0;  // 下一个写入位置
+    QHash<Qt::HANDLE, int> threads;  // 线程句柄到线程编号
+};
+
+std::atomic<bool> enabledFlag(false);
+
+ProfilerState &state()
+{
+    static ProfilerState instance;
+    return instance;
+}
+
+// 统计时钟，第一次使用时启动；启动后只读，多线程读取无需加锁
+const QElapsedTimer &clock()
+{
+    static const QElapsedTimer timer = [] {
+        QElapsedTimer t;
+        t.start();
+        return t;
+    }();
+    return timer;
+}
+
+} // namespace
+
+// 作用域计时开始
+Profiler::Scope::Scope(Stage stage)
+    : stage(stage), start(isEnabled() ? now() : -1) {}
+
+// 作用域计时结束
+Profiler::Scope::~Scope()
+{
+    if (start >= 0) {
+        record(stage, start, now() - start);
+    }
+}
+
+// 开启/关闭统计
+void Profiler::setEnabled(bool enabled)
+{
+    ProfilerState &s = state();
+    QMutexLocker locker(&s.mutex);
+    if (enabled && !enabledFlag.load()) {
+        for (int i = 0; i < StageCount; ++i) {
+            s.windows[i].clear();
+            s.windowNext[i] = 0;
+        }
+        s.trace.clear();
+        s.traceNext = 0;
+        s.threads.clear();
+    }
+    enabledFlag.store(enabled);
+}
+
+// 是否正在统计
+bool Profiler::isEnabled()
+{
+    return enabledFlag.load(std::memory_order_relaxed);
+}
+
+// 按环境变量开启
+void Profiler::enableFromEnvironment()
+{
+    if (!qEnvironmentVariableIsEmpty(EnvironmentVariable)) {
+        setEnabled(true);
+    }
+}
+
+// 环境变量指定的跟踪文件
+QString Profiler::environmentTraceFile()
+{
+    QString value = qEnvironmentVariable(EnvironmentVariable);
+    return value.endsWith(".json", Qt::CaseInsensitive) ? value : QString();
+}
+
+// 统计时钟的当前时间
+qint64 Profiler::now()
+{
+    return clock().nsecsElapsed();
+}
+
+// 记录一次计时
+void Profiler::record(Stage stage, qint64 start, qint64 duration)
+{
+    if (!isEnabled()) return;
+
+    ProfilerState &s = state();
+    QMutexLocker locker(&s.mutex);
+
+    QVector<qint64> &window = s.windows[stage];
+    if (window.size() < WindowSize) {
+        window.append(duration);
+    } else {
+        window[s.windowNext[stage]] = duration;
+    }
+    s.windowNext[stage] = (s.windowNext[stage] + 1) % WindowSize;
+
+    Qt::HANDLE handle = QThread::currentThreadId();
+    auto thread = s.threads.constFind(handle);
+    if (thread == s.threads.constEnd()) {
+        thread = s.threads.insert(handle, s.threads.size() + 1);
+    }
+
+    TraceEvent event = {start, duration, thread.value(), stage};
+    if (s.trace.size() < TraceCapacity) {
+        s.trace.append(event);
+    } else {
+        s.trace[s.traceNext] = event;
+    }
+    s.traceNext = (s.traceNext + 1) % TraceCapacity;
+}
+
+// 阶段的滚动统计
+Profiler::Stats Profiler::stats(Stage stage)
+{
+    QVector<qint64> window;
+    {
+        ProfilerState &s = state();
+        QMutexLocker locker(&s.mutex);
+        window = s.windows[stage];
+    }
+
+    Stats result;
+    result.count = window.size();
+    if (window.isEmpty()) return result;
+
+    int median = (window.size() - 1) * 50 / 100;
+    int tail = (window.size() - 1) * 99 / 100;
+    std::nth_element(window.begin(), window.begin() + median, window.end());
+    result.p50 = window[median];
+    std::nth_element(window.begin() + median, window.begin() + tail, window.end());
+    result.p99 = window[tail];
+    return result;
+}
+
+// 各阶段p50/p99的单行摘要，没有数据的阶段不显示
+QString Profiler::summary()
+{
+    QStringList parts;
+    for (int i = 0; i < StageCount; ++i) {
+        Stats s = stats(static_cast<Stage>(i));
+        if (s.count == 0) continue;
+        parts << QString("%1 %2/%3")
+                     .arg(QString(name(static_cast<Stage>(i))))
+                     .arg(s.p50 / 1e6, 0, 'f', 2)
+                     .arg(s.p99 / 1e6, 0, 'f', 2);
+    }
+    return parts.isEmpty() ? QString("p50/p99 ms: 暂无数据") : "p50/p99 ms: " + parts.join("  ");
+}
+
+// 阶段名称
+const char *Profiler::name(Stage stage)
+{
+    switch (stage) {
+    case EventHandling: return "事件";
+    case PreviewRaster: return "预览";
+    case Composite: return "合成";
+    case History: return "历史";
+    case SaveLoad: return "保存/加载";
+    case StageCount: break;
+    }
+    return "";
+}
+
+// 把缓冲区中的计时事件写为Chrome跟踪JSON(完整事件，时间单位为微秒)
+bool Profiler::writeTrace(const QString &fileName, QString *error)
+{
+    QVector<TraceEvent> events;
+    {
+        ProfilerState &s = state();
+        QMutexLocker locker(&s.mutex);
+        events = s.trace;
+    }
+    std::sort(events.begin(), events.end(), [](const TraceEvent &a, const TraceEvent &b) {
+        return a.start < b.start;
+    });
+
+    QJsonArray traceEvents;
+    for (const TraceEvent &event : std::as_const(events)) {
+        QJsonObject object;
+        object["name"] = QString(name(event.stage));
+        object["ph"] = "X";
+        object["ts"] = event.start / 1000.0;
+        object["dur"] = event.duration / 1000.0;
+        object["pid"] = 1;
+        object["tid"] = event.thread;
+        traceEvents.append(object);
+    }
+    QJsonObject root;
+    root["traceEvents"] = traceEvents;
+    root["displayTimeUnit"] = "ms";
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly) ||
+        file.write(QJsonDocument(root).toJson(QJsonDocument::Compact)) < 0) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,76 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <QString>
+#include <QtGlobal>
+
+/**
+ * @brief 绘图流水线各阶段的耗时统计
+ *
+ * 关闭时每个计时点只有一次原子读取。开启后每个阶段保留最近的若干次耗时，
+ * 用于计算滚动的p50/p99；同时把每次计时作为一个完整事件记入环形缓冲区，
+ * 可以导出为Chrome跟踪格式(chrome://tracing、Perfetto)离线分析。
+ * 保存和加载在工作线程中计时，所有接口都是线程安全的。
+ *
+ * 环境变量PAINTPROJECT_PROFILE非空时启动即开启；其值以.json结尾时，
+ * 程序退出时把跟踪写入该文件。
+ */
+class Profiler {
+public:
+    /**
+     * @brief 计时的阶段
+     */
+    enum Stage {
+        EventHandling,  // 0:鼠标事件处理
+        PreviewRaster,  // 1:预览图层光栅化
+        Composite,      // 2:paintEvent中的图层合成
+        History,        // 3:历史记录提交/撤销/重做
+        SaveLoad,       // 4:后台保存和加载
+        StageCount
+    };
+
+    /**
+     * @brief 作用域计时：构造时开始，析构时把耗时记入对应阶段
+     */
+    class Scope {
+    public:
+        explicit Scope(Stage stage);
+        ~Scope();
+
+    private:
+        Q_DISABLE_COPY(Scope)
+
+        Stage stage;  // 计时的阶段
+        qint64 start;  // 开始时间(纳秒)，未开启时为-1
+    };
+
+    /**
+     * @brief 一个阶段最近若干次的耗时统计
+     */
+    struct Stats {
+        int count = 0;  // 参与统计的次数
+        qint64 p50 = 0;  // 中位数(纳秒)
+        qint64 p99 = 0;  // 99分位数(纳秒)
+    };
+
+    static void setEnabled(bool enabled);  // 开启/关闭统计(开启时清空旧数据)
+    static bool isEnabled();  // 是否正在统计
+    static void enableFromEnvironment();  // 按PAINTPROJECT_PROFILE环境变量开启
+    static QString environmentTraceFile();  // 环境变量指定的跟踪文件(未指定时为空)
+
+    static qint64 now();  // 统计时钟的当前时间(纳秒)
+    static void record(Stage stage, qint64 start, qint64 duration);  // 记录一次计时
+    static Stats stats(Stage stage);  // 阶段的滚动统计
+    static QString summary();  // 各阶段p50/p99的单行摘要(毫秒)
+    static const char *name(Stage stage);  // 阶段名称
+
+    /**
+     * @brief 把缓冲区中的计时事件写为Chrome跟踪JSON
+     * @param fileName 文件名
+     * @param error 失败时的错误信息
+     * @return 是否成功
+     */
+    static bool writeTrace(const QString &fileName, QString *error = nullptr);
+};
+
+#endif // PROFILER_H
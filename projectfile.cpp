@@ -0,0 +1,430 @@
+#include "projectfile.h"
+#include "paintarea.h"
+#include "shapefactory.h"
+#include <QDataStream>
+#include <QFileInfo>
+#include <QPainter>
+#include <QSaveFile>
+#include <cstring>
+
+namespace {
+
+const char Magic[4] = {'P', 'P', 'R', 'J'};  // 文件头标识
+const quint32 Version = 2;  // 文件格式版本(版本2增加了图层列表)
+const int HeaderSize = 128;  // 文件头占用的字节数(其余部分填0)
+const int PreviewBound = 1024;  // 预览图的最大边长
+const quint64 Alignment = 64;  // 区块对齐字节数
+const quint64 TileBytes = quint64(TiledCanvas::TileSize) * TiledCanvas::TileSize * 4;  // 一个图块的字节数
+const qint64 ChunkBytes = 4 << 20;  // 写入背景时每次写入的字节数(用于报告进度和取消)
+
+// 向上对齐到区块边界
+quint64 align(quint64 offset)
+{
+    return (offset + Alignment - 1) / Alignment * Alignment;
+}
+
+// 用0填充到指定偏移
+bool padTo(QIODevice &device, quint64 offset)
+{
+    qint64 padding = qint64(offset) - device.pos();
+    return padding <= 0 || device.write(QByteArray(padding, '\0')) == padding;
+}
+
+// 转为预乘ARGB32，与绘制使用的格式一致
+QImage premultiplied(const QImage &image)
+{
+    return image.format() == QImage::Format_ARGB32_Premultiplied ?
+               image : image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+}
+
+// 按最大边长缩小合成预览：背景和各图层已分配的图块直接缩放绘制
+QImage renderPreview(const QImage &background, const TiledCanvas &drawing,
+                     const QVector<LayerStack::Layer> &layers)
+{
+    QSize previewSize = drawing.size();
+    if (previewSize.width() > PreviewBound || previewSize.height() > PreviewBound) {
+        previewSize.scale(PreviewBound, PreviewBound, Qt::KeepAspectRatio);
+    }
+    QImage preview(previewSize.expandedTo(QSize(1, 1)), QImage::Format_ARGB32_Premultiplied);
+    preview.fill(Qt::transparent);
+
+    QPainter painter(&preview);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.scale(double(preview.width()) / drawing.width(), double(preview.height()) / drawing.height());
+    if (!background.isNull()) {
+        painter.drawImage(0, 0, background);
+    }
+    if (layers.isEmpty()) {
+        LayerStack::drawCanvas(painter, drawing, drawing.rect(), 1.0, QPainter::CompositionMode_SourceOver);
+    }
+    for (const LayerStack::Layer &layer : layers) {
+        if (!layer.visible) continue;
+        LayerStack::drawCanvas(painter, layer.document ? drawing : layer.canvas, drawing.rect(),
+                               layer.opacity, layer.mode);
+    }
+    return preview;
+}
+
+} // namespace
+
+const char *ProjectFile::Suffix = "ppd";
+
+// 按扩展名判断是否为工程文件
+bool ProjectFile::isProjectFile(const QString &fileName)
+{
+    return QFileInfo(fileName).suffix().compare(Suffix, Qt::CaseInsensitive) == 0;
+}
+
+// 序列化文档中的形状：数量，然后每个形状的id、类型和形状自身写入的字节
+// 形状数据单独成块，读取时遇到未知类型可以整块跳过
+QByteArray ProjectFile::encodeShapes(const QVector<Scene::Item> &items)
+{
+    quint32 count = 0;
+    for (const Scene::Item &item : items) {
+        if (item.second->type() >= 0) ++count;
+    }
+
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << count;
+    for (const Scene::Item &item : items) {
+        if (item.second->type() < 0) continue;
+
+        QByteArray shapeData;
+        QDataStream shapeOut(&shapeData, QIODevice::WriteOnly);
+        shapeOut.setVersion(QDataStream::Qt_6_0);
+        item.second->write(shapeOut);
+        out << qint32(item.first) << qint32(item.second->type()) << shapeData;
+    }
+    return data;
+}
+
+// 按类型从形状工厂重新创建形状并读取内容
+bool ProjectFile::decodeShapes(const QByteArray &data, QVector<Scene::Item> &items)
+{
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 count = 0;
+    in >> count;
+
+    for (quint32 i = 0; i < count; ++i) {
+        qint32 id = 0;
+        qint32 type = 0;
+        QByteArray shapeData;
+        in >> id >> type >> shapeData;
+        if (in.status() != QDataStream::Ok) return false;
+
+        ShapeHandle shape = PaintArea::createShape(static_cast<PaintArea::DrawShape>(type),
+                                                   QPoint(), QColor(), 0);
+        if (!shape) continue;  // 未知类型
+
+        QDataStream shapeIn(shapeData);
+        shapeIn.setVersion(QDataStream::Qt_6_0);
+        if (!shape->read(shapeIn)) return false;
+        items.append(Scene::Item(id, ShapeFactory::share(std::move(shape))));
+    }
+    return true;
+}
+
+// 序列化图层：数量，然后每个图层的属性；栅格图层再写入已分配图块的下标和原始像素
+QByteArray ProjectFile::encodeLayers(const QVector<LayerStack::Layer> &layers)
+{
+    QByteArray data;
+    if (layers.size() <= 1) {
+        bool trivial = layers.isEmpty() ||
+                       (layers[0].visible && layers[0].opacity >= 1.0 &&
+                        layers[0].mode == QPainter::CompositionMode_SourceOver);
+        if (trivial) return data;  // 只有默认的绘制层，与版本1的文件相同
+    }
+
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << quint32(layers.size());
+    for (const LayerStack::Layer &layer : layers) {
+        out << layer.name << layer.document << layer.visible << double(layer.opacity) << qint32(layer.mode);
+        if (layer.document) continue;
+
+        const TiledCanvas &canvas = layer.canvas;
+        out << quint32(canvas.allocatedTiles());
+        for (int index = 0; index < canvas.tileCount(); ++index) {
+            if (!canvas.hasTile(index)) continue;
+            QImage tile = premultiplied(canvas.tile(index));
+            out << qint32(index);
+            out.writeRawData(reinterpret_cast<const char *>(tile.constBits()), TileBytes);
+        }
+    }
+    return data;
+}
+
+// 读出图层，图块按原格式复制
+bool ProjectFile::decodeLayers(const QByteArray &data, const QSize &size,
+                               QVector<LayerStack::Layer> &layers)
+{
+    if (data.isEmpty()) return true;
+
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 count = 0;
+    in >> count;
+    int documents = 0;
+    for (quint32 i = 0; i < count; ++i) {
+        LayerStack::Layer layer;
+        double opacity = 1.0;
+        qint32 mode = 0;
+        in >> layer.name >> layer.document >> layer.visible >> opacity >> mode;
+        if (in.status() != QDataStream::Ok) return false;
+        layer.opacity = opacity;
+        layer.mode = static_cast<QPainter::CompositionMode>(mode);
+
+        if (layer.document) {
+            ++documents;
+        } else {
+            quint32 tiles = 0;
+            in >> tiles;
+            layer.canvas = TiledCanvas(size);
+            for (quint32 t = 0; t < tiles; ++t) {
+                qint32 index = -1;
+                in >> index;
+                QImage tile = TiledCanvas::createTile();
+                if (index < 0 || index >= layer.canvas.tileCount() ||
+                    in.readRawData(reinterpret_cast<char *>(tile.bits()), TileBytes) != qint64(TileBytes)) {
+                    return false;
+                }
+                layer.canvas.setTile(index, tile);
+            }
+            layer.canvas.clearDirty();
+        }
+        layers.append(layer);
+    }
+    return in.status() == QDataStream::Ok && documents == 1;
+}
+
+// 写入工程文件：先确定各区块的偏移，再按顺序写入
+QString ProjectFile::write(const QString &fileName, const QImage &background,
+                           const TiledCanvas &drawing, const QByteArray &shapes,
+                           const QVector<LayerStack::Layer> &layers, const Progress &progress)
+{
+    if (drawing.isNull()) return QString("画布为空");
+    if (!background.isNull() && background.size() != drawing.size()) {
+        return QString("背景与绘制层尺寸不一致");
+    }
+
+    QImage backgroundImage = premultiplied(background);
+    QImage preview = renderPreview(backgroundImage, drawing, layers);
+    QByteArray layerData = encodeLayers(layers);
+
+    QVector<int> allocated;
+    for (int index = 0; index < drawing.tileCount(); ++index) {
+        if (drawing.hasTile(index)) allocated.append(index);
+    }
+
+    // 1. 区块布局
+    quint64 previewOffset = HeaderSize;
+    quint64 backgroundOffset = align(previewOffset + preview.sizeInBytes());
+    quint64 backgroundBytes = backgroundImage.isNull() ? 0 : backgroundImage.sizeInBytes();
+    quint64 indexOffset = align(backgroundOffset + backgroundBytes);
+    quint64 tilesOffset = align(indexOffset + quint64(drawing.tileCount()) * sizeof(quint64));
+    quint64 shapesOffset = tilesOffset + quint64(allocated.size()) * TileBytes;
+    quint64 layersOffset = shapesOffset + quint64(shapes.size());
+
+    QByteArray header;
+    QDataStream headerOut(&header, QIODevice::WriteOnly);
+    headerOut.setByteOrder(QDataStream::LittleEndian);
+    headerOut.writeRawData(Magic, sizeof(Magic));
+    headerOut << Version
+              << qint32(drawing.width()) << qint32(drawing.height()) << qint32(TiledCanvas::TileSize)
+              << qint32(preview.width()) << qint32(preview.height())
+              << quint32(backgroundImage.isNull() ? 0 : 1)
+              << previewOffset << (backgroundImage.isNull() ? quint64(0) : backgroundOffset)
+              << indexOffset << shapesOffset << quint64(shapes.size())
+              << layersOffset << quint64(layerData.size());
+
+    QByteArray tileIndex;
+    QDataStream indexOut(&tileIndex, QIODevice::WriteOnly);
+    indexOut.setByteOrder(QDataStream::LittleEndian);
+    quint64 nextTile = tilesOffset;
+    for (int index = 0; index < drawing.tileCount(); ++index) {
+        indexOut << (drawing.hasTile(index) ? nextTile : quint64(0));
+        if (drawing.hasTile(index)) nextTile += TileBytes;
+    }
+
+    // 2. 按顺序写入，背景分块写入以便报告进度和取消
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return QString("无法写入文件: %1").arg(file.errorString());
+    }
+
+    qint64 rowBytes = backgroundImage.bytesPerLine();
+    int chunkRows = backgroundImage.isNull() ? 1 : qMax<qint64>(1, ChunkBytes / rowBytes);
+    int chunks = backgroundImage.isNull() ? 0 : (backgroundImage.height() + chunkRows - 1) / chunkRows;
+    int total = chunks + allocated.size();
+    int done = 0;
+    auto fail = [&file](const QString &message) {
+        file.cancelWriting();
+        return message.isEmpty() ? QString("写入失败: %1").arg(file.errorString()) : message;
+    };
+
+    bool ok = file.write(header) == header.size() && padTo(file, previewOffset) &&
+              file.write(reinterpret_cast<const char *>(preview.constBits()), preview.sizeInBytes()) ==
+                  preview.sizeInBytes();
+    if (!ok) return fail(QString());
+
+    if (!backgroundImage.isNull()) {
+        if (!padTo(file, backgroundOffset)) return fail(QString());
+        for (int row = 0; row < backgroundImage.height(); row += chunkRows) {
+            qint64 bytes = qMin(chunkRows, backgroundImage.height() - row) * rowBytes;
+            const char *data = reinterpret_cast<const char *>(backgroundImage.constScanLine(row));
+            if (file.write(data, bytes) != bytes) return fail(QString());
+            if (progress && !progress(++done, total)) return fail("保存已取消");
+        }
+    }
+
+    if (!padTo(file, indexOffset) || file.write(tileIndex) != tileIndex.size() ||
+        !padTo(file, tilesOffset)) {
+        return fail(QString());
+    }
+    for (int index : allocated) {
+        QImage tile = premultiplied(drawing.tile(index));
+        if (file.write(reinterpret_cast<const char *>(tile.constBits()), TileBytes) != qint64(TileBytes)) {
+            return fail(QString());
+        }
+        if (progress && !progress(++done, total)) return fail("保存已取消");
+    }
+
+    if (file.write(shapes) != shapes.size() || file.write(layerData) != layerData.size()) {
+        return fail(QString());
+    }
+    if (!file.commit()) {
+        return QString("无法写入文件: %1").arg(file.errorString());
+    }
+    return QString();
+}
+
+// 构造函数
+ProjectFile::ProjectFile()
+    : mapped(nullptr), hasBackground(false), previewOffset(0), backgroundOffset(0),
+      shapesOffset(0), shapesSize(0), layersOffset(0), layersSize(0) {}
+
+// 打开并映射工程文件，读取文件头和图块索引
+bool ProjectFile::open(const QString &fileName)
+{
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = QString("无法打开工程文件: %1").arg(file.errorString());
+        return false;
+    }
+
+    quint64 fileSize = file.size();
+    mapped = fileSize >= quint64(HeaderSize) ? file.map(0, fileSize) : nullptr;
+    if (!mapped) {
+        error = fileSize < quint64(HeaderSize) ? QString("工程文件已损坏") :
+                                                 QString("无法映射工程文件: %1").arg(file.errorString());
+        return false;
+    }
+
+    // 1. 文件头
+    QDataStream in(QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), HeaderSize));
+    in.setByteOrder(QDataStream::LittleEndian);
+    char magic[sizeof(Magic)];
+    quint32 version = 0;
+    qint32 width = 0, height = 0, tileSize = 0, previewWidth = 0, previewHeight = 0;
+    quint32 flags = 0;
+    quint64 indexOffset = 0;
+    in.readRawData(magic, sizeof(magic));
+    in >> version >> width >> height >> tileSize >> previewWidth >> previewHeight >> flags
+       >> previewOffset >> backgroundOffset >> indexOffset >> shapesOffset >> shapesSize;
+    if (version >= 2) {
+        in >> layersOffset >> layersSize;
+    }
+
+    if (std::memcmp(magic, Magic, sizeof(Magic)) != 0) {
+        error = "不是工程文件";
+        return false;
+    }
+    if (version < 1 || version > Version || tileSize != TiledCanvas::TileSize) {
+        error = QString("不支持的工程文件版本: %1").arg(version);
+        return false;
+    }
+
+    canvasSize = QSize(width, height);
+    previewSize = QSize(previewWidth, previewHeight);
+    hasBackground = flags & 1;
+
+    // 2. 所有区块都必须在文件范围内，之后读取时无需再检查
+    auto within = [fileSize](quint64 offset, quint64 bytes) {
+        return offset <= fileSize && bytes <= fileSize - offset;
+    };
+    int columns = (width + TiledCanvas::TileSize - 1) / TiledCanvas::TileSize;
+    int rows = (height + TiledCanvas::TileSize - 1) / TiledCanvas::TileSize;
+    quint64 tileCount = quint64(columns) * rows;
+    bool valid = width > 0 && height > 0 && previewWidth > 0 && previewHeight > 0 &&
+                 within(previewOffset, quint64(previewWidth) * previewHeight * 4) &&
+                 (!hasBackground || within(backgroundOffset, quint64(width) * height * 4)) &&
+                 within(indexOffset, tileCount * sizeof(quint64)) &&
+                 within(shapesOffset, shapesSize) && within(layersOffset, layersSize);
+    if (!valid) {
+        error = "工程文件已损坏";
+        return false;
+    }
+
+    // 3. 图块索引
+    QDataStream indexIn(QByteArray::fromRawData(reinterpret_cast<const char *>(mapped + indexOffset),
+                                                tileCount * sizeof(quint64)));
+    indexIn.setByteOrder(QDataStream::LittleEndian);
+    tileOffsets.resize(tileCount);
+    for (quint64 &offset : tileOffsets) {
+        indexIn >> offset;
+        if (offset != 0 && (offset % 4 != 0 || !within(offset, TileBytes))) {
+            error = "工程文件已损坏";
+            return false;
+        }
+    }
+    return true;
+}
+
+// 复制映射区域中的图像：只按行复制像素，不解码
+QImage ProjectFile::mappedImage(quint64 offset, const QSize &size) const
+{
+    QImage view(mapped + offset, size.width(), size.height(), size.width() * 4,
+                QImage::Format_ARGB32_Premultiplied);
+    return view.copy();
+}
+
+// 合成预览图
+QImage ProjectFile::preview() const
+{
+    return mappedImage(previewOffset, previewSize);
+}
+
+// 背景
+QImage ProjectFile::background() const
+{
+    return hasBackground ? mappedImage(backgroundOffset, canvasSize) : QImage();
+}
+
+// 绘制层：只复制已分配的图块
+TiledCanvas ProjectFile::drawing() const
+{
+    TiledCanvas canvas(canvasSize);
+    QSize tileSize(TiledCanvas::TileSize, TiledCanvas::TileSize);
+    for (int index = 0; index < tileOffsets.size(); ++index) {
+        if (tileOffsets[index] != 0) {
+            canvas.setTile(index, mappedImage(tileOffsets[index], tileSize));
+        }
+    }
+    canvas.clearDirty();  // 读出的内容不算修改
+    return canvas;
+}
+
+// 序列化的形状列表
+QByteArray ProjectFile::shapes() const
+{
+    return QByteArray(reinterpret_cast<const char *>(mapped + shapesOffset), shapesSize);
+}
+
+// 序列化的图层列表
+QByteArray ProjectFile::layers() const
+{
+    return QByteArray(reinterpret_cast<const char *>(mapped + layersOffset), layersSize);
+}
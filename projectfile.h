@@ -0,0 +1,122 @@
+#ifndef PROJECTFILE_H
+#define PROJECTFILE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QImage>
+#include <QSize>
+#include <QString>
+#include <QVector>
+#include <functional>
+#include "layerstack.h"
+#include "scene.h"
+#include "tiledcanvas.h"
+
+/**
+ * @brief 工程文件(.ppd)：保存背景、绘制层和文档中的所有形状，重新打开后可以继续编辑和撤销
+ *
+ * 像素不经过编码，按绘制使用的预乘ARGB32格式(小端机器的内存布局)原样存放，
+ * 读取时把文件映射到内存后直接复制，耗时只取决于磁盘读取而不是解码。文件依次包含：
+ * - 文件头：尺寸、各区块的偏移；
+ * - 缩小的合成预览图，打开时先显示它；
+ * - 背景，按行连续存放(没有背景时省略)；
+ * - 图块索引和绘制层图块，只存放已分配的图块，索引中偏移为0表示透明图块；
+ * - 形状列表：每个形状的id、类型和Shape::write()写入的内容；
+ * - 图层列表(版本2)：每个图层的属性和已分配的图块，绘制层只记录位置和属性。
+ * 每个区块按64字节对齐。
+ */
+class ProjectFile {
+public:
+    static const char *Suffix;  // 工程文件扩展名
+
+    /**
+     * @brief 保存进度回调
+     * @return 返回false时取消保存
+     */
+    typedef std::function<bool(int done, int total)> Progress;
+
+    static bool isProjectFile(const QString &fileName);  // 按扩展名判断是否为工程文件
+
+    /**
+     * @brief 序列化文档中的形状
+     *
+     * 形状在GUI线程中可能被移动，保存前先在GUI线程序列化，后台只写入得到的字节。
+     * 不是由形状工厂按类型创建的形状没有类型，无法重新创建，会被跳过。
+     */
+    static QByteArray encodeShapes(const QVector<Scene::Item> &items);
+
+    /**
+     * @brief 按类型重新创建形状
+     * @param data encodeShapes()的结果
+     * @param items 读出的形状(按绘制顺序)
+     * @return 数据损坏时返回false；未知类型的形状被跳过
+     */
+    static bool decodeShapes(const QByteArray &data, QVector<Scene::Item> &items);
+
+    /**
+     * @brief 序列化图层：属性和已分配图块的原始像素，不编码
+     * @param layers 图层栈中的所有图层；只有默认属性的绘制层时结果为空
+     */
+    static QByteArray encodeLayers(const QVector<LayerStack::Layer> &layers);
+
+    /**
+     * @brief 读出图层
+     * @param data encodeLayers()的结果(为空时没有图层)
+     * @param size 画布尺寸
+     * @param layers 读出的图层(从下到上)
+     * @return 数据损坏时返回false
+     */
+    static bool decodeLayers(const QByteArray &data, const QSize &size,
+                             QVector<LayerStack::Layer> &layers);
+
+    /**
+     * @brief 写入工程文件，先写入临时文件，成功后才替换目标文件
+     * @param fileName 目标文件名
+     * @param background 背景平面(可以为空)
+     * @param drawing 绘制平面
+     * @param shapes encodeShapes()的结果
+     * @param layers 图层栈中的所有图层(预览按图层合成)
+     * @param progress 可选的进度回调
+     * @return 错误信息，成功时为空
+     */
+    static QString write(const QString &fileName, const QImage &background,
+                         const TiledCanvas &drawing, const QByteArray &shapes,
+                         const QVector<LayerStack::Layer> &layers = QVector<LayerStack::Layer>(),
+                         const Progress &progress = Progress());
+
+    ProjectFile();
+
+    /**
+     * @brief 打开并映射工程文件，校验文件头和所有区块都在文件范围内
+     * @return 失败时返回false，原因见errorString()
+     */
+    bool open(const QString &fileName);
+    QString errorString() const { return error; }  // 最近一次失败的原因
+
+    QSize size() const { return canvasSize; }  // 画布尺寸
+    QImage preview() const;  // 合成预览图
+    QImage background() const;  // 背景(没有背景时为空图像)
+    TiledCanvas drawing() const;  // 绘制层
+    QByteArray shapes() const;  // 序列化的形状列表
+    QByteArray layers() const;  // 序列化的图层列表(版本1的文件为空)
+
+private:
+    QImage mappedImage(quint64 offset, const QSize &size) const;  // 复制映射区域中的图像
+
+    QFile file;  // 工程文件
+    const uchar *mapped;  // 整个文件的内存映射
+    QString error;  // 错误信息
+
+    QSize canvasSize;  // 画布尺寸
+    QSize previewSize;  // 预览图尺寸
+    bool hasBackground;  // 是否有背景
+    quint64 previewOffset;  // 预览图偏移
+    quint64 backgroundOffset;  // 背景偏移
+    QVector<quint64> tileOffsets;  // 每个图块的偏移(0为透明图块)
+    quint64 shapesOffset;  // 形状列表偏移
+    quint64 shapesSize;  // 形状列表字节数
+    quint64 layersOffset;  // 图层列表偏移
+    quint64 layersSize;  // 图层列表字节数
+};
+
+#endif // PROJECTFILE_H
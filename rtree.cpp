@@ -0,0 +1,273 @@
+#include "rtree.h"
+
+// 构造函数，创建一个空的叶子根节点
+RTree::RTree()
+    : root(new Node), height(1), count(0) {}
+
+// 析构函数，释放所有节点
+RTree::~RTree()
+{
+    destroy(root, height - 1);
+}
+
+// 插入一项
+void RTree::insert(int id, const QRect &rect)
+{
+    insertEntry(Entry{rect, id, nullptr}, 0);
+    ++count;
+}
+
+// 删除一项，rect用于沿包含它的子树查找
+bool RTree::remove(int id, const QRect &rect)
+{
+    QVector<Orphan> orphans;
+    if (!removeAt(root, height - 1, id, rect, orphans)) {
+        return false;
+    }
+    --count;
+
+    // 把因节点过少而被拆除的项重新插入到原来的层级
+    for (const Orphan &orphan : orphans) {
+        insertEntry(orphan.entry, orphan.level);
+    }
+
+    // 根节点只剩一个子节点时降低树高
+    while (height > 1 && root->entries.size() == 1) {
+        Node *oldRoot = root;
+        root = root->entries.first().child;
+        delete oldRoot;
+        --height;
+    }
+    if (height > 1 && root->entries.isEmpty()) {
+        height = 1;
+    }
+    return true;
+}
+
+// 清空索引
+void RTree::clear()
+{
+    destroy(root, height - 1);
+    root = new Node;
+    height = 1;
+    count = 0;
+}
+
+// 查询与矩形相交的所有项
+void RTree::query(const QRect &rect, QVector<int> &result) const
+{
+    if (count == 0 || rect.isEmpty()) return;
+    queryAt(root, height - 1, rect, result);
+}
+
+// 查询包含某点的所有项
+void RTree::query(const QPoint &point, QVector<int> &result) const
+{
+    query(QRect(point, QSize(1, 1)), result);
+}
+
+// 在指定层级插入一项，根节点分裂时树增高一层
+void RTree::insertEntry(const Entry &entry, int targetLevel)
+{
+    Node *split = insertAt(root, height - 1, entry, targetLevel);
+    if (split) {
+        Node *newRoot = new Node;
+        newRoot->entries.append(Entry{nodeBounds(root), -1, root});
+        newRoot->entries.append(Entry{nodeBounds(split), -1, split});
+        root = newRoot;
+        ++height;
+    }
+}
+
+// 递归插入：到达目标层级后直接加入，否则沿扩张最小的子树向下
+RTree::Node *RTree::insertAt(Node *node, int level, const Entry &entry, int targetLevel)
+{
+    if (level == targetLevel) {
+        node->entries.append(entry);
+    } else {
+        int best = chooseSubtree(node, entry.rect);
+        Node *child = node->entries[best].child;
+        Node *split = insertAt(child, level - 1, entry, targetLevel);
+        node->entries[best].rect = nodeBounds(child);
+        if (split) {
+            node->entries.append(Entry{nodeBounds(split), -1, split});
+        }
+    }
+
+    return node->entries.size() > MaxEntries ? splitNode(node) : nullptr;
+}
+
+// 递归删除，过少的节点被拆除，其中的项记录到orphans中稍后重新插入
+bool RTree::removeAt(Node *node, int level, int id, const QRect &rect, QVector<Orphan> &orphans)
+{
+    if (level == 0) {
+        for (int i = 0; i < node->entries.size(); ++i) {
+            if (node->entries[i].id == id) {
+                node->entries.removeAt(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    for (int i = 0; i < node->entries.size(); ++i) {
+        if (!node->entries[i].rect.contains(rect)) continue;
+
+        Node *child = node->entries[i].child;
+        if (!removeAt(child, level - 1, id, rect, orphans)) continue;
+
+        if (child->entries.size() < MinEntries) {
+            // 子节点项数不足，拆除并记录其中的项
+            for (const Entry &entry : child->entries) {
+                orphans.append(Orphan{entry, level - 1});
+            }
+            delete child;
+            node->entries.removeAt(i);
+        } else {
+            node->entries[i].rect = nodeBounds(child);
+        }
+        return true;
+    }
+    return false;
+}
+
+// 递归查询
+void RTree::queryAt(const Node *node, int level, const QRect &rect, QVector<int> &result) const
+{
+    for (const Entry &entry : node->entries) {
+        if (!entry.rect.intersects(rect)) continue;
+
+        if (level == 0) {
+            result.append(entry.id);
+        } else {
+            queryAt(entry.child, level - 1, rect, result);
+        }
+    }
+}
+
+// 选择插入后面积扩张最小的子树，扩张相同时选面积较小的
+int RTree::chooseSubtree(const Node *node, const QRect &rect) const
+{
+    int best = 0;
+    qint64 bestGrowth = -1;
+    qint64 bestArea = 0;
+    for (int i = 0; i < node->entries.size(); ++i) {
+        const QRect &r = node->entries[i].rect;
+        qint64 a = area(r);
+        qint64 growth = area(r.united(rect)) - a;
+        if (bestGrowth < 0 || growth < bestGrowth || (growth == bestGrowth && a < bestArea)) {
+            best = i;
+            bestGrowth = growth;
+            bestArea = a;
+        }
+    }
+    return best;
+}
+
+// 二次分裂：选出放在一起最浪费的两项作为种子，其余项依次分给扩张较小的一组
+RTree::Node *RTree::splitNode(Node *node)
+{
+    QVector<Entry> entries = node->entries;
+    node->entries.clear();
+    Node *sibling = new Node;
+
+    // 选择种子
+    int seedA = 0;
+    int seedB = 1;
+    qint64 worst = -1;
+    for (int i = 0; i < entries.size(); ++i) {
+        for (int j = i + 1; j < entries.size(); ++j) {
+            qint64 waste = area(entries[i].rect.united(entries[j].rect))
+                           - area(entries[i].rect) - area(entries[j].rect);
+            if (waste > worst) {
+                worst = waste;
+                seedA = i;
+                seedB = j;
+            }
+        }
+    }
+
+    node->entries.append(entries[seedA]);
+    sibling->entries.append(entries[seedB]);
+    QRect boundsA = entries[seedA].rect;
+    QRect boundsB = entries[seedB].rect;
+    entries.removeAt(seedB);  // seedB > seedA，先删除后面的
+    entries.removeAt(seedA);
+
+    while (!entries.isEmpty()) {
+        // 某一组必须拿走剩余全部项才能达到最少项数
+        if (node->entries.size() + entries.size() == MinEntries) {
+            node->entries.append(entries);
+            break;
+        }
+        if (sibling->entries.size() + entries.size() == MinEntries) {
+            sibling->entries.append(entries);
+            break;
+        }
+
+        // 选择对两组偏好差别最大的项
+        int next = 0;
+        qint64 maxDiff = -1;
+        qint64 growthA = 0;
+        qint64 growthB = 0;
+        for (int i = 0; i < entries.size(); ++i) {
+            qint64 a = area(boundsA.united(entries[i].rect)) - area(boundsA);
+            qint64 b = area(boundsB.united(entries[i].rect)) - area(boundsB);
+            qint64 diff = qAbs(a - b);
+            if (diff > maxDiff) {
+                maxDiff = diff;
+                next = i;
+                growthA = a;
+                growthB = b;
+            }
+        }
+
+        // 分给扩张较小的一组，相同时分给面积较小、项数较少的一组
+        bool toA;
+        if (growthA != growthB) {
+            toA = growthA < growthB;
+        } else if (area(boundsA) != area(boundsB)) {
+            toA = area(boundsA) < area(boundsB);
+        } else {
+            toA = node->entries.size() <= sibling->entries.size();
+        }
+
+        if (toA) {
+            node->entries.append(entries[next]);
+            boundsA = boundsA.united(entries[next].rect);
+        } else {
+            sibling->entries.append(entries[next]);
+            boundsB = boundsB.united(entries[next].rect);
+        }
+        entries.removeAt(next);
+    }
+
+    return sibling;
+}
+
+// 递归释放节点
+void RTree::destroy(Node *node, int level)
+{
+    if (level > 0) {
+        for (const Entry &entry : node->entries) {
+            destroy(entry.child, level - 1);
+        }
+    }
+    delete node;
+}
+
+// 节点中所有项的包围矩形
+QRect RTree::nodeBounds(const Node *node)
+{
+    QRect bounds;
+    for (const Entry &entry : node->entries) {
+        bounds = bounds.united(entry.rect);
+    }
+    return bounds;
+}
+
+// 矩形面积
+qint64 RTree::area(const QRect &rect)
+{
+    return static_cast<qint64>(rect.width()) * rect.height();
+}
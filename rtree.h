@@ -0,0 +1,88 @@
+#ifndef RTREE_H
+#define RTREE_H
+
+#include <QRect>
+#include <QPoint>
+#include <QVector>
+
+/**
+ * @brief 以整数id为值、以矩形为键的R树空间索引
+ *
+ * 采用Guttman的二次分裂算法，插入、删除和矩形查询的开销均约为O(log n)，
+ * 用于在大量形状中快速查找与某个区域相交的形状。
+ */
+class RTree {
+public:
+    RTree();
+    ~RTree();
+
+    void insert(int id, const QRect &rect);  // 插入一项
+    bool remove(int id, const QRect &rect);  // 删除一项(rect必须与插入时相同)
+    void clear();  // 清空索引
+
+    /**
+     * @brief 查询与指定矩形相交的所有项
+     * @param rect 查询矩形
+     * @param result 追加查询结果(不保证顺序)
+     */
+    void query(const QRect &rect, QVector<int> &result) const;
+
+    /**
+     * @brief 查询包含指定点的所有项
+     * @param point 查询点
+     * @param result 追加查询结果(不保证顺序)
+     */
+    void query(const QPoint &point, QVector<int> &result) const;
+
+    int size() const { return count; }  // 索引中的项数
+    bool isEmpty() const { return count == 0; }  // 索引是否为空
+
+private:
+    Q_DISABLE_COPY(RTree)
+
+    struct Node;
+
+    /**
+     * @brief 节点中的一项：叶子节点中保存id，内部节点中保存子节点
+     */
+    struct Entry {
+        QRect rect;   // 包围矩形
+        int id;       // 叶子项的id
+        Node *child;  // 内部项的子节点
+    };
+
+    /**
+     * @brief 树节点
+     */
+    struct Node {
+        QVector<Entry> entries;  // 节点中的项
+    };
+
+    /**
+     * @brief 删除时需要重新插入的项
+     */
+    struct Orphan {
+        Entry entry;  // 被移出的项
+        int level;    // 该项原来所在节点的层级(叶子为0)
+    };
+
+    static const int MaxEntries = 16;  // 每个节点最多的项数
+    static const int MinEntries = 6;   // 每个节点最少的项数(根节点除外)
+
+    Node *insertAt(Node *node, int level, const Entry &entry, int targetLevel);  // 递归插入，节点分裂时返回新节点
+    void insertEntry(const Entry &entry, int targetLevel);  // 在指定层级插入一项
+    bool removeAt(Node *node, int level, int id, const QRect &rect, QVector<Orphan> &orphans);  // 递归删除
+    void queryAt(const Node *node, int level, const QRect &rect, QVector<int> &result) const;  // 递归查询
+    int chooseSubtree(const Node *node, const QRect &rect) const;  // 选择扩张最小的子树
+    Node *splitNode(Node *node);  // 二次分裂
+    void destroy(Node *node, int level);  // 递归释放节点
+
+    static QRect nodeBounds(const Node *node);  // 节点中所有项的包围矩形
+    static qint64 area(const QRect &rect);  // 矩形面积
+
+    Node *root;  // 根节点
+    int height;  // 树的层数(只有根节点时为1)
+    int count;   // 项数
+};
+
+#endif // RTREE_H
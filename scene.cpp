@@ -0,0 +1,139 @@
+#include "scene.h"
+#include <algorithm>
+#include <functional>
+
+// 构造函数
+Scene::Scene()
+    : lastId(-1) {}
+
+// 分配一个新的形状id
+int Scene::allocateId()
+{
+    return ++lastId;
+}
+
+// 以指定id加入形状
+void Scene::insert(int id, const QSharedPointer<Shape> &shape)
+{
+    QRect rect = indexRect(*shape);
+    shapes.insert(id, shape);
+    rects.insert(id, rect);
+    index.insert(id, rect);
+    lastId = qMax(lastId, id);
+}
+
+// 移除并返回形状
+QSharedPointer<Shape> Scene::take(int id)
+{
+    if (!shapes.contains(id)) return QSharedPointer<Shape>();
+
+    index.remove(id, rects.take(id));
+    return shapes.take(id);
+}
+
+// 移除并返回所有形状(按绘制顺序)
+QVector<Scene::Item> Scene::takeAll()
+{
+    QVector<Item> all = items();
+    shapes.clear();
+    rects.clear();
+    index.clear();
+    return all;
+}
+
+// 所有形状(按绘制顺序)
+QVector<Scene::Item> Scene::items() const
+{
+    QVector<int> ids;
+    ids.reserve(shapes.size());
+    for (auto it = shapes.cbegin(); it != shapes.cend(); ++it) {
+        ids.append(it.key());
+    }
+    std::sort(ids.begin(), ids.end());
+
+    QVector<Item> all;
+    all.reserve(ids.size());
+    for (int id : ids) {
+        all.append(Item(id, shapes.value(id)));
+    }
+    return all;
+}
+
+// 获取形状
+QSharedPointer<Shape> Scene::shape(int id) const
+{
+    return shapes.value(id);
+}
+
+// 平移一组形状并更新索引
+void Scene::translate(const QVector<int> &ids, const QPoint &delta)
+{
+    for (int id : ids) {
+        QSharedPointer<Shape> item = shapes.value(id);
+        if (!item) continue;
+
+        index.remove(id, rects.value(id));
+        item->translate(delta);
+        QRect rect = indexRect(*item);
+        rects.insert(id, rect);
+        index.insert(id, rect);
+    }
+}
+
+// 绘制区域与矩形相交的形状
+QVector<int> Scene::shapesIn(const QRect &rect) const
+{
+    QVector<int> ids;
+    index.query(rect, ids);
+    std::sort(ids.begin(), ids.end());  // 按绘制顺序排列
+    return ids;
+}
+
+// 边界矩形完全在矩形内的形状
+QVector<int> Scene::shapesContainedIn(const QRect &rect) const
+{
+    QVector<int> ids;
+    for (int id : shapesIn(rect)) {
+        if (rect.contains(shapes.value(id)->boundingRect())) {
+            ids.append(id);
+        }
+    }
+    return ids;
+}
+
+// 命中测试：R树给出绘制区域包含该点的候选，从最上层起返回第一个实际绘制到该点的形状
+int Scene::shapeAt(const QPoint &point) const
+{
+    QVector<int> ids;
+    index.query(point, ids);
+    std::sort(ids.begin(), ids.end(), std::greater<int>());
+    for (int id : std::as_const(ids)) {
+        if (shapes.value(id)->contains(point)) return id;
+    }
+    return -1;
+}
+
+// 一组形状绘制区域的并集
+QRect Scene::paintRect(const QVector<int> &ids) const
+{
+    QRect rect;
+    for (int id : ids) {
+        rect = rect.united(rects.value(id));
+    }
+    return rect;
+}
+
+// 按绘制顺序重绘与区域相交的形状
+void Scene::render(QPainter &painter, const QRect &region) const
+{
+    for (int id : shapesIn(region)) {
+        shapes.value(id)->draw(painter);
+    }
+}
+
+// 形状在索引中的矩形(保证非空)
+QRect Scene::indexRect(const Shape &shape)
+{
+    QRect rect = shape.paintRect();
+    return rect.isEmpty() ? QRect(rect.topLeft(), QSize(1, 1)) : rect;
+}
@@ -0,0 +1,66 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <QHash>
+#include <QPair>
+#include <QPainter>
+#include <QRect>
+#include <QSharedPointer>
+#include <QVector>
+#include "rtree.h"
+#include "shapes.h"
+
+/**
+ * @brief 保留模式的文档模型，保存所有已提交的形状
+ *
+ * 每个形状有一个递增的id，id同时表示绘制顺序(越大越靠上)。
+ * 形状的绘制区域保存在R树中，用于快速命中测试、框选以及只重绘与脏区域相交的形状。
+ */
+class Scene {
+public:
+    /**
+     * @brief 一个形状及其id
+     */
+    typedef QPair<int, QSharedPointer<Shape>> Item;
+
+    Scene();
+
+    int allocateId();  // 分配一个新的形状id
+    void insert(int id, const QSharedPointer<Shape> &shape);  // 以指定id加入形状
+    QSharedPointer<Shape> take(int id);  // 移除并返回形状
+    QVector<Item> takeAll();  // 移除并返回所有形状
+    QVector<Item> items() const;  // 所有形状(按绘制顺序)
+    QSharedPointer<Shape> shape(int id) const;  // 获取形状
+
+    /**
+     * @brief 平移一组形状并更新索引
+     * @param ids 形状id
+     * @param delta 平移量
+     */
+    void translate(const QVector<int> &ids, const QPoint &delta);
+
+    QVector<int> shapesIn(const QRect &rect) const;  // 绘制区域与矩形相交的形状(按绘制顺序)
+    QVector<int> shapesContainedIn(const QRect &rect) const;  // 边界矩形完全在矩形内的形状(按绘制顺序)
+    int shapeAt(const QPoint &point) const;  // 命中测试：返回实际绘制到该点的最上层形状，没有时返回-1
+    QRect paintRect(const QVector<int> &ids) const;  // 一组形状绘制区域的并集
+
+    /**
+     * @brief 按绘制顺序重绘与区域相交的形状
+     * @param painter 绘制器，调用者负责设置裁剪
+     * @param region 需要重绘的区域
+     */
+    void render(QPainter &painter, const QRect &region) const;
+
+    int size() const { return shapes.size(); }  // 形状数量
+    bool isEmpty() const { return shapes.isEmpty(); }  // 是否没有形状
+
+private:
+    static QRect indexRect(const Shape &shape);  // 形状在索引中的矩形
+
+    QHash<int, QSharedPointer<Shape>> shapes;  // id到形状的映射
+    QHash<int, QRect> rects;  // 形状加入索引时的矩形(删除索引项时需要)
+    RTree index;  // 空间索引
+    int lastId;  // 最近分配的id
+};
+
+#endif // SCENE_H
@@ -0,0 +1,106 @@
+#include "shapefactory.h"
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+
+namespace {
+
+const int MaxPooledPerType = 64;  // 每种形状类最多保留的空闲对象数
+
+/**
+ * @brief 注册表和对象池，所有访问都在mutex保护下
+ */
+struct FactoryState {
+    QMutex mutex;
+    QHash<int, ShapeFactory::Creator> creators;  // 形状类型到创建函数
+    QHash<const std::type_info *, QVector<Shape *>> pools;  // 形状类到空闲对象(同一程序内每个类的type_info唯一)
+
+    ~FactoryState()
+    {
+        for (const QVector<Shape *> &pool : std::as_const(pools)) {
+            qDeleteAll(pool);
+        }
+    }
+};
+
+FactoryState &state()
+{
+    static FactoryState instance;
+    return instance;
+}
+
+} // namespace
+
+// 释放独占的形状：放回对象池
+void ShapeRecycler::operator()(Shape *shape) const
+{
+    ShapeFactory::recycle(shape);
+}
+
+// 注册一种形状类型
+void ShapeFactory::registerShape(int type, Creator creator)
+{
+    FactoryState &s = state();
+    QMutexLocker locker(&s.mutex);
+    s.creators.insert(type, creator);
+}
+
+// 按类型创建形状
+ShapeHandle ShapeFactory::create(int type, const QPoint &start, const QColor &color, int width)
+{
+    Creator creator = nullptr;
+    {
+        FactoryState &s = state();
+        QMutexLocker locker(&s.mutex);
+        creator = s.creators.value(type, nullptr);
+    }
+    if (!creator) return ShapeHandle();
+
+    ShapeHandle shape = creator(start, color, width);
+    if (shape) shape->setType(type);  // 记录类型，工程文件按类型重新创建形状
+    return shape;
+}
+
+// 把独占的形状转为共享指针
+QSharedPointer<Shape> ShapeFactory::share(ShapeHandle shape)
+{
+    return QSharedPointer<Shape>(shape.release(), &ShapeFactory::recycle);
+}
+
+// 把形状放回对象池，池已满时删除
+void ShapeFactory::recycle(Shape *shape)
+{
+    if (!shape) return;
+
+    FactoryState &s = state();
+    QMutexLocker locker(&s.mutex);
+    QVector<Shape *> &pool = s.pools[&typeid(*shape)];
+    if (pool.size() < MaxPooledPerType) {
+        pool.append(shape);
+        return;
+    }
+    locker.unlock();
+    delete shape;
+}
+
+// 所有对象池中空闲的形状数
+int ShapeFactory::pooledCount()
+{
+    FactoryState &s = state();
+    QMutexLocker locker(&s.mutex);
+    int count = 0;
+    for (const QVector<Shape *> &pool : std::as_const(s.pools)) {
+        count += pool.size();
+    }
+    return count;
+}
+
+// 从对象池取出一个空闲形状
+Shape *ShapeFactory::take(const std::type_info &type)
+{
+    FactoryState &s = state();
+    QMutexLocker locker(&s.mutex);
+    auto pool = s.pools.find(&type);
+    if (pool == s.pools.end() || pool->isEmpty()) return nullptr;
+    return pool->takeLast();
+}
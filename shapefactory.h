@@ -0,0 +1,84 @@
+#ifndef SHAPEFACTORY_H
+#define SHAPEFACTORY_H
+
+#include <QColor>
+#include <QPoint>
+#include <QSharedPointer>
+#include <typeinfo>
+#include "shapes.h"
+
+/**
+ * @brief 按类型注册的形状工厂，形状对象来自每种形状类各自的对象池
+ *
+ * 形状通过ShapeHandle独占持有，释放时不删除而是重置后放回对象池，下次创建同类形状时
+ * 直接复用，路径点缓冲区的容量也随之保留。提交到文档的形状通过share()转为共享指针，
+ * 最后一个引用释放时同样回到对象池。对象池有上限，超出的对象直接删除。
+ * 批量渲染在线程池中创建形状，所有接口都是线程安全的。
+ */
+class ShapeFactory {
+public:
+    /**
+     * @brief 创建函数：从对象池取出并初始化一个形状
+     */
+    typedef ShapeHandle (*Creator)(const QPoint &start, const QColor &color, int width);
+
+    /**
+     * @brief 注册一种形状类型
+     * @param type 形状类型(如PaintArea::DrawShape)
+     * @param creator 创建函数
+     */
+    static void registerShape(int type, Creator creator);
+
+    /**
+     * @brief 按类型创建形状
+     * @return 新形状(type()为创建时的类型)，类型未注册时为空
+     */
+    static ShapeHandle create(int type, const QPoint &start, const QColor &color, int width);
+
+    /**
+     * @brief 从T的对象池取出一个形状并重置为新起点和样式，池为空时才分配
+     */
+    template<class T>
+    static ShapeHandle acquire(const QPoint &start, const QColor &color, int width);
+
+    /**
+     * @brief 从对象池取出一个T并复制shape的内容，用于实现clone()
+     */
+    template<class T>
+    static ShapeHandle copy(const T &shape);
+
+    /**
+     * @brief 把独占的形状转为共享指针，最后一个引用释放时形状回到对象池
+     */
+    static QSharedPointer<Shape> share(ShapeHandle shape);
+
+    static void recycle(Shape *shape);  // 把形状放回对象池(由ShapeRecycler调用)
+    static int pooledCount();  // 所有对象池中空闲的形状数
+
+private:
+    static Shape *take(const std::type_info &type);  // 从对象池取出一个空闲形状，没有时返回nullptr
+};
+
+// 从T的对象池取出一个形状并重置
+template<class T>
+ShapeHandle ShapeFactory::acquire(const QPoint &start, const QColor &color, int width)
+{
+    Shape *shape = take(typeid(T));
+    if (shape) {
+        shape->reset(start, color, width);
+    } else {
+        shape = new T(start, color, width);
+    }
+    return ShapeHandle(shape);
+}
+
+// 从对象池取出一个T并复制内容
+template<class T>
+ShapeHandle ShapeFactory::copy(const T &shape)
+{
+    ShapeHandle result = acquire<T>(QPoint(), QColor(), 0);
+    static_cast<T &>(*result) = shape;
+    return result;
+}
+
+#endif // SHAPEFACTORY_H
@@ -1,6 +1,8 @@
 #include "shapes.h"  // 包含形状类的头文件
+#include "shapefactory.h"  // 形状对象池
 #include <cmath>     // 包含数学函数库
 #include <QPainterPath>  // Qt绘图路径类
+#include <QPainterPathStroker>  // 命中测试时按画笔描边
 
 // 如果系统没有定义M_PI(π的值)，则手动定义
 #ifndef M_PI
@@ -12,7 +14,67 @@
 // Shape构造函数
 // 参数：start - 起始点坐标；color - 画笔颜色；width - 画笔宽度
 Shape::Shape(const QPoint& start, const QColor& color, int width)
-    : startPoint(start), endPoint(start), penColor(color), penWidth(width) {}
+    : startPoint(start), endPoint(start), penColor(color), penWidth(width),
+      geometryValid(false), shapeType(-1), styleValid(false) {}
+
+// 重置为刚构造时的状态
+void Shape::reset(const QPoint& start, const QColor& color, int width) {
+    startPoint = start;
+    endPoint = start;
+    penColor = color;
+    penWidth = width;
+    geometryValid = false;
+    shapeType = -1;
+    styleValid = false;
+}
+
+// 写入端点和样式
+void Shape::write(QDataStream& out) const {
+    out << startPoint << endPoint << penColor << qint32(penWidth);
+}
+
+// 读取端点和样式，几何和画笔缓存随之失效
+bool Shape::read(QDataStream& in) {
+    qint32 width = 0;
+    in >> startPoint >> endPoint >> penColor >> width;
+    penWidth = width;
+    geometryValid = false;
+    styleValid = false;
+    return in.status() == QDataStream::Ok;
+}
+
+// 默认画笔：指定颜色和宽度
+QPen Shape::createPen() const {
+    return QPen(penColor, penWidth);
+}
+
+// 缓存的画笔：QPen构造时要分配私有数据，已提交的形状每次重绘都复用同一个
+const QPen& Shape::pen() const {
+    if (!styleValid) {
+        cachedPen = createPen();
+        cachedBrush = QBrush(penColor);
+        styleValid = true;
+    }
+    return cachedPen;
+}
+
+// 缓存的填充画刷，与画笔一起重建
+const QBrush& Shape::brush() const {
+    pen();
+    return cachedBrush;
+}
+
+// 默认命中测试：点在绘制区域内
+bool Shape::contains(const QPoint& point) const {
+    return paintRect().contains(point);
+}
+
+// 点是否在路径按画笔描边后的轮廓内，线条两侧各多容许HitMargin像素，细线也容易点中
+bool Shape::outlineContains(const QPainterPath& path, const QPoint& point) const {
+    QPainterPathStroker stroker(pen());
+    stroker.setWidth(qMax(penWidth, 1) + 2 * HitMargin);
+    return stroker.createStroke(path).contains(QPointF(point));
+}
 
 // 获取形状的边界矩形
 QRect Shape::boundingRect() const {
@@ -20,9 +82,33 @@ QRect Shape::boundingRect() const {
     return QRect(startPoint, endPoint).normalized();
 }
 
+// 获取形状实际绘制所覆盖的区域(边界矩形加上画笔宽度)
+QRect Shape::paintRect() const {
+    return boundingRect().adjusted(-penWidth, -penWidth, penWidth, penWidth);
+}
+
+// 默认不支持增量绘制，新增部分就是整个形状
+QRect Shape::pendingRect() const {
+    return paintRect();
+}
+
+// 默认不支持增量绘制，直接完整绘制一次
+void Shape::drawPending(QPainter& painter) const {
+    draw(painter);
+}
+
 // 更新形状的终点坐标
 void Shape::update(const QPoint& toPoint) {
+    if (toPoint == endPoint) return;  // 终点未移动时保留几何缓存
     endPoint = toPoint;  // 将终点更新为指定点
+    geometryValid = false;
+}
+
+// 整体平移形状
+void Shape::translate(const QPoint& delta) {
+    startPoint += delta;
+    endPoint += delta;
+    geometryValid = false;
 }
 
 /* ========== LineShape 直线实现 ========== */
@@ -31,17 +117,29 @@ void Shape::update(const QPoint& toPoint) {
 LineShape::LineShape(const QPoint& start, const QColor& color, int width)
     : Shape(start, color, width) {}
 
-// 绘制直线
-void LineShape::draw(QPainter& painter) const {
+// 直线画笔：圆角线帽
+QPen LineShape::createPen() const {
     QPen pen(penColor, penWidth);  // 创建指定颜色和宽度的画笔
     pen.setCapStyle(Qt::RoundCap); // 设置线帽为圆角
-    painter.setPen(pen);           // 将画笔设置给绘制器
+    return pen;
+}
+
+// 绘制直线
+void LineShape::draw(QPainter& painter) const {
+    painter.setPen(pen());         // 将画笔设置给绘制器
     painter.drawLine(startPoint, endPoint);  // 绘制从起点到终点的直线
 }
 
+// 点是否在线条上
+bool LineShape::contains(const QPoint& point) const {
+    QPainterPath path(startPoint);
+    path.lineTo(endPoint);
+    return outlineContains(path, point);
+}
+
 // 克隆直线对象
-Shape* LineShape::clone() const {
-    return new LineShape(*this);  // 返回当前对象的副本
+ShapeHandle LineShape::clone() const {
+    return ShapeFactory::copy(*this);  // 返回当前对象的副本
 }
 
 /* ========== RectangleShape 矩形实现 ========== */
@@ -50,19 +148,30 @@ Shape* LineShape::clone() const {
 RectangleShape::RectangleShape(const QPoint& start, const QColor& color, int width)
     : Shape(start, color, width) {}
 
-// 绘制矩形
-void RectangleShape::draw(QPainter& painter) const {
+// 矩形画笔：圆角连接
+QPen RectangleShape::createPen() const {
     QPen pen(penColor, penWidth);  // 创建画笔
     pen.setJoinStyle(Qt::RoundJoin); // 设置连接点为圆角
-    painter.setPen(pen);            // 设置画笔
-    painter.setBrush(QBrush(penColor)); // 设置填充画刷
+    return pen;
+}
+
+// 绘制矩形
+void RectangleShape::draw(QPainter& painter) const {
+    painter.setPen(pen());          // 设置画笔
+    painter.setBrush(brush());      // 设置填充画刷
     // 绘制规范化后的矩形(确保宽度和高度为正)
     painter.drawRect(QRect(startPoint, endPoint).normalized());
 }
 
+// 矩形是填充的，点在向外扩展半个画笔宽度的矩形内即命中
+bool RectangleShape::contains(const QPoint& point) const {
+    int margin = penWidth / 2 + HitMargin;
+    return QRect(startPoint, endPoint).normalized().adjusted(-margin, -margin, margin, margin).contains(point);
+}
+
 // 克隆矩形对象
-Shape* RectangleShape::clone() const {
-    return new RectangleShape(*this);
+ShapeHandle RectangleShape::clone() const {
+    return ShapeFactory::copy(*this);
 }
 
 /* ========== EllipseShape 椭圆实现 ========== */
@@ -73,16 +182,22 @@ EllipseShape::EllipseShape(const QPoint& start, const QColor& color, int width)
 
 // 绘制椭圆
 void EllipseShape::draw(QPainter& painter) const {
-    QPen pen(penColor, penWidth);  // 创建画笔
-    painter.setPen(pen);           // 设置画笔
-    painter.setBrush(QBrush(penColor)); // 设置填充画刷
+    painter.setPen(pen());         // 设置画笔
+    painter.setBrush(brush());     // 设置填充画刷
     // 在规范化后的矩形内绘制椭圆
     painter.drawEllipse(QRect(startPoint, endPoint).normalized());
 }
 
+// 椭圆是填充的，点在椭圆内或边框上即命中
+bool EllipseShape::contains(const QPoint& point) const {
+    QPainterPath path;
+    path.addEllipse(QRect(startPoint, endPoint).normalized());
+    return path.contains(QPointF(point)) || outlineContains(path, point);
+}
+
 // 克隆椭圆对象
-Shape* EllipseShape::clone() const {
-    return new EllipseShape(*this);
+ShapeHandle EllipseShape::clone() const {
+    return ShapeFactory::copy(*this);
 }
 
 /* ========== ArrowShape 箭头实现 ========== */
@@ -91,38 +206,64 @@ Shape* EllipseShape::clone() const {
 ArrowShape::ArrowShape(const QPoint& start, const QColor& color, int width)
     : Shape(start, color, width) {}
 
-// 绘制箭头
-void ArrowShape::draw(QPainter& painter) const {
+// 箭头画笔：圆角线帽
+QPen ArrowShape::createPen() const {
     QPen pen(penColor, penWidth);  // 创建画笔
     pen.setCapStyle(Qt::RoundCap); // 设置线帽为圆角
-    painter.setPen(pen);           // 设置画笔
+    return pen;
+}
+
+// 绘制箭头：箭头杆和两个分支一次绘制
+void ArrowShape::draw(QPainter& painter) const {
+    ensureGeometry();
+    painter.setPen(pen());         // 设置画笔
+    painter.drawLines(lines, 3);
+}
 
-    // 1. 绘制主线条(箭头杆)
-    painter.drawLine(startPoint, endPoint);
+// 计算箭头杆和头部两个分支线段
+void ArrowShape::ensureGeometry() const {
+    if (geometryValid) return;
 
-    // 2. 绘制箭头头部
     qreal arrowSize = penWidth * 4;  // 箭头大小与线宽成正比
     QLineF line(endPoint, startPoint); // 创建从终点到起点的线(用于计算角度)
     double angle = std::atan2(-line.dy(), line.dx()); // 计算线的角度(弧度)
 
-    // 计算箭头两个分支点的位置
-    QPointF arrowP1 = endPoint + QPointF(
-                          std::sin(angle + M_PI/3) * arrowSize,  // 第一个分支点x坐标
-                          std::cos(angle + M_PI/3) * arrowSize   // 第一个分支点y坐标
-                          );
-    QPointF arrowP2 = endPoint + QPointF(
-                          std::sin(angle + M_PI - M_PI/3) * arrowSize, // 第二个分支点x坐标
-                          std::cos(angle + M_PI - M_PI/3) * arrowSize  // 第二个分支点y坐标
-                          );
+    QPointF p1 = endPoint + QPointF(
+                     std::sin(angle + M_PI/3) * arrowSize,  // 第一个分支点x坐标
+                     std::cos(angle + M_PI/3) * arrowSize   // 第一个分支点y坐标
+                     );
+    QPointF p2 = endPoint + QPointF(
+                     std::sin(angle + M_PI - M_PI/3) * arrowSize, // 第二个分支点x坐标
+                     std::cos(angle + M_PI - M_PI/3) * arrowSize  // 第二个分支点y坐标
+                     );
+
+    lines[0] = QLineF(startPoint, endPoint);  // 主线条(箭头杆)
+    lines[1] = QLineF(endPoint, p1);  // 箭头两个分支线
+    lines[2] = QLineF(endPoint, p2);
+    headBounds = QRectF(p1, p2).normalized().toAlignedRect();
+    geometryValid = true;
+}
+
+// 箭头的边界矩形需要包含头部的两个分支点
+QRect ArrowShape::boundingRect() const {
+    ensureGeometry();
+    return Shape::boundingRect().united(headBounds);
+}
 
-    // 绘制箭头两个分支线
-    painter.drawLine(endPoint, arrowP1);
-    painter.drawLine(endPoint, arrowP2);
+// 点是否在箭头杆或两个分支上
+bool ArrowShape::contains(const QPoint& point) const {
+    ensureGeometry();
+    QPainterPath path;
+    for (const QLineF& line : lines) {
+        path.moveTo(line.p1());
+        path.lineTo(line.p2());
+    }
+    return outlineContains(path, point);
 }
 
 // 克隆箭头对象
-Shape* ArrowShape::clone() const {
-    return new ArrowShape(*this);
+ShapeHandle ArrowShape::clone() const {
+    return ShapeFactory::copy(*this);
 }
 
 /* ========== StarShape 五角星实现 ========== */
@@ -133,15 +274,21 @@ StarShape::StarShape(const QPoint& start, const QColor& color, int width)
 
 // 绘制五角星
 void StarShape::draw(QPainter& painter) const {
-    QPen pen(penColor, penWidth);  // 创建画笔
-    painter.setPen(pen);           // 设置画笔
-    painter.setBrush(QBrush(penColor)); // 设置填充画刷
+    ensureGeometry();
+    painter.setPen(pen());         // 设置画笔
+    painter.setBrush(brush());     // 设置填充画刷
+    painter.drawPath(path);  // 绘制完整路径
+}
+
+// 构建五角星路径
+void StarShape::ensureGeometry() const {
+    if (geometryValid) return;
 
     QRect rect = QRect(startPoint, endPoint).normalized(); // 获取规范化矩形
     qreal radius = qMin(rect.width(), rect.height()) / 2;  // 计算外接圆半径(取宽高较小者的一半)
     QPoint center = rect.center();  // 获取中心点
 
-    QPainterPath path;  // 创建绘图路径
+    path.clear();  // 清空路径(保留元素缓冲区)
     // 绘制五角星的五个顶点
     for (int i = 0; i < 5; ++i) {
         // 计算外顶点角度(均匀分布在圆周上，从12点钟方向开始)
@@ -161,12 +308,18 @@ void StarShape::draw(QPainter& painter) const {
         path.lineTo(innerPoint);  // 画线到内顶点
     }
     path.closeSubpath();  // 闭合路径
-    painter.drawPath(path);  // 绘制完整路径
+    geometryValid = true;
+}
+
+// 五角星是填充的，点在星形内或边框上即命中(角之间的空白不算)
+bool StarShape::contains(const QPoint& point) const {
+    ensureGeometry();
+    return path.contains(QPointF(point)) || outlineContains(path, point);
 }
 
 // 克隆五角星对象
-Shape* StarShape::clone() const {
-    return new StarShape(*this);
+ShapeHandle StarShape::clone() const {
+    return ShapeFactory::copy(*this);
 }
 
 /* ========== DiamondShape 菱形实现 ========== */
@@ -177,23 +330,38 @@ DiamondShape::DiamondShape(const QPoint& start, const QColor& color, int width)
 
 // 绘制菱形
 void DiamondShape::draw(QPainter& painter) const {
-    QPen pen(penColor, penWidth);  // 创建画笔
-    painter.setPen(pen);           // 设置画笔
-    painter.setBrush(QBrush(penColor)); // 设置填充画刷
+    ensureGeometry();
+    painter.setPen(pen());         // 设置画笔
+    painter.setBrush(brush());     // 设置填充画刷
+    painter.drawPolygon(polygon);  // 绘制菱形多边形
+}
+
+// 计算菱形的四个顶点
+void DiamondShape::ensureGeometry() const {
+    if (geometryValid) return;
 
     QRect rect = QRect(startPoint, endPoint).normalized(); // 获取规范化矩形
-    QPolygon diamond;  // 创建多边形
-    // 添加菱形的四个顶点(上、右、下、左)
-    diamond << QPoint(rect.center().x(), rect.top())      // 上顶点
-            << QPoint(rect.right(), rect.center().y())    // 右顶点
-            << QPoint(rect.center().x(), rect.bottom())   // 下顶点
-            << QPoint(rect.left(), rect.center().y());    // 左顶点
-    painter.drawPolygon(diamond);  // 绘制菱形多边形
+    polygon.resize(4);
+    // 菱形的四个顶点(上、右、下、左)
+    polygon[0] = QPoint(rect.center().x(), rect.top());      // 上顶点
+    polygon[1] = QPoint(rect.right(), rect.center().y());    // 右顶点
+    polygon[2] = QPoint(rect.center().x(), rect.bottom());   // 下顶点
+    polygon[3] = QPoint(rect.left(), rect.center().y());     // 左顶点
+    geometryValid = true;
+}
+
+// 菱形是填充的，点在菱形内或边框上即命中
+bool DiamondShape::contains(const QPoint& point) const {
+    ensureGeometry();
+    QPainterPath path;
+    path.addPolygon(QPolygonF(polygon));
+    path.closeSubpath();
+    return path.contains(QPointF(point)) || outlineContains(path, point);
 }
 
 // 克隆菱形对象
-Shape* DiamondShape::clone() const {
-    return new DiamondShape(*this);
+ShapeHandle DiamondShape::clone() const {
+    return ShapeFactory::copy(*this);
 }
 
 /* ========== HeartShape 心形实现 ========== */
@@ -204,11 +372,19 @@ HeartShape::HeartShape(const QPoint& start, const QColor& color, int width)
 
 // 绘制心形
 void HeartShape::draw(QPainter& painter) const {
+    ensureGeometry();
+    painter.fillPath(path, brush());  // 填充心形路径
+}
+
+// 构建心形路径
+void HeartShape::ensureGeometry() const {
+    if (geometryValid) return;
+
     QRect rect = QRect(startPoint, endPoint).normalized(); // 获取规范化矩形
     qreal scale = qMin(rect.width(), rect.height()) / 100; // 计算缩放比例(基于100像素基准)
     QPoint center = rect.center();  // 获取中心点
 
-    QPainterPath path;  // 创建绘图路径
+    path.clear();  // 清空路径(保留元素缓冲区)
     // 从心形底部开始
     path.moveTo(center.x(), center.y() + 25*scale);
     // 绘制右侧贝塞尔曲线
@@ -219,13 +395,25 @@ void HeartShape::draw(QPainter& painter) const {
     path.cubicTo(center.x() - 95*scale, center.y() - 35*scale,  // 控制点1
                  center.x() - 45*scale, center.y() - 55*scale,  // 控制点2
                  center.x(), center.y() + 25*scale);            // 终点
+    pathBounds = path.controlPointRect().toAlignedRect();
+    geometryValid = true;
+}
 
-    painter.fillPath(path, penColor);  // 填充心形路径
+// 心形的控制点会超出拖拽矩形，边界矩形取路径实际范围
+QRect HeartShape::boundingRect() const {
+    ensureGeometry();
+    return Shape::boundingRect().united(pathBounds);
+}
+
+// 心形只填充不描边，点在路径内即命中
+bool HeartShape::contains(const QPoint& point) const {
+    ensureGeometry();
+    return path.contains(QPointF(point));
 }
 
 // 克隆心形对象
-Shape* HeartShape::clone() const {
-    return new HeartShape(*this);
+ShapeHandle HeartShape::clone() const {
+    return ShapeFactory::copy(*this);
 }
 
 /* ========== PathShape 路径实现(用于自由绘制和橡皮擦) ========== */
@@ -233,56 +421,356 @@ Shape* HeartShape::clone() const {
 // 路径构造函数
 // 参数：isEraser - 是否为橡皮擦模式
 PathShape::PathShape(const QPoint& start, const QColor& color, int width, bool isEraser)
-    : Shape(start, color, width), eraser(isEraser) {}
-
-// 绘制路径
-void PathShape::draw(QPainter& painter) const {
-    if (points.empty()) return;  // 如果没有点则直接返回
+    : Shape(start, color, width), eraser(isEraser), drawnPoints(0), hasFloating(false), tolerance(0), smooth(false) {}
 
-    // 设置画笔：橡皮擦模式使用白色，否则使用指定颜色
+// 路径使用的画笔：橡皮擦模式使用白色，否则使用指定颜色
+// 圆角连接与逐段绘制的圆角线帽覆盖相同的区域，整条折线可以一次绘制
+QPen PathShape::createPen() const {
     QPen pen(eraser ? Qt::white : penColor, penWidth);
     pen.setCapStyle(Qt::RoundCap);  // 设置圆角线帽
-    painter.setPen(pen);            // 设置画笔
+    pen.setJoinStyle(Qt::RoundJoin);  // 设置圆角连接
+    return pen;
+}
 
-    // 连接所有点形成路径
-    for (int i = 1; i < points.size(); ++i) {
-        painter.drawLine(points[i-1], points[i]);
+// 绘制路径：折线或平滑曲线都只发出一次绘制调用
+void PathShape::draw(QPainter& painter) const {
+    if (points.size() < 2) return;  // 不足一条线段时直接返回
+
+    painter.setPen(pen());  // 设置画笔
+    painter.setBrush(Qt::NoBrush);
+
+    if (smooth && points.size() > 2) {
+        painter.drawPath(smoothPath());
+    } else {
+        painter.drawPolyline(points.constData(), points.size());
+    }
+}
+
+// 设置是否平滑
+void PathShape::setSmoothing(bool smooth) {
+    this->smooth = smooth;
+    smoothed = QPainterPath();
+}
+
+// 平滑后的路径：每段p1→p2按Catmull-Rom样条转为三次贝塞尔曲线，
+// 控制点为p1 + (p2 - p0) / 6和p2 - (p3 - p1) / 6，曲线经过所有路径点
+const QPainterPath& PathShape::smoothPath() const {
+    if (!smoothed.isEmpty()) return smoothed;
+
+    int count = points.size();
+    smoothed.reserve(count * 3);
+    smoothed.moveTo(points.first());
+    for (int i = 0; i + 1 < count; ++i) {
+        QPointF p0 = points[qMax(0, i - 1)];
+        QPointF p1 = points[i];
+        QPointF p2 = points[i + 1];
+        QPointF p3 = points[qMin(count - 1, i + 2)];
+        smoothed.cubicTo(p1 + (p2 - p0) / 6.0, p2 - (p3 - p1) / 6.0, p2);
     }
+    return smoothed;
+}
+
+// 已固定的点数：开启简化时末点可能被下一个采样点替换，连接它的末段不写入持久缓冲区
+int PathShape::fixedPoints() const {
+    return tolerance > 0 && points.size() >= 2 && !skipped.isEmpty() ? points.size() - 1 : points.size();
+}
+
+// 新增的固定线段所占的区域，考虑线宽向外扩展
+QRect PathShape::pendingRect() const {
+    int first = qMax(1, drawnPoints);  // 第一条新线段的终点下标
+    int count = fixedPoints();
+    if (first >= count) return QRect();
+
+    int minX = points[first-1].x();
+    int minY = points[first-1].y();
+    int maxX = minX;
+    int maxY = minY;
+    for (int i = first; i < count; ++i) {
+        minX = qMin(minX, points[i].x());
+        minY = qMin(minY, points[i].y());
+        maxX = qMax(maxX, points[i].x());
+        maxY = qMax(maxY, points[i].y());
+    }
+    return QRect(QPoint(minX, minY), QPoint(maxX, maxY))
+        .adjusted(-penWidth, -penWidth, penWidth, penWidth);
+}
+
+// 增量绘制路径：只绘制上次之后新增的固定线段，浮动的末段由drawFloating()每帧单独绘制，
+// 持久缓冲区中只有不会再改变的线段，替换末点时不会留下旧线段
+// 新旧折线在连接点处各有一个圆角线帽，不透明颜色时与圆角连接覆盖相同的像素；
+// 半透明颜色时重叠处会叠加两次，平滑也只在完整绘制时应用，因此预览只是近似
+void PathShape::drawPending(QPainter& painter) const {
+    int first = qMax(1, drawnPoints);
+    int count = fixedPoints();
+    if (first >= count) return;
+
+    painter.setPen(pen());
+    painter.drawPolyline(points.constData() + first - 1, count - first + 1);
+}
+
+// 记录已绘制的点数，并保存此时的浮动末段供每帧绘制
+void PathShape::markDrawn() {
+    drawnPoints = fixedPoints();
+    hasFloating = drawnPoints < points.size();
+    if (hasFloating) {
+        floating = QLine(points[points.size() - 2], points.last());
+    }
+}
+
+// 重置增量绘制进度
+void PathShape::resetIncremental() {
+    drawnPoints = 0;
+    hasFloating = false;
+}
+
+// 浮动末段所占的区域，考虑线宽向外扩展
+QRect PathShape::floatingRect() const {
+    if (!hasFloating) return QRect();
+    return QRect(floating.p1(), floating.p2()).normalized()
+        .adjusted(-penWidth, -penWidth, penWidth, penWidth);
+}
+
+// 绘制浮动末段
+void PathShape::drawFloating(QPainter& painter) const {
+    if (!hasFloating) return;
+
+    painter.setPen(pen());
+    painter.drawLine(floating);
 }
 
 // 更新路径，添加新点
+// 开启简化时末点是浮动的：只要新采样点和之前省略的采样点都在容差内，
+// 就用新采样点替换末点，否则固定末点并追加新点(流式的Douglas-Peucker近似)
 void PathShape::update(const QPoint& toPoint) {
-    points.append(toPoint);  // 将新点添加到路径中
+    const int MaxSkipped = 256;  // 限制每次检查的采样点数，使追加的开销有上界
+
+    if (tolerance > 0 && points.size() >= 2 && !skipped.isEmpty() &&
+        skipped.size() < MaxSkipped && withinTolerance(points[points.size() - 2], toPoint)) {
+        points.last() = toPoint;  // 替换浮动的末点(末段不在持久缓冲区中，无需擦除)
+        skipped.append(toPoint);
+    } else {
+        points.append(toPoint);  // 将新点添加到路径中
+        skipped.clear();
+        skipped.append(toPoint);
+    }
     endPoint = toPoint;      // 更新终点
+    smoothed = QPainterPath();
+
+    // 增量维护包围矩形，避免每次查询都遍历所有点
+    QRect pointRect(toPoint, QSize(1, 1));
+    pointBounds = pointBounds.isNull() ? pointRect : pointBounds.united(pointRect);
+}
+
+// 以anchor为起点、toPoint为新末点时，之前省略的采样点到该线段的距离是否都不超过容差
+bool PathShape::withinTolerance(const QPoint& anchor, const QPoint& toPoint) const {
+    const qreal limit = tolerance * tolerance;
+    const qreal dx = toPoint.x() - anchor.x();
+    const qreal dy = toPoint.y() - anchor.y();
+    const qreal lengthSquared = dx * dx + dy * dy;
+
+    for (const QPoint& p : skipped) {
+        qreal px = p.x() - anchor.x();
+        qreal py = p.y() - anchor.y();
+        // 投影到线段上最近的点
+        qreal t = lengthSquared > 0 ? qBound(0.0, (px * dx + py * dy) / lengthSquared, 1.0) : 0.0;
+        qreal ex = px - t * dx;
+        qreal ey = py - t * dy;
+        if (ex * ex + ey * ey > limit) return false;
+    }
+    return true;
+}
+
+// 平移路径上的所有点
+void PathShape::translate(const QPoint& delta) {
+    Shape::translate(delta);
+    for (QPoint& p : points) {
+        p += delta;
+    }
+    for (QPoint& p : skipped) {
+        p += delta;
+    }
+    pointBounds.translate(delta);
+    smoothed = QPainterPath();
 }
 
 // 获取路径的边界矩形
 QRect PathShape::boundingRect() const {
     if (points.empty()) return QRect();  // 如果没有点则返回空矩形
 
-    // 初始化最小/最大坐标
-    int minX = points[0].x();
-    int minY = points[0].y();
-    int maxX = minX;
-    int maxY = minY;
+    // 返回包含所有点的矩形，并考虑线宽向外扩展
+    return pointBounds.adjusted(-penWidth, -penWidth, penWidth, penWidth);
+}
 
-    // 遍历所有点找到边界
-    for (const QPoint& p : points) {
-        if (p.x() < minX) minX = p.x();
-        if (p.y() < minY) minY = p.y();
-        if (p.x() > maxX) maxX = p.x();
-        if (p.y() > maxY) maxY = p.y();
+// 点是否在笔画上：按绘制时的折线或平滑曲线描边后判断
+bool PathShape::contains(const QPoint& point) const {
+    if (points.isEmpty()) return false;
+    if (points.size() == 1) {
+        return QLineF(points.first(), point).length() <= penWidth / 2.0 + HitMargin;
     }
 
-    // 返回包含所有点的矩形，并考虑线宽向外扩展
-    return QRect(QPoint(minX, minY), QPoint(maxX, maxY))
-        .adjusted(-penWidth, -penWidth, penWidth, penWidth);
+    if (smooth && points.size() > 2) return outlineContains(smoothPath(), point);
+    QPainterPath path(points.first());
+    for (int i = 1; i < points.size(); ++i) {
+        path.lineTo(points[i]);
+    }
+    return outlineContains(path, point);
 }
 
 // 克隆路径对象
-Shape* PathShape::clone() const {
-    PathShape* clone = new PathShape(startPoint, penColor, penWidth, eraser);
-    clone->points = points;    // 复制所有点
+// 路径点逐个复制到副本自己的缓冲区，而不是与原路径隐式共享，
+// 这样原路径重置后仍保留缓冲区，可以在下一笔中复用
+ShapeHandle PathShape::clone() const {
+    ShapeHandle handle = ShapeFactory::acquire<PathShape>(startPoint, penColor, penWidth);
+    PathShape* clone = static_cast<PathShape*>(handle.get());
+    clone->eraser = eraser;
+    clone->points.append(points);    // 复制所有点
     clone->endPoint = endPoint; // 复制终点
-    return clone;
+    clone->pointBounds = pointBounds; // 复制包围矩形
+    clone->tolerance = tolerance;     // 复制简化和平滑设置
+    clone->smooth = smooth;
+    clone->skipped.append(skipped);
+    clone->setType(type());           // 对象池取出的形状类型为-1，保留类型才能写入工程文件
+    return handle;
+}
+
+// 重置为空路径：clear()保留已分配的容量，复用时追加点不再分配内存
+void PathShape::reset(const QPoint& start, const QColor& color, int width) {
+    Shape::reset(start, color, width);
+    points.clear();
+    skipped.clear();
+    eraser = false;
+    pointBounds = QRect();
+    drawnPoints = 0;
+    hasFloating = false;
+    tolerance = 0;
+    smooth = false;
+    smoothed = QPainterPath();
+}
+
+// 写入路径点和绘制选项；简化的浮动末点已经固定，不需要保存省略的采样点
+void PathShape::write(QDataStream& out) const {
+    Shape::write(out);
+    out << points << eraser << smooth << tolerance;
+}
+
+// 读取路径点并重建包围矩形，读入的路径整体作为尚未增量绘制的内容
+bool PathShape::read(QDataStream& in) {
+    if (!Shape::read(in)) return false;
+    in >> points >> eraser >> smooth >> tolerance;
+    if (in.status() != QDataStream::Ok) return false;
+
+    skipped.clear();
+    drawnPoints = 0;
+    smoothed = QPainterPath();
+    pointBounds = QRect();
+    for (const QPoint& point : std::as_const(points)) {
+        QRect pointRect(point, QSize(1, 1));
+        pointBounds = pointBounds.isNull() ? pointRect : pointBounds.united(pointRect);
+    }
+    return true;
+}
+
+/* ========== FillShape 填充区域实现(用于油漆桶) ========== */
+
+// 填充区域构造函数，区域由setRegion()设置
+FillShape::FillShape(const QPoint& start, const QColor& color, int width)
+    : Shape(start, color, width) {}
+
+// 只填充与裁剪范围相交的行组中的矩形；跨越多个行组的矩形按行组切开，每个像素只填充一次
+void FillShape::draw(QPainter& painter) const {
+    if (rects.isEmpty()) return;
+    ensureGeometry();
+
+    QRect clip = painter.hasClipping() ? painter.clipBoundingRect().toAlignedRect().intersected(bounds) : bounds;
+    if (clip.isEmpty()) return;
+
+    int first = (clip.top() - bounds.top()) / BandHeight;
+    int last = (clip.bottom() - bounds.top()) / BandHeight;
+    for (int band = first; band <= last; ++band) {
+        QRect bandClip = clip.intersected(QRect(bounds.left(), bounds.top() + band * BandHeight,
+                                                bounds.width(), BandHeight));
+        for (int index : bands[band]) {
+            QRect part = rects[index].intersected(bandClip);
+            if (!part.isEmpty()) painter.fillRect(part, brush());
+        }
+    }
+}
+
+// 按行分组矩形：每组记录与之相交的矩形下标
+void FillShape::ensureGeometry() const {
+    if (geometryValid) return;
+
+    bands = QVector<QVector<int>>((bounds.height() + BandHeight - 1) / BandHeight);
+    for (int i = 0; i < rects.size(); ++i) {
+        int first = (rects[i].top() - bounds.top()) / BandHeight;
+        int last = (rects[i].bottom() - bounds.top()) / BandHeight;
+        for (int band = first; band <= last; ++band) {
+            bands[band].append(i);
+        }
+    }
+    geometryValid = true;
+}
+
+// 命中测试：只检查点所在行组中的矩形，包围矩形内未填充的空洞不算
+bool FillShape::contains(const QPoint& point) const {
+    if (!bounds.contains(point)) return false;
+    ensureGeometry();
+
+    for (int index : bands[(point.y() - bounds.top()) / BandHeight]) {
+        if (rects[index].contains(point)) return true;
+    }
+    return false;
+}
+
+// 区域的包围矩形
+QRect FillShape::boundingRect() const {
+    return bounds;
+}
+
+// 平移所有矩形
+void FillShape::translate(const QPoint& delta) {
+    Shape::translate(delta);
+    for (QRect& rect : rects) {
+        rect.translate(delta);
+    }
+    bounds.translate(delta);
+}
+
+// 克隆填充区域：矩形列表隐式共享，不复制
+ShapeHandle FillShape::clone() const {
+    return ShapeFactory::copy(*this);
+}
+
+// 清空区域
+void FillShape::reset(const QPoint& start, const QColor& color, int width) {
+    Shape::reset(start, color, width);
+    rects.clear();
+    bounds = QRect();
+    bands.clear();
+}
+
+// 设置填充区域并重新计算包围矩形
+void FillShape::setRegion(const QVector<QRect>& newRects) {
+    rects = newRects;
+    bounds = QRect();
+    for (const QRect& rect : std::as_const(rects)) {
+        bounds = bounds.united(rect);
+    }
+    geometryValid = false;
+}
+
+// 写入区域的矩形
+void FillShape::write(QDataStream& out) const {
+    Shape::write(out);
+    out << rects;
+}
+
+// 读取区域的矩形
+bool FillShape::read(QDataStream& in) {
+    if (!Shape::read(in)) return false;
+    QVector<QRect> loaded;
+    in >> loaded;
+    if (in.status() != QDataStream::Ok) return false;
+    setRegion(loaded);
+    return true;
 }
@@ -3,9 +3,24 @@
 
 #include <QPoint>
 #include <QColor>
+#include <QDataStream>
 #include <QPainter>
+#include <QLine>
 #include <QRect>
 #include <QVector>
+#include <QPainterPath>
+#include <memory>
+
+class Shape;
+
+/**
+ * @brief ShapeHandle的删除器：把形状放回ShapeFactory的对象池而不是删除
+ */
+struct ShapeRecycler {
+    void operator()(Shape *shape) const;
+};
+
+typedef std::unique_ptr<Shape, ShapeRecycler> ShapeHandle;  // 独占持有的形状，释放时回到对象池
 
 /**
  * @brief 形状基类，定义所有形状的通用接口和属性
@@ -25,13 +40,111 @@ public:
     virtual void draw(QPainter& painter) const = 0;  // 绘制形状
     virtual QRect boundingRect() const;  // 计算边界矩形
     virtual void update(const QPoint& toPoint);  // 更新终点坐标
-    virtual Shape* clone() const = 0;  // 克隆形状
+    virtual void translate(const QPoint& delta);  // 整体平移形状
+    virtual ShapeHandle clone() const = 0;  // 克隆形状(副本来自对象池)
+
+    /**
+     * @brief 把形状重置为刚构造时的状态，对象池复用对象时调用
+     * @param start 起点坐标
+     * @param color 颜色
+     * @param width 画笔宽度
+     */
+    virtual void reset(const QPoint& start, const QColor& color, int width);
+
+    int type() const { return shapeType; }  // 创建时使用的形状类型(不是由ShapeFactory::create创建时为-1)
+    void setType(int type) { shapeType = type; }  // 设置形状类型(由ShapeFactory::create调用)
+
+    /**
+     * @brief 把形状写入工程文件
+     * @param out 数据流；基类写入起点、终点、颜色和宽度，子类在其后追加自己的数据
+     */
+    virtual void write(QDataStream& out) const;
+
+    /**
+     * @brief 读取write()写入的内容
+     * @param in 数据流
+     * @return 数据不完整时返回false
+     */
+    virtual bool read(QDataStream& in);
+
+    /**
+     * @brief 获取形状实际绘制所覆盖的区域
+     * @return 边界矩形向外扩展画笔宽度后的矩形，用于局部刷新
+     */
+    QRect paintRect() const;
+
+    static const int HitMargin = 2;  // 命中测试时线条两侧额外容许的像素
+
+    /**
+     * @brief 命中测试：点是否落在形状实际绘制的像素上
+     * @param point 画布坐标
+     * @return 默认按绘制区域判断，子类按填充区域或描边轮廓(加宽HitMargin)精确判断
+     */
+    virtual bool contains(const QPoint& point) const;
+
+    /**
+     * @brief 是否支持增量绘制
+     * @return 支持时预览只需追加绘制新增部分，无需每帧完整重绘
+     */
+    virtual bool isIncremental() const { return false; }
+
+    /**
+     * @brief 获取上次增量绘制之后新增部分所占的区域(含画笔宽度)
+     */
+    virtual QRect pendingRect() const;
+
+    /**
+     * @brief 增量绘制：只绘制上次增量绘制之后新增的部分
+     * @param painter 绘制到持久缓冲区的绘制器，缓冲区中保留之前绘制的内容
+     *
+     * 分块画布会对每个受影响的图块各调用一次，全部图块画完后再调用markDrawn()。
+     */
+    virtual void drawPending(QPainter& painter) const;
+
+    /**
+     * @brief 把当前内容标记为已经增量绘制
+     */
+    virtual void markDrawn() {}
+
+    /**
+     * @brief 重置增量绘制进度，下次增量绘制将从头开始
+     */
+    virtual void resetIncremental() {}
+
+    /**
+     * @brief 获取上次markDrawn()时尚未固定、不写入持久缓冲区的部分所占的区域(含画笔宽度)
+     * @return 默认没有浮动部分，返回空矩形
+     */
+    virtual QRect floatingRect() const { return QRect(); }
+
+    /**
+     * @brief 绘制上次markDrawn()时尚未固定的部分，每帧直接画在持久缓冲区之上
+     * @param painter 窗口绘制器，已变换到画布坐标
+     */
+    virtual void drawFloating(QPainter& painter) const { Q_UNUSED(painter); }
 
 protected:
+    /**
+     * @brief 构建画笔，样式改变后第一次绘制时调用一次，结果缓存在pen()中
+     * @return 默认为指定颜色和宽度的实线画笔，子类覆盖以设置线帽和连接样式
+     */
+    virtual QPen createPen() const;
+    const QPen& pen() const;  // 缓存的画笔
+    const QBrush& brush() const;  // 缓存的填充画刷(画笔颜色)
+    bool outlineContains(const QPainterPath& path, const QPoint& point) const;  // 点是否在按画笔描边(加宽HitMargin)的轮廓内
+    void invalidateStyle() { styleValid = false; }  // 样式改变后调用，下次绘制时重建画笔和画刷
+
     QPoint startPoint;  // 起点坐标
     QPoint endPoint;  // 终点坐标
     QColor penColor;  // 画笔颜色
     int penWidth;  // 画笔宽度
+    mutable bool geometryValid;  // 子类缓存的几何是否有效，端点移动或重置后置为false
+
+private:
+    int shapeType;  // 形状类型
+    mutable QPen cachedPen;  // 画笔缓存
+    mutable QBrush cachedBrush;  // 画刷缓存
+    mutable bool styleValid;  // 画笔和画刷缓存是否有效
 };
 
 /**
@@ -41,7 +154,11 @@ class LineShape : public Shape {
 public:
     LineShape(const QPoint& start, const QColor& color, int width);
     void draw(QPainter& painter) const override;  // 绘制直线
-    Shape* clone() const override;  // 克隆直线
+    bool contains(const QPoint& point) const override;  // 点是否在线条上
+    ShapeHandle clone() const override;  // 克隆直线
+
+protected:
+    QPen createPen() const override;  // 圆角线帽
 };
 
 /**
@@ -51,7 +168,11 @@ class RectangleShape : public Shape {
 public:
     RectangleShape(const QPoint& start, const QColor& color, int width);
     void draw(QPainter& painter) const override;  // 绘制矩形
-    Shape* clone() const override;  // 克隆矩形
+    bool contains(const QPoint& point) const override;  // 点是否在矩形或其边框内
+    ShapeHandle clone() const override;  // 克隆矩形
+
+protected:
+    QPen createPen() const override;  // 圆角连接
 };
 
 /**
@@ -61,7 +182,8 @@ class EllipseShape : public Shape {
 public:
     EllipseShape(const QPoint& start, const QColor& color, int width);
     void draw(QPainter& painter) const override;  // 绘制椭圆
-    Shape* clone() const override;  // 克隆椭圆
+    bool contains(const QPoint& point) const override;  // 点是否在椭圆或其边框内
+    ShapeHandle clone() const override;  // 克隆椭圆
 };
 
 /**
@@ -71,7 +193,18 @@ class ArrowShape : public Shape {
 public:
     ArrowShape(const QPoint& start, const QColor& color, int width);
     void draw(QPainter& painter) const override;  // 绘制箭头
-    Shape* clone() const override;  // 克隆箭头
+    QRect boundingRect() const override;  // 计算包含箭头头部的边界矩形
+    bool contains(const QPoint& point) const override;  // 点是否在箭头杆或分支上
+    ShapeHandle clone() const override;  // 克隆箭头
+
+protected:
+    QPen createPen() const override;  // 圆角线帽
+
+private:
+    void ensureGeometry() const;  // 几何缓存失效时重新计算箭头杆和两个分支
+
+    mutable QLineF lines[3];  // 箭头杆和两个分支线段
+    mutable QRect headBounds;  // 两个分支点的包围矩形
 };
 
 /**
@@ -81,7 +214,13 @@ class StarShape : public Shape {
 public:
     StarShape(const QPoint& start, const QColor& color, int width);
     void draw(QPainter& painter) const override;  // 绘制五角星
-    Shape* clone() const override;  // 克隆五角星
+    bool contains(const QPoint& point) const override;  // 点是否在五角星或其边框内
+    ShapeHandle clone() const override;  // 克隆五角星
+
+private:
+    void ensureGeometry() const;  // 几何缓存失效时重建五角星路径
+
+    mutable QPainterPath path;  // 五角星路径缓存
 };
 
 /**
@@ -91,7 +230,13 @@ class DiamondShape : public Shape {
 public:
     DiamondShape(const QPoint& start, const QColor& color, int width);
     void draw(QPainter& painter) const override;  // 绘制菱形
-    Shape* clone() const override;  // 克隆菱形
+    bool contains(const QPoint& point) const override;  // 点是否在菱形或其边框内
+    ShapeHandle clone() const override;  // 克隆菱形
+
+private:
+    void ensureGeometry() const;  // 几何缓存失效时重建菱形顶点
+
+    mutable QPolygon polygon;  // 菱形四个顶点缓存
 };
 
 /**
@@ -101,7 +246,15 @@ class HeartShape : public Shape {
 public:
     HeartShape(const QPoint& start, const QColor& color, int width);
     void draw(QPainter& painter) const override;  // 绘制心形
-    Shape* clone() const override;  // 克隆心形
+    QRect boundingRect() const override;  // 计算心形路径的边界矩形
+    bool contains(const QPoint& point) const override;  // 点是否在心形内
+    ShapeHandle clone() const override;  // 克隆心形
+
+private:
+    void ensureGeometry() const;  // 几何缓存失效时重建心形路径
+
+    mutable QPainterPath path;  // 心形路径缓存
+    mutable QRect pathBounds;  // 心形路径控制点的包围矩形
 };
 
 /**
@@ -119,12 +272,91 @@ public:
     PathShape(const QPoint& start, const QColor& color, int width, bool isEraser = false);
     void draw(QPainter& painter) const override;  // 绘制路径
     void update(const QPoint& toPoint) override;  // 更新路径点
+    void translate(const QPoint& delta) override;  // 平移所有路径点
     QRect boundingRect() const override;  // 计算路径边界矩形
-    Shape* clone() const override;  // 克隆路径
+    bool contains(const QPoint& point) const override;  // 点是否在笔画上
+    ShapeHandle clone() const override;  // 克隆路径
+
+    bool isIncremental() const override { return true; }  // 路径只会追加点
+    QRect pendingRect() const override;  // 新增的固定线段所占区域
+    void drawPending(QPainter& painter) const override;  // 只绘制新增的固定线段
+    void markDrawn() override;  // 记录已绘制的点数和当前的浮动末段
+    void resetIncremental() override;  // 重置增量绘制进度
+    QRect floatingRect() const override;  // 浮动末段所占区域
+    void drawFloating(QPainter& painter) const override;  // 绘制浮动末段
+    void reset(const QPoint& start, const QColor& color, int width) override;  // 清空路径点(保留缓冲区容量)
+    void write(QDataStream& out) const override;  // 追加写入路径点和绘制选项
+    bool read(QDataStream& in) override;  // 读取路径点和绘制选项
+    void setEraser(bool isEraser) { eraser = isEraser; invalidateStyle(); }  // 设置是否为橡皮擦模式
+
+    /**
+     * @brief 设置在线简化的容差
+     * @param tolerance 像素容差，新采样点与被省略的点到线段的距离都不超过它时只移动末点；
+     *        0表示保留每个采样点。只影响之后追加的点
+     */
+    void setTolerance(qreal tolerance) { this->tolerance = tolerance; }
+    qreal simplifyTolerance() const { return tolerance; }  // 获取简化容差
+
+    /**
+     * @brief 设置是否平滑
+     * @param smooth true时按Catmull-Rom样条把路径点连成三次贝塞尔曲线，否则连成折线
+     */
+    void setSmoothing(bool smooth);
+    bool isSmoothing() const { return smooth; }  // 是否平滑
+
+    int pointCount() const { return points.size(); }  // 保留的路径点数
+
+protected:
+    QPen createPen() const override;  // 路径使用的画笔
 
 private:
+    bool withinTolerance(const QPoint& anchor, const QPoint& toPoint) const;  // 被省略的点是否都在容差内
+    int fixedPoints() const;  // 已固定的点数(开启简化时末点是浮动的，不计入)
+    const QPainterPath& smoothPath() const;  // 平滑后的路径(缓存到路径点改变为止)
+
     QVector<QPoint> points;  // 路径点集合
     bool eraser;  // 是否为橡皮擦模式
+    QRect pointBounds;  // 所有路径点的包围矩形(随点追加增量维护)
+    int drawnPoints;  // 已经增量绘制过的点数
+    QLine floating;  // 上次markDrawn()时的浮动末段
+    bool hasFloating;  // 上次markDrawn()时是否有浮动末段
+
+    qreal tolerance;  // 在线简化容差(像素)
+    bool smooth;  // 是否平滑
+    QVector<QPoint> skipped;  // 自最后一个固定点以来的采样点，末点可被后续采样替换
+    mutable QPainterPath smoothed;  // 平滑路径缓存(为空表示需要重建)
+};
+
+/**
+ * @brief 填充区域形状，用于油漆桶
+ *
+ * 区域是扫描线填充得到的一组互不重叠的矩形(见FloodFill)。矩形从包围矩形顶部起每BandHeight行
+ * 分为一组，组的边界随区域而定，不与画布图块对齐。分块画布逐图块重绘时按裁剪范围只填充相交
+ * 各组中的矩形，一个图块最多跨两组，开销与区域的总大小无关。
+ */
+class FillShape : public Shape {
+public:
+    FillShape(const QPoint& start, const QColor& color, int width);
+    void draw(QPainter& painter) const override;  // 用画笔颜色填充区域
+    QRect boundingRect() const override;  // 区域的包围矩形
+    bool contains(const QPoint& point) const override;  // 点是否在区域的某个矩形内
+    void translate(const QPoint& delta) override;  // 平移整个区域
+    ShapeHandle clone() const override;  // 克隆填充区域
+    void reset(const QPoint& start, const QColor& color, int width) override;  // 清空区域
+    void write(QDataStream& out) const override;  // 追加写入区域的矩形
+    bool read(QDataStream& in) override;  // 读取区域的矩形
+
+    void setRegion(const QVector<QRect>& newRects);  // 设置填充区域(互不重叠的矩形)
+    const QVector<QRect>& region() const { return rects; }  // 填充区域
+
+private:
+    static const int BandHeight = 128;  // 分组的行数(与图块同高，但从包围矩形顶部起算)
+
+    void ensureGeometry() const;  // 几何缓存失效时按行分组矩形
+
+    QVector<QRect> rects;  // 区域的矩形
+    QRect bounds;  // 所有矩形的包围矩形
+    mutable QVector<QVector<int>> bands;  // 从包围矩形顶部起每BandHeight行相交的矩形下标
 };
 
 #endif // SHAPES_H
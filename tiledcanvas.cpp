@@ -0,0 +1,320 @@
+#include "tiledcanvas.h"
+#include <QHash>
+#include <atomic>
+#include <cstring>
+
+namespace {
+
+std::atomic<quint64> nextRevision(0);  // 全局修订号计数器，不同画布(包括工作线程中的)之间也不会重复
+
+} // namespace
+
+// 构造空画布
+TiledCanvas::TiledCanvas()
+    : cols(0), rowCount(0) {}
+
+// 构造指定尺寸的透明画布，不分配任何图块
+TiledCanvas::TiledCanvas(const QSize &size)
+    : cols(0), rowCount(0)
+{
+    resize(size);
+}
+
+// 图块在画布中的矩形
+QRect TiledCanvas::tileRect(int index) const
+{
+    return QRect((index % cols) * TileSize, (index / cols) * TileSize, TileSize, TileSize);
+}
+
+// 与区域相交的图块下标(按行优先顺序)
+QVector<int> TiledCanvas::tilesIn(const QRect &area) const
+{
+    QVector<int> indices;
+    QRect clipped = area.intersected(rect());
+    if (clipped.isEmpty()) return indices;
+
+    int firstCol = clipped.left() / TileSize;
+    int lastCol = clipped.right() / TileSize;
+    int firstRow = clipped.top() / TileSize;
+    int lastRow = clipped.bottom() / TileSize;
+    indices.reserve((lastCol - firstCol + 1) * (lastRow - firstRow + 1));
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int col = firstCol; col <= lastCol; ++col) {
+            indices.append(row * cols + col);
+        }
+    }
+    return indices;
+}
+
+// 替换图块
+void TiledCanvas::setTile(int index, const QImage &tileImage)
+{
+    tiles[index] = tileImage;
+    markDirty(index);
+}
+
+// 改变画布尺寸，保留重叠部分的内容
+void TiledCanvas::resize(const QSize &size)
+{
+    QSize newSize = size.isValid() ? size : QSize(0, 0);
+    int newCols = (newSize.width() + TileSize - 1) / TileSize;
+    int newRows = (newSize.height() + TileSize - 1) / TileSize;
+
+    QVector<QImage> newTiles(newCols * newRows);
+    for (int row = 0; row < qMin(rowCount, newRows); ++row) {
+        for (int col = 0; col < qMin(cols, newCols); ++col) {
+            newTiles[row * newCols + col] = tiles[row * cols + col];
+        }
+    }
+
+    bool shrunk = newSize.width() < canvasSize.width() || newSize.height() < canvasSize.height();
+    canvasSize = newSize;
+    cols = newCols;
+    rowCount = newRows;
+    tiles = newTiles;
+
+    // 图块下标随列数改变，重建写入记录和哈希缓存；保留下来的图块都记为被写过，
+    // 这样先缩小再放大回原尺寸时被裁掉的内容也能被历史发现
+    dirty.clear();
+    dirtyFlags = QBitArray(tiles.size());
+    hashes = QVector<quint64>(tiles.size(), 0);
+    revisions = QVector<quint64>(tiles.size(), 0);
+    for (int index = 0; index < tiles.size(); ++index) {
+        if (!tiles[index].isNull()) markDirty(index);
+    }
+
+    // 缩小时裁掉边缘图块中超出画布的部分，与QImage裁剪后再放大的行为一致
+    if (shrunk) {
+        clearOutside();
+    }
+}
+
+// 释放所有图块
+void TiledCanvas::clear()
+{
+    for (int index = 0; index < tiles.size(); ++index) {
+        if (!tiles[index].isNull()) {
+            tiles[index] = QImage();
+            markDirty(index);
+        }
+    }
+}
+
+// 把区域清为透明
+void TiledCanvas::clearRect(const QRect &area)
+{
+    QRect clip = area.intersected(rect());
+    if (clip.isEmpty()) return;
+
+    for (int index : tilesIn(clip)) {
+        if (tiles[index].isNull()) continue;
+
+        markDirty(index);
+        QRect tileArea = tileRect(index);
+        // 整个图块(画布内的部分)都被清空时直接释放
+        if (clip.contains(tileArea.intersected(rect()))) {
+            tiles[index] = QImage();
+            continue;
+        }
+
+        QRect local = clip.intersected(tileArea).translated(-tileArea.topLeft());
+        QImage &target = tiles[index];
+        for (int y = local.top(); y <= local.bottom(); ++y) {
+            std::memset(target.scanLine(y) + local.left() * 4, 0, local.width() * 4);
+        }
+    }
+}
+
+// 把图像直接写入画布，覆盖原有像素
+void TiledCanvas::writeImage(const QPoint &pos, const QImage &source)
+{
+    QImage image = source.format() == QImage::Format_ARGB32_Premultiplied ?
+                       source : source.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    QRect area = QRect(pos, image.size()).intersected(rect());
+    if (area.isEmpty()) return;
+
+    for (int index : tilesIn(area)) {
+        QRect tileArea = tileRect(index);
+        QRect part = area.intersected(tileArea);
+        QRect local = part.translated(-tileArea.topLeft());
+        QPoint sourceOrigin = part.topLeft() - pos;
+
+        // 写入全透明内容到未分配的图块时无需分配
+        if (tiles[index].isNull()) {
+            bool empty = true;
+            for (int y = 0; y < part.height() && empty; ++y) {
+                const quint32 *line = reinterpret_cast<const quint32 *>(
+                    image.constScanLine(sourceOrigin.y() + y)) + sourceOrigin.x();
+                for (int x = 0; x < part.width(); ++x) {
+                    if (line[x] != 0) {
+                        empty = false;
+                        break;
+                    }
+                }
+            }
+            if (empty) continue;
+            tiles[index] = createTile();
+        }
+        markDirty(index);
+
+        QImage &target = tiles[index];
+        for (int y = 0; y < part.height(); ++y) {
+            std::memcpy(target.scanLine(local.top() + y) + local.left() * 4,
+                        image.constScanLine(sourceOrigin.y() + y) + sourceOrigin.x() * 4,
+                        part.width() * 4);
+        }
+    }
+}
+
+// 把区域复制为连续图像，未分配的图块为透明
+QImage TiledCanvas::toImage(const QRect &area) const
+{
+    QRect clip = area.intersected(rect());
+    QImage result(area.size(), QImage::Format_ARGB32_Premultiplied);
+    result.fill(Qt::transparent);
+    if (clip.isEmpty()) return result;
+
+    for (int index : tilesIn(clip)) {
+        const QImage &source = tiles.at(index);
+        if (source.isNull()) continue;
+
+        QRect tileArea = tileRect(index);
+        QRect part = clip.intersected(tileArea);
+        QPoint local = part.topLeft() - tileArea.topLeft();
+        QPoint target = part.topLeft() - area.topLeft();
+        for (int y = 0; y < part.height(); ++y) {
+            std::memcpy(result.scanLine(target.y() + y) + target.x() * 4,
+                        source.constScanLine(local.y() + y) + local.x() * 4,
+                        part.width() * 4);
+        }
+    }
+    return result;
+}
+
+// 被写过的图块的包围矩形
+QRect TiledCanvas::dirtyRect() const
+{
+    QRect bounds;
+    for (int index : dirty) {
+        bounds = bounds.united(tileRect(index));
+    }
+    return bounds.intersected(rect());
+}
+
+// 清除写入记录
+void TiledCanvas::clearDirty()
+{
+    for (int index : dirty) {
+        dirtyFlags.clearBit(index);
+    }
+    dirty.clear();
+}
+
+// 图块内容的哈希，结果缓存到图块下一次被写入
+quint64 TiledCanvas::tileHash(int index) const
+{
+    const QImage &tileImage = tiles.at(index);
+    if (tileImage.isNull()) return 0;
+
+    if (hashes.at(index) == 0) {
+        quint64 hash = qHashBits(tileImage.constBits(), tileImage.sizeInBytes(), 0x9e3779b9u);
+        hashes[index] = hash ? hash : 1;  // 0保留给未计算和未分配
+    }
+    return hashes.at(index);
+}
+
+// 整个画布内容的哈希：尺寸与各个已分配图块的哈希依次组合
+quint64 TiledCanvas::contentHash() const
+{
+    quint64 hash = qHash(canvasSize.width()) * 31 + qHash(canvasSize.height());
+    for (int index = 0; index < tiles.size(); ++index) {
+        if (tiles.at(index).isNull()) continue;
+        hash = hash * 1099511628211ULL ^ (static_cast<quint64>(index) << 32 ^ tileHash(index));
+    }
+    return hash;
+}
+
+// 已分配的图块数
+int TiledCanvas::allocatedTiles() const
+{
+    int count = 0;
+    for (const QImage &tileImage : tiles) {
+        if (!tileImage.isNull()) ++count;
+    }
+    return count;
+}
+
+// 已分配图块占用的字节数
+qint64 TiledCanvas::allocatedBytes() const
+{
+    return static_cast<qint64>(allocatedTiles()) * TileSize * TileSize * 4;
+}
+
+// 创建一个透明图块
+QImage TiledCanvas::createTile()
+{
+    QImage tileImage(TileSize, TileSize, QImage::Format_ARGB32_Premultiplied);
+    tileImage.fill(Qt::transparent);
+    return tileImage;
+}
+
+// 图块是否全透明(预乘格式下透明像素的值为0)
+bool TiledCanvas::isTransparent(const QImage &tileImage)
+{
+    const int words = tileImage.bytesPerLine() / 4;
+    for (int y = 0; y < tileImage.height(); ++y) {
+        const quint32 *line = reinterpret_cast<const quint32 *>(tileImage.constScanLine(y));
+        for (int x = 0; x < words; ++x) {
+            if (line[x] != 0) return false;
+        }
+    }
+    return true;
+}
+
+// 供新图块试绘的透明缓冲
+QImage &TiledCanvas::scratchTile()
+{
+    if (scratch.isNull()) {
+        scratch = createTile();
+    }
+    return scratch;
+}
+
+// 记录图块被写入，并使其哈希失效
+void TiledCanvas::markDirty(int index)
+{
+    hashes[index] = 0;
+    revisions[index] = ++nextRevision;
+    if (!dirtyFlags.testBit(index)) {
+        dirtyFlags.setBit(index);
+        dirty.append(index);
+    }
+}
+
+// 清除边缘图块中超出画布范围的像素
+void TiledCanvas::clearOutside()
+{
+    int extraX = cols * TileSize - canvasSize.width();
+    int extraY = rowCount * TileSize - canvasSize.height();
+
+    if (extraX > 0) {
+        for (int row = 0; row < rowCount; ++row) {
+            int index = row * cols + cols - 1;
+            if (tiles[index].isNull()) continue;
+            QImage &target = tiles[index];
+            for (int y = 0; y < TileSize; ++y) {
+                std::memset(target.scanLine(y) + (TileSize - extraX) * 4, 0, extraX * 4);
+            }
+        }
+    }
+    if (extraY > 0) {
+        for (int col = 0; col < cols; ++col) {
+            int index = (rowCount - 1) * cols + col;
+            if (tiles[index].isNull()) continue;
+            QImage &target = tiles[index];
+            for (int y = TileSize - extraY; y < TileSize; ++y) {
+                std::memset(target.scanLine(y), 0, TileSize * 4);
+            }
+        }
+    }
+}
@@ -0,0 +1,120 @@
+#ifndef TILEDCANVAS_H
+#define TILEDCANVAS_H
+
+#include <QBitArray>
+#include <QImage>
+#include <QPainter>
+#include <QRect>
+#include <QSize>
+#include <QVector>
+
+/**
+ * @brief 稀疏分块画布
+ *
+ * 画布被划分为固定大小的图块，图块在第一次写入时才分配，未分配的区域视为全透明，
+ * 因此内存只与实际绘制过的面积有关，而与画布尺寸无关。
+ * 图块是隐式共享的QImage，复制画布只增加引用计数，写入时才复制被修改的图块。
+ * 画布记录自上次clearDirty()以来被写过的图块，历史记录只需检查这些图块。
+ * 每个图块还有一个修订号，每次写入都分配全局唯一的新值，缓存(如缩小的显示层级)据此判断图块是否变化。
+ */
+class TiledCanvas {
+public:
+    static const int TileSize = 128;  // 图块边长(像素)
+
+    TiledCanvas();
+    explicit TiledCanvas(const QSize &size);
+
+    QSize size() const { return canvasSize; }  // 画布尺寸
+    QRect rect() const { return QRect(QPoint(0, 0), canvasSize); }  // 画布矩形
+    int width() const { return canvasSize.width(); }  // 画布宽度
+    int height() const { return canvasSize.height(); }  // 画布高度
+    bool isNull() const { return canvasSize.isEmpty(); }  // 是否为空画布
+
+    int columns() const { return cols; }  // 图块列数
+    int rows() const { return rowCount; }  // 图块行数
+    int tileCount() const { return tiles.size(); }  // 图块总数
+    QRect tileRect(int index) const;  // 图块在画布中的矩形(总是完整的图块大小)
+    QVector<int> tilesIn(const QRect &area) const;  // 与区域相交的图块下标
+
+    QImage tile(int index) const { return tiles.at(index); }  // 获取图块(未分配时为空图像)
+    bool hasTile(int index) const { return !tiles.at(index).isNull(); }  // 图块是否已分配
+    void setTile(int index, const QImage &tileImage);  // 替换图块(空图像表示释放)
+
+    void resize(const QSize &size);  // 改变画布尺寸，保留重叠部分的内容
+    void clear();  // 释放所有图块
+    void clearRect(const QRect &area);  // 把区域清为透明，整块被清空的图块直接释放
+
+    /**
+     * @brief 在区域内绘制：对每个相交的图块设置好平移和裁剪后调用draw(painter, tileClip)
+     * @param area 绘制可能影响的区域(画布坐标)
+     * @param draw 绘制函数，tileClip为当前图块内需要绘制的画布坐标区域
+     *
+     * 新分配的图块在绘制后如果仍然全透明会被丢弃，避免大包围盒分配大量空图块。
+     */
+    template<typename Draw>
+    void paint(const QRect &area, Draw draw);
+
+    void writeImage(const QPoint &pos, const QImage &source);  // 把图像直接写入画布(覆盖原有像素)
+    QImage toImage(const QRect &area) const;  // 把区域复制为连续图像
+    QImage toImage() const { return toImage(rect()); }  // 把整个画布复制为连续图像
+
+    QVector<int> dirtyTiles() const { return dirty; }  // 自上次清除以来被写过的图块下标
+    QRect dirtyRect() const;  // 被写过的图块的包围矩形
+    bool isDirty() const { return !dirty.isEmpty(); }  // 是否有图块被写过
+    void clearDirty();  // 清除写入记录(通常在历史记录之后调用)
+
+    quint64 tileHash(int index) const;  // 图块内容的哈希(缓存到图块被写入为止，未分配为0)
+    quint64 revision(int index) const { return revisions.at(index); }  // 图块的修订号(从未写入过为0)
+    quint64 contentHash() const;  // 整个画布内容的哈希
+
+    int allocatedTiles() const;  // 已分配的图块数
+    qint64 allocatedBytes() const;  // 已分配图块占用的字节数
+
+    static QImage createTile();  // 创建一个透明图块
+    static bool isTransparent(const QImage &tileImage);  // 图块是否全透明
+
+private:
+    QImage &scratchTile();  // 供新图块试绘的透明缓冲
+    void markDirty(int index);  // 记录图块被写入，并使其哈希失效
+    void clearOutside();  // 清除边缘图块中超出画布范围的像素
+
+    QSize canvasSize;  // 画布尺寸
+    int cols;  // 图块列数
+    int rowCount;  // 图块行数
+    QVector<QImage> tiles;  // 按行存放的图块，未分配为空图像
+    QImage scratch;  // 试绘缓冲(保持全透明)
+    QVector<int> dirty;  // 被写过的图块下标
+    QBitArray dirtyFlags;  // 图块是否已在dirty中
+    mutable QVector<quint64> hashes;  // 图块哈希缓存(0表示尚未计算)
+    QVector<quint64> revisions;  // 图块修订号(复制画布时一并复制，内容相同的图块修订号相同)
+};
+
+template<typename Draw>
+void TiledCanvas::paint(const QRect &area, Draw draw)
+{
+    QRect clip = area.intersected(rect());
+    if (clip.isEmpty()) return;
+
+    for (int index : tilesIn(clip)) {
+        QRect tileArea = tileRect(index);
+        QRect tileClip = clip.intersected(tileArea);
+        bool fresh = tiles[index].isNull();
+        QImage &target = fresh ? scratchTile() : tiles[index];
+
+        markDirty(index);
+        {
+            QPainter painter(&target);
+            painter.translate(-tileArea.topLeft());
+            painter.setClipRect(tileClip);
+            draw(painter, tileClip);
+        }
+
+        // 新图块确实被画上内容才保留，否则试绘缓冲仍然透明可以继续复用
+        if (fresh && !isTransparent(target)) {
+            tiles[index] = target;
+            scratch = QImage();
+        }
+    }
+}
+
+#endif // TILEDCANVAS_H
@@ -0,0 +1,216 @@
+#include "tilehistory.h"
+#include <cstring>
+
+// 构造函数
+TileHistory::TileHistory(int tileSize, qint64 byteBudget)
+    : tile(tileSize), budget(byteBudget), used(0), hashing(false) {}
+
+// 以当前图像作为初始状态，清空所有历史
+void TileHistory::reset(const QImage &background, TiledCanvas &drawing)
+{
+    // 隐式共享，图像之后被修改时才复制
+    baseBackground = background;
+    drawing.clearDirty();
+    baseDrawing = drawing;
+    undoEntries.clear();
+    redoEntries.clear();
+    used = 0;
+}
+
+// 记录当前图像相对上一次状态的变化
+bool TileHistory::commit(const QImage &background, TiledCanvas &drawing,
+                         HistoryCommand *command)
+{
+    Entry entry{};
+    entry.command = QSharedPointer<HistoryCommand>(command);
+    diffBackground(background, entry);
+    diffDrawing(drawing, entry);
+
+    // 没有任何变化则不产生历史记录
+    if (entry.tiles.isEmpty() && entry.canvasTiles.isEmpty() && !entry.backgroundReplaced &&
+        !entry.drawingReplaced && !entry.command) {
+        return false;
+    }
+
+    undoEntries.append(entry);
+    used += entry.bytes;
+
+    // 新操作使重做记录失效
+    for (const Entry &redoEntry : redoEntries) {
+        used -= redoEntry.bytes;
+    }
+    redoEntries.clear();
+
+    enforceBudget();
+    return true;
+}
+
+// 撤销一步
+bool TileHistory::undo(QImage &background, TiledCanvas &drawing, Scene &scene)
+{
+    if (undoEntries.isEmpty()) return false;
+
+    Entry entry = undoEntries.takeLast();
+    apply(entry, false, background, drawing);
+    if (entry.command) {
+        entry.command->revertScene(scene);
+    }
+    redoEntries.append(entry);
+    return true;
+}
+
+// 重做一步
+bool TileHistory::redo(QImage &background, TiledCanvas &drawing, Scene &scene)
+{
+    if (redoEntries.isEmpty()) return false;
+
+    Entry entry = redoEntries.takeLast();
+    apply(entry, true, background, drawing);
+    if (entry.command) {
+        entry.command->applyScene(scene);
+    }
+    undoEntries.append(entry);
+    return true;
+}
+
+// 设置内存预算
+void TileHistory::setByteBudget(qint64 bytes)
+{
+    budget = bytes;
+    enforceBudget();
+}
+
+// 按图块比较背景平面，只保存发生变化的图块
+void TileHistory::diffBackground(const QImage &background, Entry &entry)
+{
+    // 基准与背景共享同一份数据，说明背景没有被替换或修改
+    if (background.constBits() == baseBackground.constBits() &&
+        background.size() == baseBackground.size()) {
+        return;
+    }
+
+    // 尺寸或格式变化(如加载新图像)时无法按图块比较，整体替换
+    if (background.size() != baseBackground.size() || background.format() != baseBackground.format()) {
+        entry.backgroundReplaced = true;
+        entry.backgroundBefore = baseBackground;
+        entry.backgroundAfter = background;
+        entry.bytes += imageBytes(entry.backgroundBefore) + imageBytes(entry.backgroundAfter);
+        baseBackground = background;
+        return;
+    }
+
+    for (int y = 0; y < background.height(); y += tile) {
+        for (int x = 0; x < background.width(); x += tile) {
+            QRect rect = QRect(x, y, tile, tile).intersected(background.rect());
+            if (tileEquals(baseBackground, background, rect)) continue;
+
+            TilePatch patch{rect.topLeft(), baseBackground.copy(rect), background.copy(rect)};
+            entry.bytes += imageBytes(patch.before) + imageBytes(patch.after);
+            entry.tiles.append(patch);
+        }
+    }
+    baseBackground = background;  // 同步更新基准状态
+}
+
+// 只比较画布记录的被写过的图块，变化前后的图块直接共享而不复制
+void TileHistory::diffDrawing(TiledCanvas &drawing, Entry &entry)
+{
+    if (drawing.size() != baseDrawing.size()) {
+        entry.drawingReplaced = true;
+        entry.drawingBefore = baseDrawing;
+        entry.drawingAfter = drawing;
+        entry.bytes += baseDrawing.allocatedBytes() + drawing.allocatedBytes();
+    } else {
+        for (int index : drawing.dirtyTiles()) {
+            if (canvasTileEquals(drawing, index)) continue;
+
+            CanvasPatch patch{index, baseDrawing.tile(index), drawing.tile(index)};
+            entry.bytes += imageBytes(patch.before) + imageBytes(patch.after);
+            entry.canvasTiles.append(patch);
+        }
+    }
+
+    drawing.clearDirty();
+    baseDrawing = drawing;
+}
+
+// 把一步记录应用到图像上：forward为true时写入变化后的内容，否则写入变化前的内容
+// 图像与基准状态在上次记录后保持一致(或只改变了尺寸)，因此直接修改基准后共享给图像
+void TileHistory::apply(const Entry &entry, bool forward, QImage &background, TiledCanvas &drawing)
+{
+    if (entry.backgroundReplaced) {
+        baseBackground = forward ? entry.backgroundAfter : entry.backgroundBefore;
+    }
+    for (const TilePatch &patch : entry.tiles) {
+        writeTile(baseBackground, forward ? patch.after : patch.before, patch.pos);
+    }
+    background = baseBackground;
+
+    if (entry.drawingReplaced) {
+        baseDrawing = forward ? entry.drawingAfter : entry.drawingBefore;
+    }
+    for (const CanvasPatch &patch : entry.canvasTiles) {
+        baseDrawing.setTile(patch.index, forward ? patch.after : patch.before);
+    }
+    baseDrawing.clearDirty();
+    drawing = baseDrawing;
+}
+
+// 超出预算时丢弃最早的记录，始终保留最近的一步撤销
+void TileHistory::enforceBudget()
+{
+    while (used > budget && undoEntries.size() > 1) {
+        used -= undoEntries.first().bytes;
+        undoEntries.removeFirst();
+    }
+    // 仍然超出预算时丢弃最远的重做记录
+    while (used > budget && !redoEntries.isEmpty()) {
+        used -= redoEntries.first().bytes;
+        redoEntries.removeFirst();
+    }
+}
+
+// 逐行比较两幅图像在同一区域内的像素
+bool TileHistory::tileEquals(const QImage &a, const QImage &b, const QRect &rect)
+{
+    const int bytesPerPixel = a.depth() / 8;
+    const int offset = rect.x() * bytesPerPixel;
+    const int length = rect.width() * bytesPerPixel;
+    for (int y = rect.top(); y <= rect.bottom(); ++y) {
+        if (std::memcmp(a.constScanLine(y) + offset, b.constScanLine(y) + offset, length) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 比较画布图块与基准图块：共享同一份数据的图块无需比较内容
+bool TileHistory::canvasTileEquals(const TiledCanvas &drawing, int index) const
+{
+    QImage a = baseDrawing.tile(index);
+    QImage b = drawing.tile(index);
+    if (a.isNull() || b.isNull()) return a.isNull() == b.isNull();
+    if (a.constBits() == b.constBits()) return true;
+    if (hashing) return baseDrawing.tileHash(index) == drawing.tileHash(index);
+    return tileEquals(a, b, a.rect());
+}
+
+// 把图块内容逐行拷贝回目标图像
+void TileHistory::writeTile(QImage &target, const QImage &tileImage, const QPoint &pos)
+{
+    QRect rect = QRect(pos, tileImage.size()).intersected(target.rect());
+    if (rect.isEmpty()) return;
+
+    const int bytesPerPixel = target.depth() / 8;
+    for (int y = 0; y < rect.height(); ++y) {
+        std::memcpy(target.scanLine(rect.y() + y) + rect.x() * bytesPerPixel,
+                    tileImage.constScanLine(y),
+                    rect.width() * bytesPerPixel);
+    }
+}
+
+// 图像占用的字节数
+qint64 TileHistory::imageBytes(const QImage &image)
+{
+    return image.sizeInBytes();
+}
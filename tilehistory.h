@@ -0,0 +1,129 @@
+#ifndef TILEHISTORY_H
+#define TILEHISTORY_H
+
+#include <QImage>
+#include <QPoint>
+#include <QVector>
+#include <QSharedPointer>
+#include "historycommand.h"
+#include "tiledcanvas.h"
+
+/**
+ * @brief 基于图块差量的撤销/重做历史
+ *
+ * 每一步历史只保存发生变化的图块(变化前后各一份)，未变化的图块不重复保存。
+ * 历史总大小受字节预算限制，超出预算时丢弃最早的记录。
+ * 撤销/重做时只把记录的图块写回图像，而不是重建整张图像。
+ * 绘制平面是分块画布，变化前后的图块直接与画布共享，未修改的图块不会被复制；
+ * 提交时只检查画布记录的被写过的图块，开销与编辑的大小相关而与画布大小无关。
+ */
+class TileHistory {
+public:
+    /**
+     * @brief 构造函数
+     * @param tileSize 图块边长(像素)
+     * @param byteBudget 历史记录可占用的最大字节数
+     */
+    explicit TileHistory(int tileSize = 128, qint64 byteBudget = 512LL * 1024 * 1024);
+
+    /**
+     * @brief 以当前图像作为初始状态，清空所有历史
+     * @param background 背景平面
+     * @param drawing 绘制平面，其写入记录被清除
+     */
+    void reset(const QImage &background, TiledCanvas &drawing);
+
+    /**
+     * @brief 把当前图像与上一次记录的状态比较，记录变化的图块
+     * @param drawing 绘制平面，只比较其中被写过的图块，提交后清除写入记录
+     * @param command 可选的命令，只用于撤销/重做时同步文档，历史接管其所有权；
+     *                带有命令时即使像素没有变化也会生成记录
+     * @return 生成了新的历史记录时返回true
+     */
+    bool commit(const QImage &background, TiledCanvas &drawing,
+                HistoryCommand *command = nullptr);
+
+    /**
+     * @brief 撤销一步，把变化前的图块写回图像并撤销文档中的形状变化
+     * @return 成功撤销时返回true
+     */
+    bool undo(QImage &background, TiledCanvas &drawing, Scene &scene);
+
+    /**
+     * @brief 重做一步，把变化后的图块写回图像并重新应用文档中的形状变化
+     * @return 成功重做时返回true
+     */
+    bool redo(QImage &background, TiledCanvas &drawing, Scene &scene);
+
+    bool canUndo() const { return !undoEntries.isEmpty(); }  // 是否可以撤销
+    bool canRedo() const { return !redoEntries.isEmpty(); }  // 是否可以重做
+
+    void setByteBudget(qint64 bytes);  // 设置内存预算(字节)
+    qint64 byteBudget() const { return budget; }  // 获取内存预算(字节)
+    qint64 usedBytes() const { return used; }  // 当前历史占用的字节数
+    int tileSize() const { return tile; }  // 背景平面的图块边长
+
+    /**
+     * @brief 设置是否用图块哈希判断内容是否变化
+     *
+     * 开启后被写过但内容与之前相同的图块通过比较哈希排除，基准图块的哈希被缓存，
+     * 只需读取一次当前图块；关闭时逐字节比较两份图块。
+     */
+    void setTileHashing(bool enabled) { hashing = enabled; }
+    bool tileHashing() const { return hashing; }  // 是否用图块哈希判断变化
+
+private:
+    /**
+     * @brief 背景平面中单个图块的变化
+     */
+    struct TilePatch {
+        QPoint pos;     // 图块左上角坐标
+        QImage before;  // 变化前的内容
+        QImage after;   // 变化后的内容
+    };
+
+    /**
+     * @brief 绘制平面中单个图块的变化(与画布共享图块，空图像表示未分配)
+     */
+    struct CanvasPatch {
+        int index;      // 图块下标
+        QImage before;  // 变化前的图块
+        QImage after;   // 变化后的图块
+    };
+
+    /**
+     * @brief 一步历史记录
+     */
+    struct Entry {
+        QVector<TilePatch> tiles;            // 背景平面变化的图块
+        QVector<CanvasPatch> canvasTiles;    // 绘制平面变化的图块
+        bool backgroundReplaced;             // 背景尺寸变化时整体替换
+        QImage backgroundBefore;             // 整体替换前的背景
+        QImage backgroundAfter;              // 整体替换后的背景
+        bool drawingReplaced;                // 画布尺寸变化时整体替换
+        TiledCanvas drawingBefore;           // 整体替换前的画布
+        TiledCanvas drawingAfter;            // 整体替换后的画布
+        QSharedPointer<HistoryCommand> command;  // 对应的命令(用于同步文档)
+        qint64 bytes;                        // 本记录占用的字节数
+    };
+
+    void diffBackground(const QImage &background, Entry &entry);  // 记录背景平面的变化
+    void diffDrawing(TiledCanvas &drawing, Entry &entry);  // 记录绘制平面的变化
+    void apply(const Entry &entry, bool forward, QImage &background, TiledCanvas &drawing);  // 把记录应用到图像
+    void enforceBudget();  // 按预算丢弃最早的记录
+    static bool tileEquals(const QImage &a, const QImage &b, const QRect &rect);  // 比较两图像的同一区域
+    bool canvasTileEquals(const TiledCanvas &drawing, int index) const;  // 比较画布图块与基准图块
+    static void writeTile(QImage &target, const QImage &tileImage, const QPoint &pos);  // 把图块写回图像
+    static qint64 imageBytes(const QImage &image);  // 图像占用的字节数
+
+    int tile;  // 图块边长
+    qint64 budget;  // 内存预算
+    qint64 used;  // 已用字节数
+    bool hashing;  // 是否用图块哈希判断变化
+    QImage baseBackground;  // 上一次记录时的背景平面(与背景共享数据)
+    TiledCanvas baseDrawing;  // 上一次记录时的绘制平面(与画布共享图块)
+    QVector<Entry> undoEntries;  // 撤销记录(末尾为最新)
+    QVector<Entry> redoEntries;  // 重做记录(末尾为最近撤销的)
+};
+
+#endif // TILEHISTORY_H
@@ -0,0 +1,104 @@
+#include "vectorexporter.h"
+#include "imagesaver.h"
+#include <QFileInfo>
+#include <QPageSize>
+#include <QPainter>
+#include <QPdfWriter>
+#include <QSaveFile>
+#include <QSvgGenerator>
+#include <memory>
+
+namespace {
+
+const int ScreenDpi = 96;  // 画布像素对应的分辨率，决定PDF页面的物理尺寸
+
+} // namespace
+
+// 是否为矢量格式
+bool VectorExporter::isVectorFormat(const QByteArray &format)
+{
+    return format == "svg" || format == "pdf";
+}
+
+// 导出为SVG或PDF
+QString VectorExporter::write(const QString &fileName, const QSize &canvasSize, const QImage &background,
+                              const QVector<Scene::Item> &shapes,
+                              const QVector<LayerStack::Layer> &layers, const Progress &progress)
+{
+    if (canvasSize.isEmpty()) return QString("画布为空");
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return QString("无法写入文件: %1").arg(file.errorString());
+    }
+
+    // 1. 按格式创建绘制设备，设备坐标与画布坐标一一对应
+    QString title = QFileInfo(fileName).completeBaseName();
+    std::unique_ptr<QPaintDevice> device;
+    if (ImageSaver::formatForFile(fileName) == "svg") {
+        QSvgGenerator *svg = new QSvgGenerator;
+        svg->setOutputDevice(&file);
+        svg->setSize(canvasSize);
+        svg->setViewBox(QRect(QPoint(0, 0), canvasSize));
+        svg->setResolution(ScreenDpi);
+        svg->setTitle(title);
+        device.reset(svg);
+    } else {
+        QPdfWriter *pdf = new QPdfWriter(&file);
+        pdf->setResolution(ScreenDpi);
+        pdf->setPageSize(QPageSize(QSizeF(canvasSize) * 72.0 / ScreenDpi, QPageSize::Point));
+        pdf->setPageMargins(QMarginsF(0, 0, 0, 0));
+        pdf->setTitle(title);
+        device.reset(pdf);
+    }
+
+    QPainter painter;
+    if (!painter.begin(device.get())) {
+        file.cancelWriting();
+        return QString("无法创建%1文件").arg(QString(ImageSaver::formatForFile(fileName)).toUpper());
+    }
+    // 页面尺寸换算成点后可能有舍入，按实际设备尺寸缩放
+    painter.scale(double(device->width()) / canvasSize.width(),
+                  double(device->height()) / canvasSize.height());
+    painter.setClipRect(QRect(QPoint(0, 0), canvasSize));
+
+    // 2. 背景只嵌入一次，形状按绘制顺序重放draw()，输出为路径；其他图层在绘制层的上下嵌入
+    if (!background.isNull()) {
+        painter.drawImage(0, 0, background);
+    }
+    QVector<LayerStack::Layer> stack = layers;
+    if (stack.isEmpty()) {
+        LayerStack::Layer document;
+        document.document = true;
+        stack.append(document);
+    }
+    const QRect canvas(QPoint(0, 0), canvasSize);
+    for (const LayerStack::Layer &layer : stack) {
+        if (!layer.visible) continue;
+        if (!layer.document) {
+            LayerStack::drawCanvas(painter, layer.canvas, canvas, layer.opacity, layer.mode);
+            continue;
+        }
+
+        painter.save();
+        painter.setOpacity(layer.opacity);
+        painter.setCompositionMode(layer.mode);
+        for (int i = 0; i < shapes.size(); ++i) {
+            shapes[i].second->draw(painter);
+            if (progress && !progress(i + 1, shapes.size())) {
+                painter.end();
+                file.cancelWriting();
+                return QString("导出已取消");
+            }
+        }
+        painter.restore();
+    }
+
+    // 3. 结束绘制时设备才写出文件尾，之后才能提交
+    painter.end();
+    device.reset();
+    if (!file.commit()) {
+        return QString("无法写入文件: %1").arg(file.errorString());
+    }
+    return QString();
+}
@@ -0,0 +1,45 @@
+#ifndef VECTOREXPORTER_H
+#define VECTOREXPORTER_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QSize>
+#include <QString>
+#include <QVector>
+#include <functional>
+#include "layerstack.h"
+#include "scene.h"
+
+/**
+ * @brief 矢量导出：把文档中的形状按绘制顺序重放到SVG或PDF绘制设备上
+ *
+ * 背景图像只嵌入一次，形状以路径输出，与分辨率无关，
+ * 输出大小和耗时只取决于形状数量而不是像素数。导入的栅格图层按顺序嵌入已分配的图块。
+ */
+class VectorExporter {
+public:
+    /**
+     * @brief 导出进度回调
+     * @return 返回false时取消导出
+     */
+    typedef std::function<bool(int done, int total)> Progress;
+
+    static bool isVectorFormat(const QByteArray &format);  // 是否为矢量格式("svg"或"pdf")
+
+    /**
+     * @brief 导出为SVG或PDF，格式由扩展名决定；先写入临时文件，成功后才替换目标文件
+     * @param fileName 目标文件名
+     * @param canvasSize 画布尺寸(SVG的视图框、PDF的页面大小)
+     * @param background 背景图像(可以为空)
+     * @param shapes 按绘制顺序排列的形状
+     * @param layers 图层栈中的所有图层(为空时只有绘制层)，形状按绘制层的位置和属性输出
+     * @param progress 可选的进度回调
+     * @return 错误信息，成功时为空
+     */
+    static QString write(const QString &fileName, const QSize &canvasSize, const QImage &background,
+                         const QVector<Scene::Item> &shapes,
+                         const QVector<LayerStack::Layer> &layers = QVector<LayerStack::Layer>(),
+                         const Progress &progress = Progress());
+};
+
+#endif // VECTOREXPORTER_H